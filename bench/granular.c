@@ -0,0 +1,66 @@
+#include "pair_potential.h"
+#include "scene.h"
+#include "body.h"
+#include "list.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Diameter of each grain, which is also the cutoff of the repulsion
+const double GRAIN_DIAMETER = 1;
+// Distance between neighboring grains on the starting grid
+const double GRAIN_SPACING = 0.95;
+// Hooke's constant of the repulsion between grains
+const double GRAIN_K = 1000;
+// Skin distance of the neighbor lists
+const double GRAIN_SKIN = 0.3;
+const double GRAIN_DT = 1e-3;
+// Number of ticks to time for each number of grains
+const int TIMED_STEPS = 20;
+// Numbers of grains to time, as the side of a square grid
+const size_t SIDES[] = {32, 100, 316};
+
+list_t *make_grain_shape() {
+  list_t *shape = list_init(4, free);
+  double r = GRAIN_DIAMETER / 2;
+  double corners[4][2] = {{-r, -r}, {r, -r}, {r, r}, {-r, r}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {corners[i][0], corners[i][1]};
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+int main() {
+  srand(1);
+  printf("Soft repulsion between a square of slightly overlapping grains\n");
+  printf("%10s %12s %14s %14s\n", "grains", "pairs", "us/tick", "ns/grain");
+  for (size_t s = 0; s < sizeof(SIDES) / sizeof(SIDES[0]); s++) {
+    size_t n = SIDES[s] * SIDES[s];
+    scene_t *scene = scene_init();
+    list_t *grains = list_init(n, NULL);
+    for (size_t i = 0; i < n; i++) {
+      body_t *grain = body_init(make_grain_shape(), 1, (rgb_color_t) {0, 0, 0});
+      body_set_centroid(grain, (vector_t) {
+        (i % SIDES[s]) * GRAIN_SPACING, (i / SIDES[s]) * GRAIN_SPACING
+      });
+      body_set_velocity(grain, (vector_t) {
+        (double) rand() / RAND_MAX - 0.5, (double) rand() / RAND_MAX - 0.5
+      });
+      scene_add_body(scene, grain);
+      list_add(grains, grain);
+    }
+    pair_potential_t *potential = create_soft_repulsion(scene, grains, \
+      GRAIN_K, GRAIN_DIAMETER, GRAIN_SKIN);
+    clock_t start = clock();
+    for (int step = 0; step < TIMED_STEPS; step++) {
+      scene_tick(scene, GRAIN_DT);
+    }
+    double elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+    printf("%10zu %12zu %14.1f %14.1f\n", n, \
+      pair_potential_pairs(potential), 1e6 * elapsed / TIMED_STEPS, \
+      1e9 * elapsed / TIMED_STEPS / n);
+    scene_free(scene);
+  }
+}
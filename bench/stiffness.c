@@ -0,0 +1,131 @@
+#include "spring_network.h"
+#include "scene.h"
+#include "body.h"
+#include "list.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Number of bodies in the chain, including the anchor
+const size_t CHAIN_LENGTH = 20;
+// Mass of each body in the chain
+const double CHAIN_MASS = 1;
+// Rest length of each spring in the chain
+const double REST_LENGTH = 1;
+// How far the chain starts stretched past its rest length, as a ratio
+const double START_STRETCH = 1.1;
+// Number of ticks a time step must stay stable for
+const int STABLE_STEPS = 1000;
+// Range of time steps to search for the largest stable one
+const double MIN_DT = 1e-6;
+const double MAX_DT = 1.0 / 30;
+// Number of bisection steps when searching for the largest stable time step
+const int BISECTIONS = 20;
+// Hooke's constants to measure, as powers of 10
+const int MIN_K_EXPONENT = 1;
+const int MAX_K_EXPONENT = 7;
+
+list_t *make_square() {
+  list_t *shape = list_init(4, free);
+  double corners[4][2] = {{-0.1, -0.1}, {0.1, -0.1}, {0.1, 0.1}, {-0.1, 0.1}};
+  for (size_t i = 0; i < 4; i++) {
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {corners[i][0], corners[i][1]};
+    list_add(shape, v);
+  }
+  return shape;
+}
+
+/**
+ * Makes a scene with a stretched chain of springs hanging off an anchor.
+ */
+scene_t *make_chain(double k, bool implicit) {
+  scene_t *scene = scene_init();
+  list_t *bodies = list_init(CHAIN_LENGTH, NULL);
+  for (size_t i = 0; i < CHAIN_LENGTH; i++) {
+    double mass = i == 0 ? INFINITY : CHAIN_MASS;
+    body_t *body = body_init(make_square(), mass, (rgb_color_t) {0, 0, 0});
+    body_set_centroid(body, (vector_t) {i * REST_LENGTH * START_STRETCH, 0});
+    scene_add_body(scene, body);
+    list_add(bodies, body);
+  }
+  spring_network_t *network = create_spring_network(scene, bodies);
+  for (size_t i = 0; i + 1 < CHAIN_LENGTH; i++) {
+    spring_network_add(network, i, i + 1, k, REST_LENGTH, 0);
+  }
+  spring_network_set_implicit(network, implicit);
+  return scene;
+}
+
+/**
+ * Checks whether the chain stays near its starting extent for STABLE_STEPS.
+ */
+bool is_stable(double k, bool implicit, double dt) {
+  scene_t *scene = make_chain(k, implicit);
+  double limit = 2 * CHAIN_LENGTH * REST_LENGTH * START_STRETCH;
+  bool stable = true;
+  for (int step = 0; step < STABLE_STEPS && stable; step++) {
+    scene_tick(scene, dt);
+    for (size_t i = 0; i < CHAIN_LENGTH; i++) {
+      vector_t centroid = body_get_centroid(scene_get_body(scene, i));
+      if (!(fabs(centroid.x) < limit && fabs(centroid.y) < limit)) {
+        stable = false;
+        break;
+      }
+    }
+  }
+  scene_free(scene);
+  return stable;
+}
+
+/**
+ * Finds the largest stable time step by bisecting in log space.
+ */
+double max_stable_dt(double k, bool implicit) {
+  if (is_stable(k, implicit, MAX_DT)) {
+    return MAX_DT;
+  }
+  double low = log(MIN_DT);
+  double high = log(MAX_DT);
+  for (int i = 0; i < BISECTIONS; i++) {
+    double mid = (low + high) / 2;
+    if (is_stable(k, implicit, exp(mid))) {
+      low = mid;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return exp(low);
+}
+
+/**
+ * Measures the average wall-clock time of one tick at the given time step.
+ */
+double seconds_per_tick(double k, bool implicit, double dt) {
+  scene_t *scene = make_chain(k, implicit);
+  clock_t start = clock();
+  for (int step = 0; step < STABLE_STEPS; step++) {
+    scene_tick(scene, dt);
+  }
+  double elapsed = (double) (clock() - start) / CLOCKS_PER_SEC;
+  scene_free(scene);
+  return elapsed / STABLE_STEPS;
+}
+
+int main() {
+  printf("Largest stable dt for a chain of %zu springs (capped at %g)\n", \
+    CHAIN_LENGTH - 1, MAX_DT);
+  printf("%10s %14s %14s %16s %16s\n", "k", "explicit dt", "implicit dt", \
+    "explicit us/tick", "implicit us/tick");
+  for (int e = MIN_K_EXPONENT; e <= MAX_K_EXPONENT; e++) {
+    double k = pow(10, e);
+    double explicit_dt = max_stable_dt(k, false);
+    double implicit_dt = max_stable_dt(k, true);
+    printf("%10g %14.3e %14.3e %16.2f %16.2f\n", k, explicit_dt, implicit_dt, \
+      1e6 * seconds_per_tick(k, false, explicit_dt), \
+      1e6 * seconds_per_tick(k, true, implicit_dt));
+  }
+}
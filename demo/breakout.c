@@ -9,6 +9,7 @@
 #include <math.h>
 #include "forces.h"
 #include "collision.h"
+#include "trace.h"
 
 const double HEIGHT = 1000.0;
 const double WIDTH = 1000.0;
@@ -30,6 +31,8 @@ const vector_t BALL_POS_RANGE = {200.0, 300.0};
 const double ELASTICITY = 1.0;
 const double BALL_DELAY = 10.0;
 const double WALL_THICKNESS = 50.0;
+// Most bodies to check for a ball hitting in one frame
+#define NEARBY_BODIES 16
 
 /**
  * Returns a list of rgb_color_t pointers in rainbow order
@@ -195,35 +198,14 @@ void add_collisions(body_t *ball, scene_t *scene) {
 }
 
 /**
- * Prevents paddle from going offscreen
+ * Records that a ball has left the screen, so the game is reset
  *
- * @param paddle body representing the paddle
+ * @param scene the scene containing the game
+ * @param ball the ball that left the screen
+ * @param lost set to true
  */
-void bound(body_t *paddle) {
-    vector_t curr_pos = body_get_centroid(paddle);
-    if (curr_pos.x + PADDLE_W / 2 > WIDTH) {
-        body_set_centroid(paddle, (vector_t) {WIDTH - PADDLE_W / 2, curr_pos.y});
-    }
-    else if (curr_pos.x - PADDLE_W / 2 < 0) {
-        body_set_centroid(paddle, (vector_t) {PADDLE_W / 2, curr_pos.y});
-    }
-}
-
-/**
- * Returns true if the body is offscreen
- *
- * @param body the body to check
- */
-bool is_offscreen(body_t *body) {
-    list_t *pts = body_get_shape(body);
-    bool ans = true;
-    for (size_t i = 0; i < list_size(pts); i++) {
-        vector_t *p = (vector_t*) list_get(pts, i);
-        if (p->x >= 0 && p->x <= WIDTH && p->y >=0 && p->y <= HEIGHT) {
-            ans = false;
-        }
-    }
-    return ans;
+void ball_lost(scene_t *scene, body_t *ball, void *lost) {
+    *(bool *) lost = true;
 }
 
 /**
@@ -236,6 +218,7 @@ void add_ball(scene_t *scene, list_t *b_list) {
     body_t *ball = init_circle(BALL_R, BALL_POS_RANGE);
     body_set_velocity(ball, generate_vector(BALL_V_RANGE));
     body_set_centroid(ball, generate_vector(BALL_POS_RANGE));
+    body_set_bounds_policy(ball, BOUNDS_CALLBACK);
     list_add(b_list, ball);
     scene_add_body(scene, ball);
     add_collisions(ball, scene);
@@ -264,15 +247,31 @@ void reset_game(scene_t *scene, body_t *paddle, list_t *b_list) {
  * @param ball body representing the ball
  */
 void check_block_collision(scene_t *scene, body_t *ball) {
-    for (size_t i = 0; i < scene_bodies(scene); i++) {
-        body_t *body = scene_get_body(scene, i);
+    body_t *nearby[NEARBY_BODIES];
+    size_t found = scene_query_aabb(scene, body_get_bounds(ball), nearby,
+      NEARBY_BODIES);
+    // Any blocks that didn't fit are hit on the next frame
+    if (found > NEARBY_BODIES) {
+        found = NEARBY_BODIES;
+    }
+    list_t *ball_shape = NULL;
+    for (size_t i = 0; i < found; i++) {
+        body_t *body = nearby[i];
         if (*(char *)body_get_info(body) == 'b') {
-            if (find_collision(body_get_shape(body),
-              body_get_shape(ball)).collided) {
+            // The ball's shape is only copied if a block is nearby
+            if (ball_shape == NULL) {
+                ball_shape = body_get_shape(ball);
+            }
+            list_t *block_shape = body_get_shape(body);
+            if (find_collision(block_shape, ball_shape).collided) {
                 body_remove(body);
             }
+            list_free(block_shape);
         }
     }
+    if (ball_shape != NULL) {
+        list_free(ball_shape);
+    }
  }
 
 /**
@@ -288,17 +287,14 @@ void check_all_collisions(scene_t *scene, list_t *b_list) {
 }
 
 /**
- * Returns whether any balls are offscreen
+ * Checks whether a body is anything other than the paddle
  *
- * @param b_list list of pointers to balls
+ * @param body a body in the scene
+ * @param aux unused
+ * @return whether the body should be cleared from the scene
  */
-bool any_ball_offscreen(list_t *b_list) {
-  for (size_t j = 0; j < list_size(b_list); j++) {
-     if (is_offscreen(list_get(b_list, j))) {
-        return true;
-     }
-  }
-  return false;
+bool is_not_paddle(body_t *body, void *aux) {
+    return *(char *)body_get_info(body) != 'p';
 }
 
 /**
@@ -308,16 +304,8 @@ bool any_ball_offscreen(list_t *b_list) {
  * @param b_list list of pointers to balls
  */
 void scene_clear(scene_t *scene, list_t *b_list) {
-    for (size_t j = 0; j < scene_bodies(scene); j++) {
-        body_t *body = scene_get_body(scene, j);
-        if (*(char *)body_get_info(body) != 'p') {
-            body_remove(body);
-        }
-    }
-    for (int i = (int) list_size(b_list) - 1; i >= 0; i--) {
-        list_remove(b_list, i);
-    }
-    scene_tick(scene, 0);
+    scene_remove_if(scene, is_not_paddle, NULL);
+    list_truncate(b_list, 0);
 }
 
 /**
@@ -380,13 +368,17 @@ int main(int argc, char *argv[]) {
     vector_t max = {WIDTH, HEIGHT};
     sdl_init(min, max);
     scene_t *scene = scene_init();
+    bool lost = false;
+    scene_set_bounds(scene, (aabb_t) {min, max}, ball_lost, &lost);
     list_t *ball_list = list_init(5, (free_func_t) body_free);
     body_t *paddle = init_rectangle(PADDLE_W, PADDLE_H, START_POS, 'p');
+    body_set_bounds_policy(paddle, BOUNDS_CLAMP);
     scene_add_body(scene, paddle);
     reset_game(scene, paddle, ball_list);
     sdl_on_key((key_handler_t) on_key, paddle, scene);
     double total_time_elapsed = 0.0;
     while (!sdl_is_done()) {
+        TRACE_BEGIN("frame");
         double time_elapsed = time_since_last_tick();
         total_time_elapsed += time_elapsed;
         if (total_time_elapsed > BALL_DELAY) {
@@ -395,14 +387,16 @@ int main(int argc, char *argv[]) {
         }
         check_all_collisions(scene, ball_list);
         scene_tick(scene, time_elapsed);
-        if (any_ball_offscreen(ball_list)) {
+        if (lost) {
+            lost = false;
             total_time_elapsed = 0.0;
             scene_clear(scene, ball_list);
             reset_game(scene, paddle, ball_list);
         }
-        bound(paddle);
         sdl_render_scene(scene);
+        TRACE_END("frame");
     }
+    TRACE_WRITE("trace.json");
     free(ball_list);
     scene_free(scene);
     return 0;
@@ -9,6 +9,8 @@
 #include <math.h>
 #include <assert.h>
 #include "forces.h"
+#include "spring_network.h"
+#include "trace.h"
 #include <float.h>
 
 const double W_HEIGHT = 500.0;
@@ -23,6 +25,8 @@ const int CIRCLE_FRAC = 24;
 const double SIN_AMP = 100.0;
 const double CIRCLE_MASS = 10.0;
 const double ANCHOR_R = 0.01;
+const double FIXED_DT = 1.0 / 120;
+const size_t MAX_SUBSTEPS = 8;
 
 /**
  * Initializes a body with a circle shape
@@ -62,13 +66,19 @@ void put_circles(scene_t *scene){
 }
 
 /**
- * Applies a spring force between each circle and its anchor
+ * Applies a spring force between each circle and its anchor,
+ * as a single spring network over every body in the scene
  *
  * @param scene the scene to add forces to
  */
 void apply_spring(scene_t *scene){
+  list_t *bodies = list_init(scene_bodies(scene), NULL);
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    list_add(bodies, scene_get_body(scene, i));
+  }
+  spring_network_t *network = create_spring_network(scene, bodies);
   for (size_t i = 0; i < scene_bodies(scene) - 1; i += 2 ) {
-      create_spring(scene, K_CONSTANT, scene_get_body(scene, i), scene_get_body(scene,(i + 1)));
+      spring_network_add(network, i, i + 1, K_CONSTANT, 0, 0);
   }
 }
 
@@ -78,9 +88,7 @@ void apply_spring(scene_t *scene){
  * @param scene the scene to apply the forces to
  */
 void apply_drag(scene_t *scene){
-  for (size_t i = 0; i < scene_bodies(scene); i++) {
-    create_drag(scene, GAMMA, scene_get_body(scene, i));
-  }
+  scene_set_drag(scene, GAMMA);
 }
 
 /**
@@ -103,9 +111,12 @@ int main(int argc, char *argv[]){
   apply_spring(scene);
   apply_drag(scene);
   while(!sdl_is_done(scene_get_body(scene, 0))){
+    TRACE_BEGIN("frame");
     double time_elapsed = time_since_last_tick();
-    scene_tick(scene, time_elapsed);
-    sdl_render_scene(scene);
+    scene_step_fixed(scene, time_elapsed, FIXED_DT, MAX_SUBSTEPS);
+    sdl_render_scene_interpolated(scene, scene_get_alpha(scene));
+    TRACE_END("frame");
   }
+  TRACE_WRITE("trace.json");
   return 0;
 }
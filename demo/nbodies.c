@@ -11,6 +11,7 @@
 #include <assert.h>
 #include "color.h"
 #include "forces.h"
+#include "trace.h"
 
 const double WIN_HEIGHT = 500.0;
 const double WIN_WIDTH = 1000.0;
@@ -23,6 +24,8 @@ const int M_CORR = 100;
 const int V_SEED = 50;
 const int R_C = 1;
 const int MASS_MIN = 600;
+const double FIXED_DT = 1.0 / 120;
+const size_t MAX_SUBSTEPS = 8;
 
 /**
  * Applies a gravitational force between all bodies in the scene
@@ -80,10 +83,13 @@ int main(int argc, char *argv[]) {
   build_scene(scene);
   apply_force_all(scene);
   while(!sdl_is_done(scene_get_body(scene, 0))){
+    TRACE_BEGIN("frame");
     double time_elapsed = time_since_last_tick();
-    scene_tick(scene, time_elapsed);
-    sdl_render_scene(scene);
+    scene_step_fixed(scene, time_elapsed, FIXED_DT, MAX_SUBSTEPS);
+    sdl_render_scene_interpolated(scene, scene_get_alpha(scene));
+    TRACE_END("frame");
   }
+  TRACE_WRITE("trace.json");
   scene_free(scene);
   return 0;
 }
@@ -6,6 +6,7 @@
 #include "polygon.h"
 #include "scene.h"
 #include "sdl_wrapper.h"
+#include "trace.h"
 
 #define CIRCLE_POINTS 40
 
@@ -20,6 +21,8 @@
 #define PEG_RADIUS 0.5
 #define BALL_RADIUS 1.0
 #define DROP_INTERVAL 1.0 // s
+#define FIXED_DT (1.0 / 120) // s
+#define MAX_SUBSTEPS 8
 #define PEG_ELASTICITY 0.3
 #define BALL_ELASTICITY 0.7
 #define WALL_WIDTH 1.0
@@ -257,6 +260,7 @@ int main(void) {
     // Repeatedly render scene
     double time_since_drop = INFINITY;
     while (!sdl_is_done()) {
+        TRACE_BEGIN("frame");
         double dt = time_since_last_tick();
 
         // Add a new ball every DROP_INTERVAL seconds
@@ -266,9 +270,11 @@ int main(void) {
             time_since_drop = 0.0;
         }
 
-        scene_tick(scene, dt);
-        sdl_render_scene(scene);
+        scene_step_fixed(scene, dt, FIXED_DT, MAX_SUBSTEPS);
+        sdl_render_scene_interpolated(scene, scene_get_alpha(scene));
+        TRACE_END("frame");
     }
+    TRACE_WRITE("trace.json");
 
     // Clean up scene
     scene_free(scene);
@@ -9,6 +9,7 @@
 #include <math.h>
 #include <assert.h>
 #include "forces.h"
+#include "trace.h"
 
 const double HEIGHT = 1000.0;
 const double WIDTH = 1000.0;
@@ -113,6 +114,7 @@ body_t *init_projectile(double w, double h, vector_t centroid) {
     body_t *toReturn = body_init_with_info(points, MASS, \
       (rgb_color_t) {1, 1, 0}, status, free);
     body_set_centroid(toReturn, centroid);
+    body_set_bounds_policy(toReturn, BOUNDS_REMOVE);
     return toReturn;
 }
 
@@ -164,21 +166,6 @@ void shoot_projectile(scene_t *scene, body_t *obj) {
     }
 }
 
-/**
- * Prevents player from going offscreen
- *
- * @param player body representing the player
- */
-void bound(body_t *player) {
-    vector_t curr_pos = body_get_centroid(player);
-    if (curr_pos.x + PLAYER_X_RAD > WIDTH) {
-        body_set_centroid(player, (vector_t) {WIDTH - PLAYER_X_RAD, curr_pos.y});
-    }
-    else if (curr_pos.x - PLAYER_X_RAD < 0) {
-        body_set_centroid(player, (vector_t) {PLAYER_X_RAD, curr_pos.y});
-    }
-}
-
 /**
  * Moves enemy to the next row if it moves offscreen
  *
@@ -199,24 +186,8 @@ void wrap_enemy(body_t *enemy) {
 }
 
 /**
- * Returns true if the body is offscreen
- *
- * @param body the body to check
- */
-bool is_offscreen(body_t *body) {
-    list_t *pts = body_get_shape(body);
-    bool ans = true;
-    for (size_t i = 0; i < list_size(pts); i++) {
-        vector_t *p = (vector_t*) list_get(pts, i);
-        if (p->x >= 0 && p->x <= WIDTH && p->y >=0 && p->y <= HEIGHT) {
-            ans = false;
-        }
-    }
-    return ans;
-}
-
-/**
- * Updates edge behavior of enemies and player
+ * Updates edge behavior of enemies. The player and projectiles are kept
+ * on screen by the scene's bounds.
  *
  * @param scene the scene containing the bodies to update
  */
@@ -226,14 +197,6 @@ void update_edge(scene_t *scene) {
         if (*(char*)(body_get_info(b)) == 'e') {
             wrap_enemy(b);
         }
-        else if (*(char*)(body_get_info(b)) == 'p') {
-            bound(b);
-        }
-        else {
-            if (is_offscreen(b)) {
-                body_remove(b);
-            }
-        }
     }
 }
 
@@ -331,12 +294,15 @@ int main(int argc, char *argv[]) {
     vector_t max = {WIDTH, HEIGHT};
     sdl_init(min, max);
     scene_t *scene = scene_init();
+    scene_set_bounds(scene, (aabb_t) {min, max}, NULL, NULL);
     body_t *player = init_oval(PLAYER_Y_RAD, PLAYER_X_RAD, START_POS);
+    body_set_bounds_policy(player, BOUNDS_CLAMP);
     scene_add_body(scene, player);
     init_enemies(scene);
     double total_time_elapsed = 0.0;
     sdl_on_key((key_handler_t) on_key, player, scene);
     while (!sdl_is_done()) {
+        TRACE_BEGIN("frame");
         double time_elapsed = time_since_last_tick();
         total_time_elapsed += time_elapsed;
         if (total_time_elapsed > SHOOT_DELAY) {
@@ -349,7 +315,9 @@ int main(int argc, char *argv[]) {
         update_edge(scene);
         scene_tick(scene, time_elapsed);
         sdl_render_scene(scene);
+        TRACE_END("frame");
     }
+    TRACE_WRITE("trace.json");
     scene_free(scene);
     return 0;
 }
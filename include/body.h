@@ -1,11 +1,48 @@
 #ifndef __BODY_H__
 #define __BODY_H__
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include "color.h"
 #include "list.h"
+#include "polygon.h"
 #include "vector.h"
 
+/**
+ * A reference from a body to a force in its scene that acts on it.
+ * The kind is a force_kind_t for built-in forces, or NUM_FORCE_KINDS
+ * for force creators, and the index locates the force among those
+ * of its kind. See scene.h.
+ */
+typedef struct force_ref {
+  int kind;
+  size_t index;
+  // Which of the force's bodies the body is: its position in a force
+  // creator's list of bodies, which may list it more than once,
+  // or 0 for a built-in force's body1 and 1 for its body2
+  size_t position;
+} force_ref_t;
+
+/**
+ * What a scene does with a body that leaves its world bounds
+ * (see scene_set_bounds()).
+ */
+typedef enum {
+  // The body may leave the bounds (the default)
+  BOUNDS_IGNORE,
+  // The body is removed once it is entirely outside the bounds
+  BOUNDS_REMOVE,
+  // The body is pushed back entirely inside the bounds,
+  // losing its velocity out of them
+  BOUNDS_CLAMP,
+  // Once the body is entirely past one edge of the bounds,
+  // it is moved to come back in through the opposite edge
+  BOUNDS_WRAP,
+  // The scene's bounds handler is called on the body
+  // after each tick it ends entirely outside the bounds
+  BOUNDS_CALLBACK
+} bounds_policy_t;
+
 /**
  * A rigid body constrained to the plane.
  * Implemented as a polygon with uniform density.
@@ -14,16 +51,33 @@
  */
  typedef struct body {
    list_t *shape;
+   // Number of forked bodies sharing the shape, or NULL if only this body
+   // uses it. A shared shape is copied before the body moves it.
+   atomic_size_t *shape_owners;
    double mass;
    rgb_color_t color;
    vector_t centroid;
    vector_t velocity;
    double orientation;
+   // Pose at the start of the last fixed step, for interpolation
+   vector_t prev_centroid;
+   double prev_orientation;
    vector_t force;
    vector_t impulse;
    void *info;
    free_func_t info_freer;
    int forRemoval;
+   // Reverse index of the forces acting on the body, maintained by its scene
+   force_ref_t *force_refs;
+   size_t force_ref_count;
+   size_t force_ref_capacity;
+   // If non-NULL, the body is added to this list when it is removed
+   list_t *graveyard;
+   // The body's slot in its scene's map of handles (see scene_get_handle())
+   size_t slot;
+   // Bounding box of the shape, kept up to date as the body moves
+   aabb_t bounds;
+   bounds_policy_t bounds_policy;
  } body_t;
 
 /**
@@ -60,6 +114,30 @@ body_t *body_init_with_info(
  */
 void body_free(body_t *body);
 
+/**
+ * Allocates a copy of a body, e.g. for a forked scene (see scene_fork()).
+ * The copy shares the body's vertices until either body moves,
+ * so bodies that never move, like walls, are never copied.
+ * It borrows the body's info, which it doesn't free, so it must be freed
+ * before the body is, and isn't in a scene or marked for removal
+ * by anything else.
+ * Bodies sharing vertices may be ticked on different threads,
+ * but must be copied one at a time.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return a pointer to the newly allocated copy
+ */
+body_t *body_fork(body_t *body);
+
+/**
+ * Makes sure no other body shares a body's vertices,
+ * so they can be written to in place.
+ * Called by the functions that move a body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_unshare_shape(body_t *body);
+
 /**
  * Gets the current shape of a body.
  * Returns a newly allocated vector list, which must be list_free()d.
@@ -136,6 +214,24 @@ vector_t body_get_force(body_t *body);
  */
 void *body_get_info(body_t *body);
 
+/**
+ * Gets the smallest axis-aligned box containing a body's shape.
+ * Unlike computing it from body_get_shape(), this copies nothing,
+ * since the box is moved along with the body.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the body's bounding box
+ */
+aabb_t body_get_bounds(body_t *body);
+
+/**
+ * Gets what a scene does with a body that leaves its world bounds.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @return the policy set by body_set_bounds_policy(), or BOUNDS_IGNORE
+ */
+bounds_policy_t body_get_bounds_policy(body_t *body);
+
 /**
  * Translates a body to a new position.
  * The position is specified by the position of the body's center of mass.
@@ -169,6 +265,15 @@ void body_set_color(body_t *body, rgb_color_t c);
  */
 void body_set_mass(body_t *body, double mass);
 
+/**
+ * Changes what a scene does with a body that leaves its world bounds.
+ * The policy only applies in a scene with bounds (see scene_set_bounds()).
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param policy the body's new policy
+ */
+void body_set_bounds_policy(body_t *body, bounds_policy_t policy);
+
 /**
  * Changes a body's orientation in the plane.
  * The body is rotated about its center of mass.
@@ -214,9 +319,87 @@ void body_add_impulse(body_t *body, vector_t impulse);
  */
 void body_tick(body_t *body, double dt);
 
+/**
+ * Updates the body after a given time interval has elapsed,
+ * while it is slowed by a linear drag force -gamma * velocity.
+ * The drag is integrated exactly as exponential decay of the velocity
+ * towards the terminal velocity of the accumulated force,
+ * so it stays stable for any gamma and dt.
+ * With gamma = 0 this is equivalent to body_tick().
+ *
+ * @param body the body to tick
+ * @param dt the number of seconds elapsed since the last tick
+ * @param gamma the drag coefficient (higher gamma means more drag)
+ */
+void body_tick_with_drag(body_t *body, double dt, double gamma);
+
+/**
+ * Records a body's current position and orientation as its previous pose,
+ * which its interpolated pose starts from.
+ * scene_step_fixed() calls this before every step. Call it after teleporting
+ * a body to stop it from being drawn sweeping across the screen.
+ *
+ * @param body a pointer to a body returned from body_init()
+ */
+void body_save_pose(body_t *body);
+
+/**
+ * Gets a body's centroid part of the way between its previous pose
+ * (see body_save_pose()) and its current pose.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param alpha how far to interpolate, from 0 (previous) to 1 (current)
+ * @return the interpolated centroid
+ */
+vector_t body_get_interpolated_centroid(body_t *body, double alpha);
+
+/**
+ * Gets a body's orientation part of the way between its previous pose
+ * (see body_save_pose()) and its current pose.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param alpha how far to interpolate, from 0 (previous) to 1 (current)
+ * @return the interpolated orientation, in radians
+ */
+double body_get_interpolated_orientation(body_t *body, double alpha);
+
+/**
+ * Gets the shape of a body in its interpolated pose,
+ * i.e. rotated and translated from its current pose to
+ * body_get_interpolated_orientation() and body_get_interpolated_centroid().
+ * Like body_get_shape(), this returns a newly allocated list.
+ *
+ * @param body a pointer to a body returned from body_init()
+ * @param alpha how far to interpolate, from 0 (previous) to 1 (current)
+ * @return the polygon describing the body's interpolated shape
+ */
+list_t *body_get_interpolated_shape(body_t *body, double alpha);
+
+/**
+ * Records that a force acts on a body, in the body's reverse index of forces.
+ *
+ * @param body the body the force acts on
+ * @param ref the location of the force in the body's scene
+ * @return the slot of the reference in the body's index,
+ *   valid until body_remove_force_ref() is called on the body
+ */
+size_t body_add_force_ref(body_t *body, force_ref_t ref);
+
+/**
+ * Removes a force from a body's reverse index of forces.
+ * The last reference in the index is moved into the vacated slot.
+ *
+ * @param body the body the force acts on
+ * @param slot the slot returned from body_add_force_ref()
+ * @return whether a reference was moved into the slot
+ */
+bool body_remove_force_ref(body_t *body, size_t slot);
+
 /**
  * Marks a body for removal--future calls to body_is_removed() will return true.
  * Does not free the body.
+ * If the body is in a scene, notifies the scene so that it only looks for
+ * removed bodies and their forces when some body has been removed.
  * If the body is already marked for removal, does nothing.
  *
  * @param body the body to mark for removal
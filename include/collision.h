@@ -27,6 +27,24 @@ typedef struct {
     //  bool collided_last_tick;
 } collision_info_t;
 
+/**
+ * Represents the first contact between a moving shape and a still one.
+ */
+typedef struct {
+    /** Whether the moving shape touches the still shape along the way */
+    bool hit;
+    /**
+     * If the shapes touch, how far along the displacement they first touch,
+     * from 0 (where the moving shape starts) to 1 (where it ends).
+     */
+    double fraction;
+    /**
+     * If the shapes touch, the unit normal of the surface they touch along,
+     * pointing from the still shape towards the moving shape.
+     */
+    vector_t normal;
+} sweep_info_t;
+
 /**
  * Computes the status of the collision between two convex polygons.
  * The shapes are given as lists of vertices in counterclockwise order.
@@ -40,6 +58,20 @@ typedef struct {
  */
 collision_info_t find_collision(list_t *shape1, list_t *shape2);
 
+/**
+ * Finds when a convex polygon moved in a straight line first touches
+ * another convex polygon, using the separating axis theorem:
+ * the shapes overlap while their projections overlap on every edge normal,
+ * and without rotation the edge normals don't change along the way.
+ *
+ * @param shape1 the moving shape, at its starting position
+ * @param displacement how far shape1 moves
+ * @param shape2 the still shape
+ * @return whether the shapes touch, and if so, when and along which normal.
+ * Shapes that already overlap at the start don't touch.
+ */
+sweep_info_t find_sweep(list_t *shape1, vector_t displacement, list_t *shape2);
+
 double find_min(double first, double second);
 
 vector_t *edge_perp(vector_t vec);
@@ -0,0 +1,175 @@
+#ifndef __FIELD_H__
+#define __FIELD_H__
+
+#include "scene.h"
+#include "vector.h"
+
+/**
+ * A 2D vector field, e.g. a wind or a current, stored as a grid of vectors
+ * at evenly spaced points and sampled by bilinear interpolation.
+ * Grid point (col, row) is at origin + cell_size * (col, row).
+ * Positions outside the grid take the value at the nearest edge.
+ */
+typedef struct field field_t;
+
+/**
+ * A function giving the value of a vector field at a position.
+ *
+ * @param position the position to evaluate the field at
+ * @param aux the auxiliary value passed to field_init_from_func()
+ * @return the value of the field
+ */
+typedef vector_t (*field_func_t)(vector_t position, void *aux);
+
+/**
+ * Allocates memory for a vector field that is 0 everywhere.
+ * Asserts that the grid is non-empty, that it fits in memory,
+ * and that the cell size is positive.
+ *
+ * @param origin the position of grid point (0, 0)
+ * @param cell_size the distance between neighboring grid points
+ * @param cols the number of grid points along the x axis
+ * @param rows the number of grid points along the y axis
+ * @return the new field
+ */
+field_t *field_init(vector_t origin, double cell_size, size_t cols, size_t rows);
+
+/**
+ * Allocates memory for a vector field, evaluating a function once
+ * at each grid point.
+ *
+ * @param origin the position of grid point (0, 0)
+ * @param cell_size the distance between neighboring grid points
+ * @param cols the number of grid points along the x axis
+ * @param rows the number of grid points along the y axis
+ * @param func the function giving the value of the field at each grid point
+ * @param aux an auxiliary value to pass to func
+ * @return the new field
+ */
+field_t *field_init_from_func(
+    vector_t origin,
+    double cell_size,
+    size_t cols,
+    size_t rows,
+    field_func_t func,
+    void *aux
+);
+
+/**
+ * Loads a vector field from a text file.
+ * The file starts with "cols rows origin_x origin_y cell_size",
+ * followed by the x and y components at each grid point,
+ * row by row starting from row 0.
+ *
+ * @param path the path of the file
+ * @return the new field, or NULL if the file cannot be read,
+ *   is not a valid field, or describes a grid too big to allocate
+ */
+field_t *field_load(const char *path);
+
+/**
+ * Releases the memory allocated for a vector field.
+ *
+ * @param field a field returned from field_init(), field_init_from_func(),
+ *   or field_load()
+ */
+void field_free(field_t *field);
+
+/**
+ * Gets the value of a vector field at a grid point.
+ * Asserts that the grid point is valid.
+ *
+ * @param field a field returned from field_init()
+ * @param col the column of the grid point
+ * @param row the row of the grid point
+ * @return the value of the field at the grid point
+ */
+vector_t field_get(field_t *field, size_t col, size_t row);
+
+/**
+ * Sets the value of a vector field at a grid point.
+ * Asserts that the grid point is valid.
+ *
+ * @param field a field returned from field_init()
+ * @param col the column of the grid point
+ * @param row the row of the grid point
+ * @param value the new value of the field at the grid point
+ */
+void field_set(field_t *field, size_t col, size_t row, vector_t value);
+
+/**
+ * Samples a vector field at a position by bilinear interpolation
+ * between the four surrounding grid points.
+ *
+ * @param field a field returned from field_init()
+ * @param position the position to sample
+ * @return the interpolated value of the field
+ */
+vector_t field_sample(field_t *field, vector_t position);
+
+/**
+ * Samples a vector field at many positions in one pass.
+ * The positions and results are stored as separate x and y arrays,
+ * which may not overlap.
+ *
+ * @param field a field returned from field_init()
+ * @param x the x coordinates of the positions
+ * @param y the y coordinates of the positions
+ * @param count the number of positions
+ * @param out_x array of count values to store the x components in
+ * @param out_y array of count values to store the y components in
+ */
+void field_sample_batch(
+    field_t *field,
+    const double *x,
+    const double *y,
+    size_t count,
+    double *out_x,
+    double *out_y
+);
+
+/**
+ * Adds a force creator to a scene that applies a force field
+ * to a set of bodies in a single pass, sampling the field
+ * at each body's centroid.
+ *
+ * @param scene the scene containing the bodies
+ * @param field the force at each position. The field is not freed
+ *   with the scene, so it can be shared between force creators and scenes,
+ *   and must outlive them.
+ * @param bodies the bodies to apply the force to, or NULL for every body
+ *   in the scene with finite mass (including bodies added later).
+ *   The scene takes ownership of this list, which does not own the bodies,
+ *   so its freer should be NULL. The force is removed if any of them are.
+ */
+void create_field_force(scene_t *scene, field_t *field, list_t *bodies);
+
+/**
+ * Adds a force creator to a scene that drags a set of bodies along
+ * with a flow, such as a wind or a current, in a single pass.
+ * Each body feels the force gamma * (u - v), where u is the flow velocity
+ * sampled at its centroid and v is its own velocity.
+ * With a flow of 0 everywhere, this is create_bulk_drag().
+ *
+ * @param scene the scene containing the bodies
+ * @param field the velocity of the flow at each position,
+ *   which must outlive the scene (see create_field_force())
+ * @param gamma the proportionality constant between force and relative velocity
+ * @param bodies the bodies in the flow, or NULL for every body
+ *   in the scene with finite mass (see create_field_force())
+ */
+void create_flow_drag(
+    scene_t *scene,
+    field_t *field,
+    double gamma,
+    list_t *bodies
+);
+
+/**
+ * Applies a field force or flow drag to its bodies.
+ *
+ * @param aux the force created by create_field_force() or create_flow_drag()
+ */
+void field_force_creator(void *aux);
+
+#endif // #ifndef __FIELD_H__
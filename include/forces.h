@@ -17,7 +17,8 @@ typedef void (*collision_handler_t)
 
 /**
  * Structure to store miscellaneous information about bodies to which a force
- * is applied and constant for the force
+ * is applied and constant for the force.
+ * Built-in forces are stored in the scene by value as one of these records.
  */
  typedef struct aux {
    double constant;
@@ -26,6 +27,7 @@ typedef void (*collision_handler_t)
    bool collided;
    collision_handler_t handler;
    void *aux;
+   free_func_t freer;
  } aux_t;
 
 /**
@@ -37,6 +39,26 @@ typedef void (*collision_handler_t)
  */
 void gravity_creator(void *aux);
 
+/**
+ * Calculates the force of gravity for each record in an array of gravity
+ * forces and applies the forces to their bodies
+ *
+ * @param forces array of records containing the bodies and constants
+ * @param count the number of records in the array
+ */
+void gravity_creator_batch(aux_t *forces, size_t count);
+
+/**
+ * Calculates the force of gravity on body1 for each record in an array of
+ * gravity forces without applying it, so that the records can be split
+ * between threads. body2 feels the opposite force.
+ *
+ * @param forces array of records containing the bodies and constants
+ * @param count the number of records in the array
+ * @param out array of count forces to store the results in
+ */
+void gravity_force_batch(aux_t *forces, size_t count, vector_t *out);
+
 /**
  * Calculates the spring force on the given objects and applies the force
  * to them
@@ -46,6 +68,26 @@ void gravity_creator(void *aux);
  */
 void spring_creator(void *aux);
 
+/**
+ * Calculates the spring force for each record in an array of spring
+ * forces and applies the forces to their bodies
+ *
+ * @param forces array of records containing the bodies and constants
+ * @param count the number of records in the array
+ */
+void spring_creator_batch(aux_t *forces, size_t count);
+
+/**
+ * Calculates the spring force on body1 for each record in an array of spring
+ * forces without applying it, so that the records can be split between
+ * threads. body2 feels the opposite force.
+ *
+ * @param forces array of records containing the bodies and constants
+ * @param count the number of records in the array
+ * @param out array of count forces to store the results in
+ */
+void spring_force_batch(aux_t *forces, size_t count, vector_t *out);
+
 /**
  * Calculates the force of drag on the given object and applies the force
  * to it
@@ -54,6 +96,34 @@ void spring_creator(void *aux);
  * constants
  */
 void drag_creator(void *aux);
+
+/**
+ * Calculates the force of drag for each record in an array of drag
+ * forces and applies the forces to their bodies
+ *
+ * @param forces array of records containing the bodies and constants
+ * @param count the number of records in the array
+ */
+void drag_creator_batch(aux_t *forces, size_t count);
+
+/**
+ * Calculates the force of drag on body1 for each record in an array of drag
+ * forces without applying it, so that the records can be split between
+ * threads.
+ *
+ * @param forces array of records containing the bodies and constants
+ * @param count the number of records in the array
+ * @param out array of count forces to store the results in
+ */
+void drag_force_batch(aux_t *forces, size_t count, vector_t *out);
+/**
+ * Calculates the force of drag on a set of objects and applies the force
+ * to each of them
+ *
+ * @param aux struct containing the bodies to apply force to and constants
+ */
+void bulk_drag_creator(void *aux);
+
 /**
  * Handles collision of two bodies
  * Does body_remove() on collided bodies
@@ -69,6 +139,17 @@ void collision_handler_1(body_t *body1, body_t *body2, vector_t axis, void *aux)
  */
 void collision_creator(void *aux);
 
+/**
+ * Responds to the result of checking a collision record's bodies
+ * for a collision, calling its handler if they collided.
+ * collision_creator() is find_collision() followed by this,
+ * split so that the checks can run on several threads.
+ *
+ * @param aux the collision record
+ * @param info the result of find_collision() on the record's bodies
+ */
+void collision_respond(aux_t *aux, collision_info_t info);
+
 /**
  * Handles and applies impulses
  *
@@ -121,6 +202,23 @@ void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2);
  */
 void create_drag(scene_t *scene, double gamma, body_t *body);
 
+/**
+ * Adds a force creator to a scene that applies a drag force
+ * to a whole set of bodies in a single pass.
+ * Equivalent to calling create_drag() on each body,
+ * but with one force creator instead of one per body.
+ * For drag on every body, scene_set_drag() is cheaper still.
+ *
+ * @param scene the scene containing the bodies
+ * @param gamma the proportionality constant between force and velocity
+ *   (higher gamma means more drag)
+ * @param bodies the bodies to slow down, or NULL for every body
+ *   in the scene with finite mass (including bodies added later).
+ *   The scene takes ownership of this list, which does not own the bodies,
+ *   so its freer should be NULL. The force is removed if any of them are.
+ */
+void create_bulk_drag(scene_t *scene, double gamma, list_t *bodies);
+
 /**
  * Adds a force creator to a scene that calls a given collision handler
  * function each time two bodies collide.
@@ -0,0 +1,86 @@
+#ifndef __HOT_COUNTERS_H__
+#define __HOT_COUNTERS_H__
+
+#include <stddef.h>
+
+/**
+ * Counters of the work done in the library's innermost loops,
+ * for checking that an optimization removed work rather than moved it.
+ * Build with -DHOT_COUNTERS to count; otherwise HOT_COUNT() compiles
+ * to nothing and the counters stay at zero.
+ *
+ * Each thread counts into its own counters, which only it writes,
+ * so counting never waits for another thread.
+ */
+typedef enum {
+  // Reallocations of a list's array by list_add()
+  HOT_LIST_GROWS,
+  HOT_FIND_COLLISION_CALLS,
+  // Axes made by find_collision() to test for separation
+  HOT_SAT_AXES,
+  // Calls to polygon_proj_min() and polygon_proj_max()
+  HOT_PROJECTIONS,
+  // Calls to sin() and cos() by vec_rotate()
+  HOT_TRIG_CALLS,
+  // Copies of a body's shape made by body_get_shape()
+  HOT_SHAPE_COPIES,
+  // Heap allocations by lists, and of the vertices and axes
+  // in the shape copies and axes above
+  HOT_ALLOCATIONS,
+  // Frees by lists, including of their elements
+  HOT_FREES,
+  NUM_HOT_COUNTERS
+} hot_counter_t;
+
+/**
+ * The name of each counter, e.g. for printing them.
+ */
+extern const char *const HOT_COUNTER_NAMES[NUM_HOT_COUNTERS];
+
+#ifdef HOT_COUNTERS
+/** Adds n to a counter of the calling thread */
+#define HOT_COUNT(counter, n) hot_count(counter, n)
+#else
+#define HOT_COUNT(counter, n) ((void) 0)
+#endif
+
+/**
+ * Adds to a counter of the calling thread.
+ * Use the HOT_COUNT() macro instead, which is removed when counting
+ * is disabled.
+ *
+ * @param counter the counter to add to
+ * @param n the amount to add
+ */
+void hot_count(hot_counter_t counter, size_t n);
+
+/**
+ * Gets a counter of the calling thread.
+ *
+ * @param counter the counter to get
+ * @return the count since the thread's counters were last reset
+ */
+size_t hot_counter_get(hot_counter_t counter);
+
+/**
+ * Adds up a counter over every thread that has counted anything,
+ * including threads that have exited, e.g. a worker pool's threads.
+ * Counts being made meanwhile by other threads may or may not be included.
+ *
+ * @param counter the counter to add up
+ * @return the total count
+ */
+size_t hot_counter_total(hot_counter_t counter);
+
+/**
+ * Sets the calling thread's counters to zero.
+ */
+void hot_counters_reset(void);
+
+/**
+ * Sets every thread's counters to zero.
+ * Other threads must not be counting meanwhile, or their counts may be lost.
+ */
+void hot_counters_reset_all(void);
+
+#endif // #ifndef __HOT_COUNTERS_H__
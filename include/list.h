@@ -1,6 +1,7 @@
 #ifndef __LIST_H__
 #define __LIST_H__
 
+#include <stdbool.h>
 #include <stddef.h>
 
 /**
@@ -16,6 +17,12 @@ typedef struct list list_t;
  */
 typedef void (*free_func_t)(void *);
 
+/**
+ * A function that decides whether to remove an element from a list,
+ * given the element and an auxiliary value.
+ */
+typedef bool (*list_predicate_t)(void *element, void *aux);
+
 /**
  * Allocates memory for a new list with space for the given number of elements.
  * The list is initially empty.
@@ -54,6 +61,40 @@ size_t list_size(list_t *list);
  */
 void *list_get(list_t *list, size_t index);
 
+/**
+ * Replaces the element at a given index in a list.
+ * Does not free the element being replaced.
+ * Asserts that the index is valid and that the new value is non-NULL.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param index an index in the list (the first element is at 0)
+ * @param value the element to store at the given index
+ */
+void list_set(list_t *list, size_t index, void *value);
+
+/**
+ * Shrinks a list to a given size, dropping the elements past the new end
+ * without freeing them.
+ * Asserts that the new size is not larger than the current size.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param size the new number of elements in the list
+ */
+void list_truncate(list_t *list, size_t size);
+
+/**
+ * Removes every element of a list for which a predicate returns true,
+ * keeping the remaining elements in order.
+ * Takes a single pass over the list, however many elements are removed.
+ * Does not free the removed elements.
+ *
+ * @param list a pointer to a list returned from list_init()
+ * @param predicate a function returning whether to remove an element
+ * @param aux an auxiliary value to pass to predicate
+ * @return the number of elements removed
+ */
+size_t list_remove_if(list_t *list, list_predicate_t predicate, void *aux);
+
 /**
  * Removes the element at a given index in a list and returns it,
  * moving all subsequent elements towards the start of the list.
@@ -0,0 +1,129 @@
+#ifndef __PAIR_POTENTIAL_H__
+#define __PAIR_POTENTIAL_H__
+
+#include "scene.h"
+
+/**
+ * A function giving the magnitude of a short-range force between two bodies.
+ * Positive values push the bodies apart and negative values pull them together.
+ *
+ * @param distance the distance between the bodies' centroids,
+ *   which is always less than the cutoff of the pair potential
+ * @param params the parameters passed to create_pair_potential()
+ * @return the magnitude of the force on each body
+ */
+typedef double (*pair_force_t)(double distance, void *params);
+
+/**
+ * A short-range force between every pair of bodies in a set
+ * that are closer than a cutoff distance.
+ * Nearby pairs are found with a grid of cells at least the cutoff
+ * plus a skin distance wide, and kept in a list of neighbors within
+ * that distance.
+ * The neighbor list is only rebuilt once some body has moved more than
+ * half the skin since the last rebuild, so most ticks cost one pass
+ * over the listed pairs and the cost grows linearly with the number of bodies.
+ */
+typedef struct pair_potential pair_potential_t;
+
+/**
+ * Adds a force creator to a scene that applies a short-range force
+ * between every pair of bodies in a set that are closer than a cutoff.
+ * The potential is removed from the scene if any of its bodies are removed.
+ * Its bodies' positions must stay finite.
+ *
+ * @param scene the scene containing the bodies
+ * @param bodies the bodies to apply the force between. The scene takes
+ *   ownership of this list, which does not own the bodies,
+ *   so its freer should be NULL.
+ * @param cutoff the distance beyond which the force is 0
+ * @param skin how much further than the cutoff to look for neighbors.
+ *   A larger skin rebuilds the neighbor list less often
+ *   but checks more pairs each tick.
+ * @param force the magnitude of the force at each distance below the cutoff
+ * @param params the parameters passed to force
+ * @param freer if non-NULL, a function to call in order to free params
+ * @return the potential, which is freed along with the scene
+ */
+pair_potential_t *create_pair_potential(
+    scene_t *scene,
+    list_t *bodies,
+    double cutoff,
+    double skin,
+    pair_force_t force,
+    void *params,
+    free_func_t freer
+);
+
+/**
+ * Adds a soft repulsion between every pair of bodies in a set,
+ * a linear spring pushing apart bodies closer than a diameter.
+ * This is the usual contact model for granular media.
+ * See create_pair_potential() for details.
+ *
+ * @param scene the scene containing the bodies
+ * @param bodies the bodies to apply the force between
+ * @param k the Hooke's constant of the repulsion
+ * @param diameter the distance at which the bodies touch,
+ *   which is also the cutoff
+ * @param skin how much further than the cutoff to look for neighbors
+ * @return the potential, which is freed along with the scene
+ */
+pair_potential_t *create_soft_repulsion(
+    scene_t *scene,
+    list_t *bodies,
+    double k,
+    double diameter,
+    double skin
+);
+
+/**
+ * Adds a Lennard-Jones force between every pair of bodies in a set,
+ * the force of the potential 4 * epsilon * ((sigma / r)^12 - (sigma / r)^6).
+ * See create_pair_potential() for details.
+ *
+ * @param scene the scene containing the bodies
+ * @param bodies the bodies to apply the force between
+ * @param epsilon the depth of the potential well
+ * @param sigma the distance at which the potential is 0
+ * @param cutoff the distance beyond which the force is 0,
+ *   usually 2.5 * sigma
+ * @param skin how much further than the cutoff to look for neighbors
+ * @return the potential, which is freed along with the scene
+ */
+pair_potential_t *create_lennard_jones(
+    scene_t *scene,
+    list_t *bodies,
+    double epsilon,
+    double sigma,
+    double cutoff,
+    double skin
+);
+
+/**
+ * Gets the number of pairs in a pair potential's neighbor list,
+ * which includes every pair closer than the cutoff.
+ *
+ * @param potential a potential returned from create_pair_potential()
+ * @return the number of pairs closer than the cutoff plus the skin
+ *   at the last rebuild of the neighbor list
+ */
+size_t pair_potential_pairs(pair_potential_t *potential);
+
+/**
+ * Gets the number of times a pair potential has rebuilt its neighbor list.
+ *
+ * @param potential a potential returned from create_pair_potential()
+ * @return the number of rebuilds
+ */
+size_t pair_potential_rebuilds(pair_potential_t *potential);
+
+/**
+ * Applies a pair potential's force between every pair of its bodies
+ * closer than its cutoff, rebuilding its neighbor list if needed.
+ *
+ * @param potential a potential returned from create_pair_potential()
+ */
+void pair_potential_creator(void *potential);
+
+#endif // #ifndef __PAIR_POTENTIAL_H__
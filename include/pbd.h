@@ -0,0 +1,105 @@
+#ifndef __PBD_H__
+#define __PBD_H__
+
+#include "scene.h"
+
+/**
+ * A set of constraints between bodies, solved by position-based dynamics.
+ * Each tick, the solver predicts where its bodies would move under
+ * the forces and impulses applied to them, then repeatedly projects
+ * the predicted positions onto each constraint in turn (Gauss-Seidel).
+ * The bodies' velocities are then set so that the scene moves them
+ * to the projected positions. Constraints never add energy,
+ * so ropes, chains, and soft bodies stay stable at any time step.
+ */
+typedef struct pbd pbd_t;
+
+/**
+ * Adds a position-based dynamics solver to a scene.
+ * Constraints are added afterwards with pbd_add_distance(), pbd_add_contact(),
+ * pbd_add_pin(), and pbd_add_plane().
+ * The solver runs after every force creator (see scene_add_solver()),
+ * and is removed from the scene if any of its bodies are removed.
+ *
+ * @param scene the scene containing the bodies
+ * @param bodies the bodies the constraints apply to, referred to by index.
+ *   The scene takes ownership of this list, which does not own the bodies,
+ *   so its freer should be NULL.
+ * @param iterations the number of times to project every constraint each tick.
+ *   More iterations make long chains of constraints stiffer.
+ * @return the solver, which is freed along with the scene
+ */
+pbd_t *create_pbd(scene_t *scene, list_t *bodies, size_t iterations);
+
+/**
+ * Adds a constraint keeping two bodies' centroids a fixed distance apart.
+ *
+ * @param pbd a solver returned from create_pbd()
+ * @param body1 the index of the first body in the solver's bodies
+ * @param body2 the index of the second body in the solver's bodies
+ * @param length the distance to keep the bodies apart
+ * @param stiffness how much of the error to correct each tick,
+ *   between 0 (exclusive) and 1 (rigid). This does not depend
+ *   on the number of iterations.
+ */
+void pbd_add_distance(
+    pbd_t *pbd,
+    size_t body1,
+    size_t body2,
+    double length,
+    double stiffness
+);
+
+/**
+ * Adds a constraint keeping two bodies' centroids at least a distance apart,
+ * e.g. the sum of their radii.
+ *
+ * @param pbd a solver returned from create_pbd()
+ * @param body1 the index of the first body in the solver's bodies
+ * @param body2 the index of the second body in the solver's bodies
+ * @param distance the closest the bodies may get
+ */
+void pbd_add_contact(pbd_t *pbd, size_t body1, size_t body2, double distance);
+
+/**
+ * Adds a constraint holding a body's centroid at a position.
+ * Other constraints cannot move a pinned body, as if it had infinite mass.
+ * Bodies with infinite mass cannot be moved by any constraint, including pins.
+ *
+ * @param pbd a solver returned from create_pbd()
+ * @param body the index of the body in the solver's bodies
+ * @param position where to hold the body's centroid
+ */
+void pbd_add_pin(pbd_t *pbd, size_t body, vector_t position);
+
+/**
+ * Adds a constraint keeping a body's centroid on one side of a line,
+ * e.g. above the ground.
+ *
+ * @param pbd a solver returned from create_pbd()
+ * @param body the index of the body in the solver's bodies
+ * @param point a point on the line
+ * @param normal a vector perpendicular to the line,
+ *   pointing to the side to keep the body on
+ */
+void pbd_add_plane(pbd_t *pbd, size_t body, vector_t point, vector_t normal);
+
+/**
+ * Gets the number of constraints in a solver.
+ *
+ * @param pbd a solver returned from create_pbd()
+ * @return the number of constraints added to the solver
+ */
+size_t pbd_constraints(pbd_t *pbd);
+
+/**
+ * Projects a solver's bodies onto its constraints for the current tick
+ * and sets their velocities accordingly.
+ * Clears the forces and impulses on the bodies,
+ * which are included in the velocities.
+ *
+ * @param pbd a solver returned from create_pbd()
+ */
+void pbd_solver(void *pbd);
+
+#endif // #ifndef __PBD_H__
@@ -1,9 +1,18 @@
 #ifndef __POLYGON_H__
 #define __POLYGON_H__
 
+#include <stdbool.h>
 #include "list.h"
 #include "vector.h"
 
+/**
+ * An axis-aligned box, e.g. the bounding box of a polygon.
+ */
+typedef struct aabb {
+  vector_t min;
+  vector_t max;
+} aabb_t;
+
 /**
  * Computes the area of a polygon.
  * See https://en.wikipedia.org/wiki/Shoelace_formula#Statement.
@@ -46,4 +55,59 @@ void polygon_translate(list_t *polygon, vector_t translation);
  */
 void polygon_rotate(list_t *polygon, double angle, vector_t point);
 
+/**
+ * Computes the smallest axis-aligned box containing a polygon.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @return the polygon's bounding box
+ */
+aabb_t polygon_bounds(list_t *polygon);
+
+/**
+ * Checks whether two axis-aligned boxes overlap, counting touching edges.
+ *
+ * @param a one box
+ * @param b the other box
+ * @return whether the boxes share any point
+ */
+bool aabb_overlap(aabb_t a, aabb_t b);
+
+/**
+ * Checks whether a point is inside a polygon, which need not be convex.
+ * See https://en.wikipedia.org/wiki/Point_in_polygon#Ray_casting_algorithm.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @param point the point to check
+ * @return whether the point is inside the polygon
+ */
+bool polygon_contains(list_t *polygon, vector_t point);
+
+/**
+ * Computes the distance from a point to the nearest point of a polygon.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @param point the point to measure from
+ * @return the distance to the polygon's nearest edge, or 0 if the point
+ *   is inside the polygon
+ */
+double polygon_distance(list_t *polygon, vector_t point);
+
+/**
+ * Finds where a ray first crosses the boundary of a polygon from outside.
+ *
+ * @param polygon the list of vertices that make up the polygon
+ * @param origin the point the ray starts from
+ * @param direction the unit vector the ray points along
+ * @param normal if the ray hits, set to the unit normal of the edge it hits,
+ *   facing back along the ray
+ * @return the distance along the ray to the hit, or INFINITY if the ray
+ *   misses or starts inside the polygon
+ */
+double polygon_raycast(
+    list_t *polygon,
+    vector_t origin,
+    vector_t direction,
+    vector_t *normal
+);
+
 #endif // #ifndef __POLYGON_H__
@@ -0,0 +1,95 @@
+#ifndef __RENDER_BUFFER_H__
+#define __RENDER_BUFFER_H__
+
+#include <stddef.h>
+#include "color.h"
+#include "scene.h"
+#include "vector.h"
+
+/**
+ * What a renderer needs to know about one body of a published frame.
+ */
+typedef struct render_body {
+  vector_t centroid;
+  double orientation;
+  // Pose at the start of the last fixed step, for interpolation
+  vector_t prev_centroid;
+  double prev_orientation;
+  rgb_color_t color;
+  // Index of the body's first vertex in the frame's vertices
+  size_t first_vertex;
+  size_t vertex_count;
+} render_body_t;
+
+/**
+ * The state of a scene's bodies at the end of one tick,
+ * copied into flat arrays that don't change once published.
+ */
+typedef struct render_frame {
+  render_body_t *bodies;
+  size_t body_count;
+  // The vertices of every body, one body after another
+  vector_t *vertices;
+  size_t vertex_count;
+  // How far to interpolate from the bodies' previous to their current poses
+  double alpha;
+  // Number of frames published up to this one, or 0 before any is published
+  size_t sequence;
+  size_t body_capacity;
+  size_t vertex_capacity;
+} render_frame_t;
+
+/**
+ * Three frames passed from the thread stepping a scene to a thread
+ * drawing it: one being written, one being drawn, and the latest
+ * published frame. Publishing and acquiring only swap an index
+ * atomically, so neither thread ever waits for the other,
+ * and the drawing thread never sees a frame that is being written.
+ * There must be only one publishing thread and one acquiring thread.
+ */
+typedef struct render_buffer render_buffer_t;
+
+/**
+ * Allocates memory for a render buffer with three empty frames.
+ *
+ * @return the new buffer
+ */
+render_buffer_t *render_buffer_init(void);
+
+/**
+ * Releases the memory allocated for a render buffer and its frames.
+ *
+ * @param buffer a buffer returned from render_buffer_init()
+ */
+void render_buffer_free(render_buffer_t *buffer);
+
+/**
+ * Copies the bodies of a scene into a frame and publishes it,
+ * replacing the previously published frame if it wasn't acquired.
+ * Called by scene_tick() and scene_step_fixed() on a scene
+ * with a render buffer (see scene_set_render_buffer()).
+ *
+ * @param buffer a buffer returned from render_buffer_init()
+ * @param scene the scene to copy, which must not be ticked meanwhile
+ * @param alpha how far to interpolate between the bodies' previous
+ *   and current poses when drawing the frame, e.g. scene_get_alpha(),
+ *   or 1 to draw their current poses
+ */
+void render_buffer_publish(
+    render_buffer_t *buffer,
+    scene_t *scene,
+    double alpha
+);
+
+/**
+ * Gets the latest published frame.
+ * The frame is not changed until the next call to render_buffer_acquire(),
+ * even if more frames are published meanwhile.
+ *
+ * @param buffer a buffer returned from render_buffer_init()
+ * @return the latest frame, or the last acquired frame if none has been
+ *   published since; before any is published, a frame with no bodies
+ */
+const render_frame_t *render_buffer_acquire(render_buffer_t *buffer);
+
+#endif // #ifndef __RENDER_BUFFER_H__
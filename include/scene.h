@@ -3,6 +3,9 @@
 
 #include "body.h"
 #include "list.h"
+#include "polygon.h"
+#include "tick_stats.h"
+#include "worker_pool.h"
 
 /**
  * A collection of bodies and force creators.
@@ -17,6 +20,69 @@ typedef struct scene scene_t;
  */
 typedef struct force force_t;
 
+/**
+ * The kinds of built-in forces (see forces.h).
+ * A scene stores the forces of each kind contiguously
+ * and evaluates them in one loop per kind,
+ * instead of calling a force creator per force.
+ */
+typedef enum {
+  FORCE_GRAVITY,
+  FORCE_SPRING,
+  FORCE_DRAG,
+  FORCE_COLLISION,
+  NUM_FORCE_KINDS
+} force_kind_t;
+
+/**
+ * The parameters of a built-in force, defined in forces.h.
+ */
+typedef struct aux aux_t;
+
+/**
+ * Frames of a scene published for another thread to draw,
+ * defined in render_buffer.h.
+ */
+typedef struct render_buffer render_buffer_t;
+
+/**
+ * A reference to a body in a scene that stays valid while the body is
+ * in the scene, however other bodies are added and removed,
+ * and can be checked in constant time once the body is removed.
+ * The handle {0, 0} never refers to a body.
+ */
+typedef struct body_handle {
+  // The slot the body occupies in the scene's map of handles
+  size_t index;
+  // Incremented each time the slot is freed, so old handles to it fail
+  size_t generation;
+} body_handle_t;
+
+/**
+ * A ray to cast into a scene with scene_raycast_batch().
+ */
+typedef struct ray {
+  vector_t origin;
+  // The direction to cast in, which needn't be a unit vector
+  vector_t direction;
+  // How far to look along the ray
+  double max_distance;
+} ray_t;
+
+/**
+ * Where a ray or a moving shape first hits a body.
+ */
+typedef struct ray_hit {
+  // The body hit, or NULL if nothing was hit
+  body_t *body;
+  // Where the ray hit, or where the shape's centroid is when it hits
+  vector_t point;
+  // The unit normal of the surface hit, pointing back towards the ray
+  vector_t normal;
+  // How far the ray or shape went before hitting
+  double distance;
+} ray_hit_t;
+
 /**
  * A function which adds some forces or impulses to bodies,
  * e.g. from collisions, gravity, or spring forces.
@@ -24,6 +90,18 @@ typedef struct force force_t;
  */
 typedef void (*force_creator_t)(void *aux);
 
+/**
+ * A function which copies the auxiliary value of a force creator
+ * for a fork of its scene (see scene_fork()).
+ *
+ * @param aux the force creator's auxiliary value
+ * @param fork the forked scene, which already holds its copies of the bodies
+ * @param bodies the fork's copies of the bodies the force acts on, in order,
+ *   which the copied force owns
+ * @return the copied auxiliary value, freed by the force's freer
+ */
+typedef void *(*force_copier_t)(void *aux, scene_t *fork, list_t *bodies);
+
 /**
  * Allocates memory for a force.
  * Asserts that the required memory is successfully allocated.
@@ -80,6 +158,7 @@ scene_t *scene_init(void);
 /**
  * Releases memory allocated for a given scene
  * and all the bodies and force creators it contains.
+ * Asserts that every fork of the scene (see scene_fork()) has been freed.
  *
  * @param scene a pointer to a scene returned from scene_init()
  */
@@ -104,7 +183,18 @@ size_t scene_bodies(scene_t *scene);
 body_t *scene_get_body(scene_t *scene, size_t index);
 
 /**
- * Gets the force at a given index in a scene.
+ * Gets the number of built-in forces of a given kind in a scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param kind the kind of force to count
+ * @return the number of forces added with scene_add_typed_force()
+ */
+size_t scene_typed_forces(scene_t *scene, force_kind_t kind);
+
+/**
+ * Gets the force creator at a given index in a scene.
+ * Only force creators added with scene_add_bodies_force_creator()
+ * are indexed here; built-in forces are stored by kind.
  * Asserts that the index is valid.
  *
  * @param scene a pointer to a scene returned from scene_init()
@@ -115,12 +205,54 @@ body_t *scene_get_body(scene_t *scene, size_t index);
 force_t *scene_get_force(scene_t *scene, size_t index);
 /**
  * Adds a body to a scene.
+ * During a tick, the body is added once the tick's callbacks are done
+ * (see scene_tick()).
  *
  * @param scene a pointer to a scene returned from scene_init()
  * @param body a pointer to the body to add to the scene
  */
 void scene_add_body(scene_t *scene, body_t *body);
 
+/**
+ * Gets a handle to a body in a scene, which can be stored instead of
+ * the body's index or a pointer to it. Asserts that the body is in the scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param body a body added to the scene with scene_add_body()
+ * @return the body's handle, the same every time it is asked for
+ */
+body_handle_t scene_get_handle(scene_t *scene, body_t *body);
+
+/**
+ * Finds the body a handle refers to, in constant time.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handle a handle returned from scene_get_handle() on the same scene
+ *   (or on a scene it was forked from, see scene_fork())
+ * @return the body, or NULL if it has been removed
+ */
+body_t *scene_lookup(scene_t *scene, body_handle_t handle);
+
+/**
+ * Checks whether a handle refers to a body in a scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handle a handle returned from scene_get_handle()
+ * @return whether scene_lookup() finds a body that hasn't been removed
+ */
+bool scene_handle_valid(scene_t *scene, body_handle_t handle);
+
+/**
+ * Marks the body a handle refers to for removal, like body_remove().
+ * Its handle stops being valid immediately, and the handle's slot
+ * is reused for another body once the body is removed from the scene.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param handle a handle returned from scene_get_handle()
+ * @return whether the handle referred to a body that wasn't already removed
+ */
+bool scene_remove_handle(scene_t *scene, body_handle_t handle);
+
 /**
  * @deprecated Use body_remove() instead
  *
@@ -133,7 +265,32 @@ void scene_add_body(scene_t *scene, body_t *body);
 void scene_remove_body(scene_t *scene, size_t index);
 
 /**
- * Removes and frees the force at a given index from a scene.
+ * A function that decides whether to remove a body from a scene,
+ * given the body and an auxiliary value.
+ */
+typedef bool (*body_predicate_t)(body_t *body, void *aux);
+
+/**
+ * Removes and frees every body in a scene for which a predicate returns true,
+ * along with every force acting on those bodies.
+ * Unlike body_remove(), the bodies are removed immediately
+ * rather than at the end of the next tick.
+ * Takes time linear in the number of bodies and forces,
+ * however many bodies are removed.
+ * When called during a tick, e.g. from a collision or bounds handler,
+ * the bodies are only marked for removal, like scene_remove_handle(),
+ * and are freed at the end of the tick.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param predicate a function returning whether to remove a body
+ * @param aux an auxiliary value to pass to predicate
+ * @return the number of bodies removed or marked for removal,
+ *   including any that were already marked for removal
+ */
+size_t scene_remove_if(scene_t *scene, body_predicate_t predicate, void *aux);
+
+/**
+ * Removes and frees the force creator at a given index from a scene.
  * Asserts that the index is valid.
  *
  * @param scene a pointer to a scene returned from scene_init()
@@ -164,7 +321,8 @@ void scene_add_force_creator(
  * @param aux an auxiliary value to pass to forcer when it is called
  * @param bodies the list of bodies affected by the force creator.
  *   The force creator will be removed if any of these bodies are removed.
- *   This list does not own the bodies, so its freer should be NULL.
+ *   The scene takes ownership of this list, which does not own the bodies,
+ *   so its freer should be NULL.
  * @param freer if non-NULL, a function to call in order to free aux
  */
 void scene_add_bodies_force_creator(
@@ -175,16 +333,436 @@ void scene_add_bodies_force_creator(
     free_func_t freer
 );
 
+/**
+ * Adds a solver to a scene, which is a force creator that scene_tick()
+ * invokes after every force and collision has been applied
+ * and just before the bodies are moved, e.g. to correct the motion
+ * of the bodies so that it satisfies some constraints
+ * (see pbd.h). Solvers are invoked in the order they were added,
+ * and are indexed and removed like other force creators.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param solver a force creator function
+ * @param aux an auxiliary value to pass to solver when it is called
+ * @param bodies the list of bodies affected by the solver,
+ *   as in scene_add_bodies_force_creator()
+ * @param freer if non-NULL, a function to call in order to free aux
+ */
+void scene_add_solver(
+    scene_t *scene,
+    force_creator_t solver,
+    void *aux,
+    list_t *bodies,
+    free_func_t freer
+);
+
+/**
+ * Lets the force creator most recently added to a scene be forked,
+ * by copying its auxiliary value.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param copier the function that copies the force creator's aux
+ */
+void scene_set_force_copier(scene_t *scene, force_copier_t copier);
+
+/**
+ * Adds a built-in force to a scene,
+ * to be evaluated every time scene_tick() is called.
+ * The force is copied into the scene's array of forces of the same kind.
+ * It is removed when its body1 or (if non-NULL) body2 is removed,
+ * at which point its aux is passed to its freer, if it has one.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param kind the kind of force, which determines how it is evaluated
+ * @param force the parameters of the force
+ */
+void scene_add_typed_force(scene_t *scene, force_kind_t kind, aux_t *force);
+
+/**
+ * Sets a linear drag that slows every body in a scene.
+ * Unlike create_drag() or create_bulk_drag(), this is not a force creator:
+ * the drag is folded into the integration of each body as exponential
+ * damping (see body_tick_with_drag()), so it is exact and costs no extra pass.
+ * Bodies with infinite mass are unaffected.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param gamma the drag coefficient, or 0 to disable the drag
+ */
+void scene_set_drag(scene_t *scene, double gamma);
+
+/**
+ * Gets the linear drag set by scene_set_drag().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the drag coefficient (initially 0)
+ */
+double scene_get_drag(scene_t *scene);
+
+/**
+ * A function called on a body with the BOUNDS_CALLBACK policy
+ * that has ended a tick outside its scene's world bounds.
+ * It is called after the tick's integration, on the calling thread,
+ * so it may move or remove the body or change the scene.
+ */
+typedef void (*bounds_handler_t)(scene_t *scene, body_t *body, void *aux);
+
+/**
+ * Gives a scene a box that its bodies are kept in,
+ * according to each body's bounds policy (see bounds_policy_t).
+ * The policies are applied to the bodies' bounding boxes as each body is
+ * integrated, so they cost no scan of the scene or copy of any shape.
+ * Bodies removed by the BOUNDS_REMOVE policy are removed like
+ * scene_remove_handle(), and are reaped and freed before the tick ends.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param bounds the world bounds
+ * @param handler if non-NULL, the function to call on bodies with the
+ *   BOUNDS_CALLBACK policy that leave the bounds
+ * @param aux an argument to pass to the handler, which the scene doesn't own
+ */
+void scene_set_bounds(
+    scene_t *scene,
+    aabb_t bounds,
+    bounds_handler_t handler,
+    void *aux
+);
+
+/**
+ * Removes a scene's world bounds, so bodies may go anywhere
+ * whatever their bounds policies.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+void scene_clear_bounds(scene_t *scene);
+
+/**
+ * Sets the number of threads a scene's ticks are split between,
+ * starting a worker pool owned by the scene (see worker_pool_init()).
+ * Each tick, the built-in gravity, spring, and drag forces and
+ * the checks for collisions run together, split between the threads,
+ * and then the integration of the bodies is. Forces are computed into
+ * separate outputs and applied in a fixed order, and collision handlers
+ * are called in order on the calling thread, so ticks give bit-identical
+ * results for any number of threads, as long as force creators and
+ * collision handlers don't move bodies.
+ * Force creators, solvers, and removals still run on the calling thread.
+ * Phases with too little work to be worth splitting are not split.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param threads the number of threads to use, at least 1 (the default)
+ */
+void scene_set_threads(scene_t *scene, size_t threads);
+
+/**
+ * Splits a scene's ticks between the threads of a worker pool
+ * like scene_set_threads(), but with a pool that can be shared
+ * with other scenes. Scenes sharing a pool tick one phase at a time,
+ * and may be ticked from different threads at once.
+ * Stops any pool started by scene_set_threads().
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param pool the pool to use, which must outlive the scene,
+ *   or NULL to tick on the calling thread
+ */
+void scene_set_pool(scene_t *scene, worker_pool_t *pool);
+
+/**
+ * Publishes a copy of a scene's bodies to a render buffer
+ * at the end of every scene_tick() and scene_step_fixed(),
+ * so another thread can draw one tick while the next is computed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param buffer a buffer returned from render_buffer_init(),
+ *   which must outlive the scene, or NULL to stop publishing
+ */
+void scene_set_render_buffer(scene_t *scene, render_buffer_t *buffer);
+
+/**
+ * Gets the time interval of the tick a scene is executing,
+ * so force creators that integrate implicitly can use it.
+ * Outside of scene_tick(), this is the interval of the last tick (initially 0).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the dt passed to the current or last call to scene_tick()
+ */
+double scene_get_dt(scene_t *scene);
+
 /**
  * Executes a tick of a given scene over a small time interval.
- * This requires executing all the force creators
+ * This requires evaluating the built-in forces kind by kind,
+ * executing all the force creators, evaluating collisions,
  * and then ticking each body (see body_tick()).
  * If any bodies are marked for removal, they should be removed from the scene
  * and freed, along with any force creators acting on them.
  *
+ * Bodies and forces that force creators, collision handlers, and solvers
+ * add or remove with the scene's functions (scene_add_body(),
+ * scene_remove_handle(), scene_add_bodies_force_creator(),
+ * scene_add_typed_force(), scene_remove_force(), ...) are recorded in a buffer
+ * for the calling thread, and applied together once every force creator
+ * and collision handler has been called (before removed bodies are reaped),
+ * and again once every solver has been called. Bodies removed after that,
+ * by solvers or for leaving the world bounds, are reaped at the end
+ * of the tick. Forces added this way
+ * are first evaluated on the next tick, and bodies added this way
+ * can't be given handles until the buffer is applied. Callbacks that run
+ * on several threads should remove bodies with scene_remove_handle(),
+ * since body_remove() is applied at once.
+ *
  * @param scene a pointer to a scene returned from scene_init()
  * @param dt the time elapsed since the last tick, in seconds
  */
 void scene_tick(scene_t *scene, double dt);
 
+/**
+ * Advances a scene by the time elapsed since the last frame
+ * in ticks of a fixed length, so the simulation behaves the same
+ * regardless of the frame rate.
+ * Time left over that is shorter than a tick is carried to the next frame.
+ * Before each tick, every body's pose is saved (see body_save_pose()),
+ * so bodies can be drawn part of the way through the next tick
+ * with the scene's interpolation alpha (see scene_get_alpha()).
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param frame_dt the time elapsed since the last frame, in seconds
+ * @param fixed_dt the length of each tick, in seconds. Must be positive.
+ * @param max_substeps the most ticks to run in one frame.
+ *   If the scene falls further behind, the extra time is dropped,
+ *   so the simulation slows down instead of spiraling.
+ * @return the number of ticks run
+ */
+size_t scene_step_fixed(
+    scene_t *scene,
+    double frame_dt,
+    double fixed_dt,
+    size_t max_substeps
+);
+
+/**
+ * Gets how far a scene is through its next fixed tick,
+ * i.e. the leftover time from scene_step_fixed() as a fraction of a tick.
+ * Drawing bodies at this fraction of the way from their previous
+ * to their current pose hides the stutter of a fixed tick rate.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the interpolation alpha, from 0 (inclusive) to 1 (exclusive)
+ */
+double scene_get_alpha(scene_t *scene);
+
+/**
+ * A copy of the dynamic state of a scene, kept in one flat buffer
+ * so it can be taken and restored many times a second,
+ * e.g. to step ahead, score the result, and rewind.
+ */
+typedef struct scene_snapshot scene_snapshot_t;
+
+/**
+ * Allocates memory for an empty snapshot.
+ * The same snapshot can be taken many times, reusing its buffer.
+ *
+ * @return the new snapshot
+ */
+scene_snapshot_t *scene_snapshot_init(void);
+
+/**
+ * Releases the memory allocated for a snapshot.
+ *
+ * @param snapshot a snapshot returned from scene_snapshot_init()
+ */
+void scene_snapshot_free(scene_snapshot_t *snapshot);
+
+/**
+ * Gets the size of the buffer a snapshot's state takes up.
+ *
+ * @param snapshot a snapshot returned from scene_snapshot_init()
+ * @return the size of the state stored by the last scene_snapshot(), in bytes
+ */
+size_t scene_snapshot_size(scene_snapshot_t *snapshot);
+
+/**
+ * Copies the dynamic state of a scene into a snapshot, replacing what it held.
+ * This is each body's position, vertices, velocity, orientation, mass,
+ * pending force and impulse, and removal mark, whether each collision
+ * was colliding, the removal marks of force creators, and the scene's
+ * fixed-step accumulator. Anything a force creator keeps in its aux,
+ * such as a neighbor list, is not copied, so ticks after a restore
+ * may differ from the original ticks if a force creator depends on it.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param snapshot a snapshot returned from scene_snapshot_init()
+ */
+void scene_snapshot(scene_t *scene, scene_snapshot_t *snapshot);
+
+/**
+ * Sets a scene's dynamic state back to what it was when a snapshot was taken.
+ * Bodies keep their shapes, whose vertices are overwritten in place.
+ * Fails if bodies or forces have been added to or removed from the scene
+ * since the snapshot was taken (including by a tick that removed bodies),
+ * or if a body's shape has been replaced by one with a different size.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param snapshot a snapshot of the same scene, taken with scene_snapshot()
+ * @return whether the scene was restored; if not, it is left unchanged
+ */
+bool scene_restore(scene_t *scene, scene_snapshot_t *snapshot);
+
+/**
+ * Makes a copy of a scene that can be stepped independently of it,
+ * e.g. to try many actions from the same state.
+ * Bodies share their vertices with the bodies they were copied from
+ * until either is moved (see body_fork()), so a fork of a scene with a lot
+ * of static geometry costs little more than its moving bodies.
+ * Built-in forces are copied, with physics and destructive collisions
+ * getting their own state. Other collision handlers share their aux
+ * with the original scene, so must not have a freer.
+ * Force creators are copied by their copier (see scene_set_force_copier()),
+ * or shared if they have no aux. The fork starts with no worker pool.
+ * The fork has the same world bounds, and shares the bounds handler's aux.
+ *
+ * A scene and its forks may be ticked at the same time on different threads,
+ * but forks of the same scene must be made one at a time.
+ * Forked bodies borrow the info of the bodies they were copied from
+ * (see body_fork()), so a scene can't be freed while it has forks:
+ * scene_free() asserts that every fork has already been freed.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @return the fork, or NULL if a force creator has an aux but no copier,
+ *   or a collision handler owns an aux the scene can't copy
+ */
+scene_t *scene_fork(scene_t *scene);
+
+/**
+ * Finds the bodies in a scene whose bounding boxes overlap a box,
+ * using a grid of the bodies' bounding boxes instead of checking every body.
+ * The grid is rebuilt by the first query after a tick or after bodies are
+ * added or removed, so a body moved by hand since the last tick
+ * (e.g. with body_set_centroid()) may be found at its old position.
+ * Since a query may rebuild the grid, queries must not be made while
+ * the scene is being ticked or queried on another thread.
+ * Bodies marked for removal are not found.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param box the region to search
+ * @param results an array to store the bodies found in, in no particular order
+ * @param capacity the most bodies to store in results
+ * @return the number of bodies found, which may be more than capacity,
+ *   in which case only the first capacity of them are stored
+ */
+size_t scene_query_aabb(
+    scene_t *scene,
+    aabb_t box,
+    body_t **results,
+    size_t capacity
+);
+
+/**
+ * Finds the bodies in a scene whose shapes contain a point.
+ * See scene_query_aabb() for when the results are up to date.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param point the point to search at
+ * @param results an array to store the bodies found in, in no particular order
+ * @param capacity the most bodies to store in results
+ * @return the number of bodies found, which may be more than capacity
+ */
+size_t scene_query_point(
+    scene_t *scene,
+    vector_t point,
+    body_t **results,
+    size_t capacity
+);
+
+/**
+ * Finds the bodies in a scene whose shapes are within a distance of a point,
+ * including bodies that contain the point.
+ * See scene_query_aabb() for when the results are up to date.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param center the point to search around
+ * @param radius the greatest distance to a body's shape
+ * @param results an array to store the bodies found in, in no particular order
+ * @param capacity the most bodies to store in results
+ * @return the number of bodies found, which may be more than capacity
+ */
+size_t scene_query_radius(
+    scene_t *scene,
+    vector_t center,
+    double radius,
+    body_t **results,
+    size_t capacity
+);
+
+/**
+ * Finds where each of a batch of rays first hits a body in a scene,
+ * walking the scene's grid of bounding boxes (see scene_query_aabb())
+ * along each ray and testing it against the edges of the bodies it passes.
+ * Large batches are split between the threads of the scene's worker pool.
+ * A ray that starts inside a body doesn't hit it, so agents can cast rays
+ * from their own centroid. See scene_query_aabb() for when the results
+ * are up to date and which threads may cast rays.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param rays the rays to cast
+ * @param n the number of rays
+ * @param hits an array of n hits, where the i-th ray's first hit is stored
+ * @return the number of rays that hit a body
+ */
+size_t scene_raycast_batch(
+    scene_t *scene,
+    const ray_t *rays,
+    size_t n,
+    ray_hit_t *hits
+);
+
+/**
+ * Finds the first body in a scene that a shape would hit
+ * if moved in a straight line, without moving it.
+ * Both the shape and the bodies must be convex (see find_sweep()).
+ * Bodies the shape already overlaps aren't hit, so a body's own shape
+ * can be cast. See scene_query_aabb() for when the results are up to date.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param shape the vertices of the shape to move, where it starts
+ * @param direction the direction to move in, which needn't be a unit vector
+ * @param max_distance how far to move
+ * @param hit set to the first body hit, the normal it is hit along,
+ *   and how far the shape moves to touch it
+ * @return whether the shape hits a body
+ */
+bool scene_shape_cast(
+    scene_t *scene,
+    list_t *shape,
+    vector_t direction,
+    double max_distance,
+    ray_hit_t *hit
+);
+
+/**
+ * Starts recording how long each phase of a scene's ticks takes
+ * and what it does, for scene_get_stats().
+ * Scenes don't record anything until this is called, so scenes that
+ * nobody inspects, such as forks and the scenes of a batch,
+ * don't pay for the record or for reading the clock during each tick.
+ * When built with -DTRACE, every scene records from the start,
+ * since the phases of a tick are traced as they are recorded.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ */
+void scene_enable_stats(scene_t *scene);
+
+/**
+ * Gets how long each phase of a scene's latest tick took and what it did,
+ * and the spread of each over the last TICK_STATS_WINDOW ticks
+ * (see tick_stats.h for the phases and counters).
+ * Each substep of scene_step_fixed() counts as a tick.
+ * With a worker pool, collision checks run alongside the built-in forces
+ * and are timed with them.
+ *
+ * @param scene a pointer to a scene returned from scene_init()
+ * @param stats set to the latest tick's timings and counters,
+ *   and their minimum, mean, 99th percentile, and maximum over the window,
+ *   or to zero if scene_enable_stats() hasn't been called
+ */
+void scene_get_stats(scene_t *scene, scene_stats_t *stats);
+
 #endif // #ifndef __SCENE_H__
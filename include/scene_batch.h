@@ -0,0 +1,177 @@
+#ifndef __SCENE_BATCH_H__
+#define __SCENE_BATCH_H__
+
+#include <stdbool.h>
+#include "list.h"
+#include "scene.h"
+#include "vector.h"
+
+/**
+ * Many independent scenes stepped together in one process,
+ * e.g. the runs of a parameter sweep. Each scene is built and stepped
+ * by one task on a worker pool, so the scenes are spread over the threads
+ * while each is ticked on a single thread, in the same order as it would be
+ * on its own. Shape templates are shared read-only by every scene.
+ */
+typedef struct scene_batch scene_batch_t;
+
+/**
+ * A function that builds one scene of a batch.
+ * It runs on one of the batch's threads, at the same time as other builders,
+ * so it may only share read-only state with them.
+ *
+ * @param batch the batch, whose templates can be instantiated with
+ *   scene_batch_instance()
+ * @param index the index the scene will have in the batch
+ * @param aux the auxiliary value passed to scene_batch_build()
+ * @return the new scene
+ */
+typedef scene_t *(*scene_builder_t)(
+    scene_batch_t *batch,
+    size_t index,
+    void *aux
+);
+
+/**
+ * A function that decides whether one scene of a batch is done running.
+ *
+ * @param scene the scene
+ * @param index the index of the scene in the batch
+ * @param aux the auxiliary value passed to scene_batch_run()
+ * @return whether to stop ticking the scene
+ */
+typedef bool (*scene_done_t)(scene_t *scene, size_t index, void *aux);
+
+/**
+ * A function that measures a result of one scene of a batch.
+ *
+ * @param scene the scene
+ * @param index the index of the scene in the batch
+ * @param aux the auxiliary value passed to scene_batch_measure()
+ * @return the result
+ */
+typedef double (*scene_measure_t)(scene_t *scene, size_t index, void *aux);
+
+/**
+ * Allocates memory for an empty batch of scenes
+ * and starts the threads to step them on.
+ *
+ * @param threads the number of threads to spread the scenes over, at least 1
+ * @return the new batch
+ */
+scene_batch_t *scene_batch_init(size_t threads);
+
+/**
+ * Releases the memory allocated for a batch, along with its scenes
+ * and templates, and stops its threads.
+ *
+ * @param batch a batch returned from scene_batch_init()
+ */
+void scene_batch_free(scene_batch_t *batch);
+
+/**
+ * Adds a shape template to a batch, which scenes can make copies of.
+ * Templates must be added before building the scenes that use them.
+ *
+ * @param batch a batch returned from scene_batch_init()
+ * @param shape the vertices of the template. The batch takes ownership
+ *   of the list, whose freer should free the vectors.
+ * @return the index of the template
+ */
+size_t scene_batch_add_template(scene_batch_t *batch, list_t *shape);
+
+/**
+ * Makes a copy of a shape template with its centroid at a position.
+ * Can be called from any thread, e.g. by a scene_builder_t.
+ *
+ * @param batch a batch returned from scene_batch_init()
+ * @param template the index returned from scene_batch_add_template()
+ * @param centroid where to put the centroid of the copy
+ * @return a newly allocated list of the copy's vertices, e.g. for body_init()
+ */
+list_t *scene_batch_instance(
+    scene_batch_t *batch,
+    size_t template,
+    vector_t centroid
+);
+
+/**
+ * Builds scenes and adds them to a batch, one scene per task.
+ *
+ * @param batch a batch returned from scene_batch_init()
+ * @param count the number of scenes to build
+ * @param build the function that builds each scene
+ * @param aux an auxiliary value to pass to build
+ */
+void scene_batch_build(
+    scene_batch_t *batch,
+    size_t count,
+    scene_builder_t build,
+    void *aux
+);
+
+/**
+ * Gets the number of scenes in a batch.
+ *
+ * @param batch a batch returned from scene_batch_init()
+ * @return the number of scenes built
+ */
+size_t scene_batch_size(scene_batch_t *batch);
+
+/**
+ * Gets one of the scenes in a batch.
+ * Asserts that the index is valid.
+ *
+ * @param batch a batch returned from scene_batch_init()
+ * @param index the index of the scene, in the order they were built
+ * @return the scene, which is freed along with the batch
+ */
+scene_t *scene_batch_get(scene_batch_t *batch, size_t index);
+
+/**
+ * Gets the number of ticks a scene in a batch has run.
+ * Asserts that the index is valid.
+ *
+ * @param batch a batch returned from scene_batch_init()
+ * @param index the index of the scene
+ * @return the total number of ticks run by scene_batch_run()
+ */
+size_t scene_batch_steps(scene_batch_t *batch, size_t index);
+
+/**
+ * Ticks every scene in a batch until it is done,
+ * or until it has run a number of ticks, one scene per task.
+ * Each scene is ticked exactly as if it were ticked on its own.
+ *
+ * @param batch a batch returned from scene_batch_init()
+ * @param dt the time interval of each tick, in seconds
+ * @param max_steps the most ticks to run each scene for
+ * @param done checked before each tick to stop a scene early,
+ *   or NULL to run every scene for max_steps ticks
+ * @param aux an auxiliary value to pass to done
+ */
+void scene_batch_run(
+    scene_batch_t *batch,
+    double dt,
+    size_t max_steps,
+    scene_done_t done,
+    void *aux
+);
+
+/**
+ * Measures a result of every scene in a batch, one scene per task.
+ *
+ * @param batch a batch returned from scene_batch_init()
+ * @param measure the function that measures each scene
+ * @param aux an auxiliary value to pass to measure
+ * @param results an array to store the result of each scene in,
+ *   with room for scene_batch_size() results
+ */
+void scene_batch_measure(
+    scene_batch_t *batch,
+    scene_measure_t measure,
+    void *aux,
+    double *results
+);
+
+#endif // #ifndef __SCENE_BATCH_H__
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include "color.h"
 #include "list.h"
+#include "render_buffer.h"
 #include "scene.h"
 #include "vector.h"
 
@@ -86,6 +87,26 @@ void sdl_show(void);
  */
 void sdl_render_scene(scene_t *scene);
 
+/**
+ * Draws all bodies in a scene part of the way between their previous
+ * and current poses (see body_get_interpolated_shape()).
+ * Like sdl_render_scene(), this clears and shows the frame.
+ *
+ * @param scene the scene to draw
+ * @param alpha how far to interpolate, usually scene_get_alpha()
+ */
+void sdl_render_scene_interpolated(scene_t *scene, double alpha);
+
+/**
+ * Draws the bodies of a frame published by another thread,
+ * interpolated by the frame's alpha. Only reads the frame,
+ * so the scene can be ticked while it is drawn.
+ * Like sdl_render_scene(), this clears and shows the frame.
+ *
+ * @param frame the frame to draw, usually from render_buffer_acquire()
+ */
+void sdl_render_frame(const render_frame_t *frame);
+
 /**
  * Registers a function to be called every time a key is pressed.
  * Overwrites any existing handler.
@@ -0,0 +1,112 @@
+#ifndef __SPATIAL_INDEX_H__
+#define __SPATIAL_INDEX_H__
+
+#include <stdbool.h>
+#include "body.h"
+#include "list.h"
+#include "polygon.h"
+
+/**
+ * A uniform grid over the bounding boxes of a set of bodies,
+ * for finding the bodies in a region without checking every body.
+ * Each body is listed in every cell its bounding box overlaps,
+ * and the cells are sized from the bodies' typical size,
+ * so a query checks a number of bodies proportional to the number it finds.
+ * The bounding boxes are cached when the index is built,
+ * so the index must be rebuilt after the bodies move.
+ */
+typedef struct spatial_index spatial_index_t;
+
+/**
+ * A function that decides whether a body found by a query is a hit.
+ *
+ * @param body a body whose bounding box overlaps the query's box
+ * @param aux the auxiliary value passed to spatial_index_query()
+ * @return whether to report the body
+ */
+typedef bool (*body_filter_t)(body_t *body, void *aux);
+
+/**
+ * A function that tests a ray against a body found along it.
+ *
+ * @param body a body whose bounding box the ray passes through
+ * @param aux the auxiliary value passed to spatial_index_raycast()
+ * @return the distance along the ray at which it hits the body,
+ *   or INFINITY if it misses
+ */
+typedef double (*ray_test_t)(body_t *body, void *aux);
+
+/**
+ * Allocates memory for an empty spatial index.
+ *
+ * @return the new index
+ */
+spatial_index_t *spatial_index_init(void);
+
+/**
+ * Releases the memory allocated for a spatial index, but not its bodies.
+ *
+ * @param index an index returned from spatial_index_init()
+ */
+void spatial_index_free(spatial_index_t *index);
+
+/**
+ * Indexes the current bounding boxes of a set of bodies,
+ * replacing whatever the index held. Bodies marked for removal are skipped.
+ *
+ * @param index an index returned from spatial_index_init()
+ * @param bodies the list of bodies to index, which must not be freed
+ *   while the index refers to them
+ */
+void spatial_index_build(spatial_index_t *index, list_t *bodies);
+
+/**
+ * Finds the indexed bodies whose bounding boxes overlap a box,
+ * each reported once, in no particular order.
+ * Only reads the index, so queries can run on several threads at once.
+ *
+ * @param index an index returned from spatial_index_init()
+ * @param box the region to search
+ * @param filter if non-NULL, a test each body must pass to be reported
+ * @param aux an auxiliary value to pass to filter
+ * @param results an array to store the bodies found in
+ * @param capacity the most bodies to store in results
+ * @return the number of bodies found, which may be more than capacity
+ */
+size_t spatial_index_query(
+    spatial_index_t *index,
+    aabb_t box,
+    body_filter_t filter,
+    void *aux,
+    body_t **results,
+    size_t capacity
+);
+
+/**
+ * Finds the first indexed body a ray hits, walking the grid's cells
+ * in the order the ray passes through them and stopping at the first cell
+ * that ends past the nearest hit found so far.
+ * Only reads the index, so raycasts can run on several threads at once.
+ *
+ * @param index an index returned from spatial_index_init()
+ * @param origin the point the ray starts from
+ * @param direction the unit vector the ray points along
+ * @param max_distance how far along the ray to look
+ * @param test tests the ray against each body whose bounding box it enters;
+ *   may be called more than once for a body
+ * @param aux an auxiliary value to pass to test
+ * @param distance set to the distance to the hit, if there is one
+ * @return the body with the nearest hit closer than max_distance,
+ *   or NULL if there is none
+ */
+body_t *spatial_index_raycast(
+    spatial_index_t *index,
+    vector_t origin,
+    vector_t direction,
+    double max_distance,
+    ray_test_t test,
+    void *aux,
+    double *distance
+);
+
+#endif // #ifndef __SPATIAL_INDEX_H__
@@ -0,0 +1,95 @@
+#ifndef __SPRING_NETWORK_H__
+#define __SPRING_NETWORK_H__
+
+#include <stdbool.h>
+#include "scene.h"
+
+/**
+ * A set of springs between bodies, stored as an edge list.
+ * Each spring is a (body1, body2, k, rest length, damping) record indexing
+ * into the network's list of bodies, and the whole network is evaluated
+ * by a single force creator in one pass over the springs.
+ */
+typedef struct spring_network spring_network_t;
+
+/**
+ * Adds a force creator to a scene that evaluates a network of springs.
+ * Springs are added afterwards with spring_network_add().
+ * The network is removed from the scene if any of its bodies are removed.
+ * The network is integrated explicitly, like create_spring(),
+ * unless spring_network_set_implicit() is called.
+ *
+ * @param scene the scene containing the bodies
+ * @param bodies the bodies the springs connect, referred to by index
+ *   in spring_network_add(). The scene takes ownership of this list,
+ *   which does not own the bodies, so its freer should be NULL.
+ * @return the network, which is freed along with the scene
+ */
+spring_network_t *create_spring_network(scene_t *scene, list_t *bodies);
+
+/**
+ * Adds a spring to a spring network.
+ * The spring pulls the bodies together with force k * (|d| - rest_length),
+ * where d is the displacement between their centroids, and resists
+ * their relative velocity along d with coefficient damping.
+ * A spring with rest length 0 and no damping matches create_spring().
+ *
+ * @param network a network returned from create_spring_network()
+ * @param body1 the index of the first body in the network's bodies
+ * @param body2 the index of the second body in the network's bodies
+ * @param k the Hooke's constant for the spring
+ * @param rest_length the length at which the spring exerts no force
+ * @param damping the damping coefficient along the spring
+ */
+void spring_network_add(
+    spring_network_t *network,
+    size_t body1,
+    size_t body2,
+    double k,
+    double rest_length,
+    double damping
+);
+
+/**
+ * Gets the number of springs in a spring network.
+ *
+ * @param network a network returned from create_spring_network()
+ * @return the number of springs added with spring_network_add()
+ */
+size_t spring_network_size(spring_network_t *network);
+
+/**
+ * Switches a spring network between explicit and implicit integration.
+ * An explicit network applies the spring forces to its bodies each tick,
+ * which is only stable while dt is small compared to sqrt(mass / k).
+ * An implicit network instead solves for the change in velocity
+ * that the springs cause over the tick, using the spring forces at the end
+ * of the tick (linearized around the current positions), and applies it
+ * as an impulse. This is stable for any stiffness and dt,
+ * at the cost of a conjugate-gradient solve over the springs every tick.
+ * Bodies with infinite mass are held fixed by the solve.
+ *
+ * @param network a network returned from create_spring_network()
+ * @param implicit whether to integrate the network implicitly
+ */
+void spring_network_set_implicit(spring_network_t *network, bool implicit);
+
+/**
+ * Gets the number of conjugate-gradient iterations the last implicit solve
+ * of a spring network took to converge.
+ *
+ * @param network a network returned from create_spring_network()
+ * @return the number of iterations, or 0 if the network is explicit
+ */
+size_t spring_network_iterations(spring_network_t *network);
+
+/**
+ * Calculates the forces of every spring in a network and applies them
+ * to the network's bodies, or the impulses of the springs over the tick
+ * if the network is implicit.
+ *
+ * @param network a network returned from create_spring_network()
+ */
+void spring_network_creator(void *network);
+
+#endif // #ifndef __SPRING_NETWORK_H__
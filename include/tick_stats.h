@@ -0,0 +1,159 @@
+#ifndef __TICK_STATS_H__
+#define __TICK_STATS_H__
+
+#include <stddef.h>
+
+/**
+ * The phases of a tick, in the order scene_tick() runs them.
+ */
+typedef enum {
+  // Built-in forces, and collision checks split between threads
+  TICK_PHASE_FORCES,
+  // Force creators other than solvers
+  TICK_PHASE_CREATORS,
+  // Collision checks not split between threads, and collision handlers
+  TICK_PHASE_COLLISIONS,
+  // Applying the bodies and forces added or removed by callbacks
+  TICK_PHASE_COMMANDS,
+  // Finding the forces that act on removed bodies
+  TICK_PHASE_REMOVAL_SCAN,
+  // Removing bodies and forces from the scene's arrays
+  TICK_PHASE_COMPACTION,
+  TICK_PHASE_SOLVERS,
+  // Moving the bodies
+  TICK_PHASE_INTEGRATION,
+  NUM_TICK_PHASES
+} tick_phase_t;
+
+/**
+ * The things counted during a tick.
+ */
+typedef enum {
+  // Built-in forces, force creators, and solvers evaluated
+  TICK_FORCES_EVALUATED,
+  // Collision records checked for a collision
+  TICK_PAIR_TESTS,
+  // Separating axes of the shapes in the pairs tested
+  TICK_SAT_AXES,
+  // Pair tests that found a collision
+  TICK_COLLISIONS,
+  TICK_BODIES_REMOVED,
+  // Built-in forces and force creators removed
+  TICK_FORCES_REMOVED,
+  // Allocations and reallocations of the scene's own arrays,
+  // not counting those made by callbacks, bodies, or lists
+  TICK_ALLOCATIONS,
+  NUM_TICK_COUNTERS
+} tick_counter_t;
+
+/**
+ * The spread of a statistic over the ticks in a window.
+ */
+typedef struct stat_summary {
+  double min;
+  double mean;
+  // The value 99% of the ticks are at or below
+  double p99;
+  double max;
+} stat_summary_t;
+
+/**
+ * Timings and counters of a scene's latest tick,
+ * and their spread over its recent ticks.
+ * Times are wall-clock seconds.
+ */
+typedef struct scene_stats {
+  // Number of ticks the summaries are over, at most TICK_STATS_WINDOW
+  size_t ticks;
+  // The latest tick, or zero before the first tick
+  double tick_time;
+  double phase_times[NUM_TICK_PHASES];
+  size_t counters[NUM_TICK_COUNTERS];
+  // Summaries over the window, or zero before the first tick
+  stat_summary_t tick_summary;
+  stat_summary_t phase_summaries[NUM_TICK_PHASES];
+  stat_summary_t counter_summaries[NUM_TICK_COUNTERS];
+} scene_stats_t;
+
+/**
+ * The name of each phase, e.g. for printing stats.
+ */
+extern const char *const TICK_PHASE_NAMES[NUM_TICK_PHASES];
+
+/**
+ * The number of most recent ticks summarized in scene_stats_t.
+ */
+extern const size_t TICK_STATS_WINDOW;
+
+/**
+ * Records the timings and counters of each tick
+ * over a rolling window of ticks.
+ * Every function but tick_stats_init() and tick_stats_free() also takes
+ * NULL for a record that is disabled, and then does nothing,
+ * so code can be instrumented whether or not anything is recorded.
+ * When built with -DTRACE, each phase is also recorded in the trace
+ * (see trace.h).
+ */
+typedef struct tick_stats tick_stats_t;
+
+/**
+ * Allocates memory for a record of no ticks.
+ *
+ * @return the new record
+ */
+tick_stats_t *tick_stats_init(void);
+
+/**
+ * Releases the memory allocated for a record of ticks.
+ *
+ * @param stats a record returned from tick_stats_init()
+ */
+void tick_stats_free(tick_stats_t *stats);
+
+/**
+ * Starts recording a tick, with every time and counter at zero,
+ * and starts timing its first phase.
+ *
+ * @param stats a record returned from tick_stats_init(), or NULL
+ */
+void tick_stats_begin(tick_stats_t *stats);
+
+/**
+ * Adds the time since the tick began or the last lap to a phase,
+ * and starts timing the next phase.
+ * A phase may be timed in several laps.
+ *
+ * @param stats a record returned from tick_stats_init(), or NULL
+ * @param phase the phase that just ended
+ */
+void tick_stats_lap(tick_stats_t *stats, tick_phase_t phase);
+
+/**
+ * Adds to a counter of the tick being recorded.
+ * Counts made outside a tick are dropped when the next tick begins.
+ *
+ * @param stats a record returned from tick_stats_init(), or NULL
+ * @param counter the counter to add to
+ * @param n the amount to add
+ */
+void tick_stats_count(tick_stats_t *stats, tick_counter_t counter, size_t n);
+
+/**
+ * Finishes recording a tick, adding it to the window
+ * in place of the oldest tick if the window is full.
+ *
+ * @param stats a record returned from tick_stats_init(), or NULL
+ */
+void tick_stats_end(tick_stats_t *stats);
+
+/**
+ * Gets the latest tick's timings and counters and summarizes the window.
+ * Takes time proportional to TICK_STATS_WINDOW, so is meant to be
+ * called about once a frame rather than once a phase.
+ *
+ * @param stats a record returned from tick_stats_init(), or NULL
+ * @param summary set to the latest tick and the summaries of the window
+ */
+void tick_stats_summarize(tick_stats_t *stats, scene_stats_t *summary);
+
+#endif // #ifndef __TICK_STATS_H__
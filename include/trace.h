@@ -0,0 +1,82 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdbool.h>
+
+/**
+ * A timeline of what each thread was doing, for finding stalls,
+ * uneven splits of work between threads, and slow frames.
+ * Build with -DTRACE to record it; otherwise the TRACE_ macros
+ * compile to nothing and the program runs exactly as without tracing.
+ *
+ * Each thread records its events in a ring buffer of its own,
+ * so recording never takes a lock or waits for another thread.
+ * Once a thread has recorded TRACE_EVENTS events, each new event
+ * replaces its oldest. The buffers are kept until the program exits.
+ *
+ * The timeline is written as Chrome trace-event JSON,
+ * which can be opened in Perfetto (ui.perfetto.dev) or chrome://tracing.
+ * Event names must be string literals (or otherwise live until the trace
+ * is written), without quotes or backslashes.
+ */
+
+#ifdef TRACE
+/** Marks the start of a span of work on the calling thread */
+#define TRACE_BEGIN(name) trace_event(name, 'B')
+/** Marks the end of the span most recently begun on the calling thread */
+#define TRACE_END(name) trace_event(name, 'E')
+/** Records a span that has already ended, timed with trace_now() */
+#define TRACE_SPAN(name, start, end) trace_span(name, start, end)
+/** Writes every thread's events to a file */
+#define TRACE_WRITE(path) trace_write(path)
+#else
+#define TRACE_BEGIN(name) ((void) 0)
+#define TRACE_END(name) ((void) 0)
+#define TRACE_SPAN(name, start, end) ((void) 0)
+#define TRACE_WRITE(path) ((void) 0)
+#endif
+
+/**
+ * The most events kept for each thread.
+ */
+extern const unsigned long TRACE_EVENTS;
+
+/**
+ * Gets the time events are recorded with.
+ *
+ * @return wall-clock seconds from an arbitrary start
+ */
+double trace_now(void);
+
+/**
+ * Records an event on the calling thread at the current time.
+ * Use the TRACE_BEGIN() and TRACE_END() macros instead,
+ * which are removed when tracing is disabled.
+ *
+ * @param name what the thread is doing
+ * @param phase 'B' to begin a span or 'E' to end one
+ */
+void trace_event(const char *name, char phase);
+
+/**
+ * Records a span of work on the calling thread that has already ended.
+ * Use the TRACE_SPAN() macro instead.
+ *
+ * @param name what the thread did
+ * @param start when the span started, from trace_now()
+ * @param end when the span ended, from trace_now()
+ */
+void trace_span(const char *name, double start, double end);
+
+/**
+ * Writes the events recorded by every thread as Chrome trace-event JSON.
+ * Threads should be idle while the trace is written (e.g. between frames),
+ * since an event recorded meanwhile may replace one being written.
+ * Use the TRACE_WRITE() macro instead.
+ *
+ * @param path the file to write the trace to, which is replaced
+ * @return whether the file was written
+ */
+bool trace_write(const char *path);
+
+#endif // #ifndef __TRACE_H__
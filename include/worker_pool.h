@@ -0,0 +1,124 @@
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <stddef.h>
+
+/**
+ * A fixed set of threads that stay alive between jobs, so work can be split
+ * between them every tick without creating and joining threads each time.
+ * A thread waiting for a job runs parts of it too, so a pool of n threads
+ * starts n - 1 threads of its own.
+ * A pool may be shared between scenes (see scene_set_pool()),
+ * and jobs may be submitted from any thread, including from inside tasks.
+ *
+ * Each of the pool's threads keeps a deque of ranges of indices to run.
+ * A thread with nothing queued splits the upper half off the range
+ * it is running, until the range is small, and idle threads steal
+ * the largest queued ranges. Jobs whose indices take very different
+ * amounts of time are thus still spread evenly over the threads.
+ */
+typedef struct worker_pool worker_pool_t;
+
+/**
+ * A job submitted to a worker pool, which can be waited for
+ * or given as a dependency of other jobs.
+ */
+typedef struct pool_job pool_job_t;
+
+/**
+ * A function that does the part of a job with indices in [start, end).
+ * Parts of the same job run at the same time on different threads,
+ * so they must not write to the same memory.
+ *
+ * @param aux the auxiliary value passed to worker_pool_submit()
+ * @param start the first index to process
+ * @param end one past the last index to process
+ */
+typedef void (*pool_task_t)(void *aux, size_t start, size_t end);
+
+/**
+ * Allocates memory for a worker pool and starts its threads.
+ * Asserts that the threads are started.
+ *
+ * @param threads the number of threads to split jobs between, at least 1,
+ *   including the thread that runs each job
+ * @return the new pool
+ */
+worker_pool_t *worker_pool_init(size_t threads);
+
+/**
+ * Stops a worker pool's threads and releases its memory.
+ * Must not be called while a job is running.
+ *
+ * @param pool a pool returned from worker_pool_init()
+ */
+void worker_pool_free(worker_pool_t *pool);
+
+/**
+ * Gets the number of threads a worker pool splits jobs between.
+ *
+ * @param pool a pool returned from worker_pool_init()
+ * @return the threads passed to worker_pool_init()
+ */
+size_t worker_pool_threads(worker_pool_t *pool);
+
+/**
+ * Gets the index of the calling thread among a worker pool's threads,
+ * e.g. so each thread running parts of a job can write to its own buffer.
+ *
+ * @param pool a pool returned from worker_pool_init()
+ * @return from 1 to worker_pool_threads() - 1 on the pool's own threads,
+ *   or 0 on any other thread, such as the one that submitted the job
+ */
+size_t worker_pool_thread_index(worker_pool_t *pool);
+
+/**
+ * Submits a job to a worker pool, to start once its dependencies are done.
+ * The job's indices are split into ranges of varying sizes,
+ * which may run in any order on any thread.
+ * Every job must be waited for with worker_pool_wait(), which frees it.
+ *
+ * @param pool a pool returned from worker_pool_init()
+ * @param task the function that does each part of the job
+ * @param aux an auxiliary value to pass to the task
+ * @param count the number of indices in the job
+ * @param deps the jobs that must be done before this one starts,
+ *   which must not have been waited for yet
+ * @param dep_count the number of jobs in deps
+ * @return the job, which is freed by worker_pool_wait()
+ */
+pool_job_t *worker_pool_submit(
+    worker_pool_t *pool,
+    pool_task_t task,
+    void *aux,
+    size_t count,
+    pool_job_t **deps,
+    size_t dep_count
+);
+
+/**
+ * Waits for a job to be done, running queued parts of any job meanwhile,
+ * and frees it.
+ *
+ * @param pool the pool the job was submitted to
+ * @param job a job returned from worker_pool_submit()
+ */
+void worker_pool_wait(worker_pool_t *pool, pool_job_t *job);
+
+/**
+ * Runs a job with no dependencies and waits for it to be done.
+ * Equivalent to worker_pool_submit() followed by worker_pool_wait().
+ *
+ * @param pool a pool returned from worker_pool_init()
+ * @param task the function that does each part of the job
+ * @param aux an auxiliary value to pass to the task
+ * @param count the number of indices in the job
+ */
+void worker_pool_run(
+    worker_pool_t *pool,
+    pool_task_t task,
+    void *aux,
+    size_t count
+);
+
+#endif // #ifndef __WORKER_POOL_H__
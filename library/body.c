@@ -5,21 +5,34 @@
 #include <assert.h>
 #include "polygon.h"
 #include "vector.h"
+#include "hot_counters.h"
+#include <math.h>
+#include <string.h>
 
 body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
   body_t *toReturn = malloc(sizeof(body_t));
   assert(toReturn != NULL);
   toReturn->shape = shape;
+  toReturn->shape_owners = NULL;
   toReturn->mass = mass;
   toReturn->color = color;
   toReturn->centroid = polygon_centroid(shape);
   toReturn->velocity = (vector_t) {0.0, 0.0};
   toReturn->orientation = 0.0;
+  toReturn->prev_centroid = toReturn->centroid;
+  toReturn->prev_orientation = 0.0;
   toReturn->force = (vector_t) {0, 0};
   toReturn->impulse = (vector_t) {0, 0};
   toReturn->forRemoval = 0;
   toReturn->info = NULL;
   toReturn->info_freer = NULL;
+  toReturn->force_refs = NULL;
+  toReturn->force_ref_count = 0;
+  toReturn->force_ref_capacity = 0;
+  toReturn->graveyard = NULL;
+  toReturn->slot = 0;
+  toReturn->bounds = polygon_bounds(shape);
+  toReturn->bounds_policy = BOUNDS_IGNORE;
   return toReturn;
 }
 
@@ -32,15 +45,24 @@ body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color, void
   }
 
 void body_free(body_t *body){
-  list_free(body->shape);
+  if (body->shape_owners == NULL) {
+    list_free(body->shape);
+  }
+  else if (atomic_fetch_sub(body->shape_owners, 1) == 1) {
+    list_free(body->shape);
+    free(body->shape_owners);
+  }
   if (body->info_freer != NULL && body->info != NULL){
     body->info_freer(body->info);
   }
+  free(body->force_refs);
   free(body);
 }
 
 list_t *body_get_shape(body_t *body) {
   list_t *copy = list_init(list_size(body->shape), free);
+  HOT_COUNT(HOT_SHAPE_COPIES, 1);
+  HOT_COUNT(HOT_ALLOCATIONS, list_size(body->shape));
   for (size_t i = 0; i < list_size(body->shape); i++) {
     vector_t *vec_copy = malloc(sizeof(vector_t));
     *vec_copy = *(vector_t *)(list_get(body->shape, i));
@@ -49,6 +71,50 @@ list_t *body_get_shape(body_t *body) {
   return copy;
 }
 
+body_t *body_fork(body_t *body) {
+  body_t *copy = malloc(sizeof(body_t));
+  assert(copy != NULL);
+  *copy = *body;
+  if (body->shape_owners == NULL) {
+    body->shape_owners = malloc(sizeof(atomic_size_t));
+    assert(body->shape_owners != NULL);
+    atomic_init(body->shape_owners, 1);
+  }
+  atomic_fetch_add(body->shape_owners, 1);
+  copy->shape_owners = body->shape_owners;
+  copy->info_freer = NULL;
+  copy->force_refs = NULL;
+  if (body->force_ref_capacity > 0) {
+    copy->force_refs = malloc(body->force_ref_capacity * sizeof(force_ref_t));
+    assert(copy->force_refs != NULL);
+    memcpy(copy->force_refs, body->force_refs, \
+      body->force_ref_count * sizeof(force_ref_t));
+  }
+  copy->graveyard = NULL;
+  return copy;
+}
+
+void body_unshare_shape(body_t *body) {
+  atomic_size_t *owners = body->shape_owners;
+  if (owners == NULL) {
+    return;
+  }
+  body->shape_owners = NULL;
+  // The last owner can take the shape back, since nothing else can see it
+  if (atomic_load(owners) == 1) {
+    free(owners);
+    return;
+  }
+  list_t *shared = body->shape;
+  body->shape = body_get_shape(body);
+  // Other owners may have copied the shape at the same time,
+  // leaving this body the last to let go of it
+  if (atomic_fetch_sub(owners, 1) == 1) {
+    list_free(shared);
+    free(owners);
+  }
+}
+
 vector_t body_get_centroid(body_t *body) {
   return body->centroid;
 }
@@ -81,11 +147,27 @@ void *body_get_info(body_t *body){
   return body->info;
 }
 
+aabb_t body_get_bounds(body_t *body) {
+  return body->bounds;
+}
+
+bounds_policy_t body_get_bounds_policy(body_t *body) {
+  return body->bounds_policy;
+}
+
 void body_set_centroid(body_t *body, vector_t x) {
   double x_disp = x.x - body->centroid.x;
   double y_disp = x.y - body->centroid.y;
   body->centroid = x;
+  // Bodies at rest are not moved, so they can keep sharing their vertices
+  if (x_disp == 0 && y_disp == 0) {
+    return;
+  }
+  body_unshare_shape(body);
   polygon_translate(body->shape, (vector_t) {x_disp, y_disp});
+  // Moved the same way as the vertices, so it matches them exactly
+  body->bounds.min = vec_add(body->bounds.min, (vector_t) {x_disp, y_disp});
+  body->bounds.max = vec_add(body->bounds.max, (vector_t) {x_disp, y_disp});
 }
 
 void body_set_velocity(body_t *body, vector_t v) {
@@ -100,9 +182,15 @@ void body_set_mass(body_t *body, double mass) {
   body->mass = mass;
 }
 
+void body_set_bounds_policy(body_t *body, bounds_policy_t policy) {
+  body->bounds_policy = policy;
+}
+
 void body_set_rotation(body_t *body, double angle) {
+  body_unshare_shape(body);
   polygon_rotate(body->shape, angle - body->orientation, body->centroid);
   body->centroid = polygon_centroid(body->shape);
+  body->bounds = polygon_bounds(body->shape);
   body->orientation = angle;
 }
 
@@ -133,7 +221,82 @@ void body_tick(body_t *body, double dt) {
   body->impulse = (vector_t) {0, 0};
 }
 
+void body_tick_with_drag(body_t *body, double dt, double gamma) {
+  if (gamma == 0 || body->mass == INFINITY) {
+    body_tick(body, dt);
+    return;
+  }
+  // Velocity relaxes towards the terminal velocity at rate gamma / mass
+  double rate = gamma / body->mass;
+  double decay = exp(-rate * dt);
+  // (1 - decay) / rate, computed without cancellation for small rate * dt
+  double travel = -expm1(-rate * dt) / rate;
+  vector_t terminal = vec_multiply(1 / gamma, body->force);
+  vector_t relative = vec_subtract(body->velocity, terminal);
+  vector_t new_v = vec_add(terminal, vec_multiply(decay, relative));
+  vector_t disp = vec_add(vec_multiply(dt, terminal),
+    vec_multiply(travel, relative));
+
+  // Adds impulse the same way as body_tick()
+  vector_t delta_v = vec_multiply(1 / body->mass, body->impulse);
+  new_v = vec_add(new_v, delta_v);
+  disp = vec_add(disp, vec_multiply(dt / 2.0, delta_v));
+  body_set_centroid(body, vec_add(body->centroid, disp));
+
+  body->velocity = new_v;
+  body->force = (vector_t) {0, 0};
+  body->impulse = (vector_t) {0, 0};
+}
+
+void body_save_pose(body_t *body) {
+  body->prev_centroid = body->centroid;
+  body->prev_orientation = body->orientation;
+}
+
+vector_t body_get_interpolated_centroid(body_t *body, double alpha) {
+  vector_t moved = vec_subtract(body->centroid, body->prev_centroid);
+  return vec_add(body->prev_centroid, vec_multiply(alpha, moved));
+}
+
+double body_get_interpolated_orientation(body_t *body, double alpha) {
+  return body->prev_orientation + \
+    alpha * (body->orientation - body->prev_orientation);
+}
+
+list_t *body_get_interpolated_shape(body_t *body, double alpha) {
+  list_t *shape = body_get_shape(body);
+  double angle = body_get_interpolated_orientation(body, alpha);
+  polygon_rotate(shape, angle - body->orientation, body->centroid);
+  vector_t centroid = body_get_interpolated_centroid(body, alpha);
+  polygon_translate(shape, vec_subtract(centroid, body->centroid));
+  return shape;
+}
+
+size_t body_add_force_ref(body_t *body, force_ref_t ref) {
+  if (body->force_ref_count == body->force_ref_capacity) {
+    body->force_ref_capacity = 2 * body->force_ref_capacity + 1;
+    body->force_refs = realloc(body->force_refs,
+      body->force_ref_capacity * sizeof(force_ref_t));
+    assert(body->force_refs != NULL);
+  }
+  body->force_refs[body->force_ref_count] = ref;
+  return body->force_ref_count++;
+}
+
+bool body_remove_force_ref(body_t *body, size_t slot) {
+  assert(slot < body->force_ref_count);
+  body->force_ref_count--;
+  if (slot == body->force_ref_count) {
+    return false;
+  }
+  body->force_refs[slot] = body->force_refs[body->force_ref_count];
+  return true;
+}
+
 void body_remove(body_t *body){
+  if (!body->forRemoval && body->graveyard != NULL) {
+    list_add(body->graveyard, body);
+  }
   body->forRemoval = 1;
 }
 
@@ -1,4 +1,5 @@
 #include "collision.h"
+#include "hot_counters.h"
 #include <stdbool.h>
 #include "list.h"
 #include <stdlib.h>
@@ -11,6 +12,7 @@
 const int LARGE = INFINITY;
 
 collision_info_t find_collision(list_t *shape1, list_t *shape2) {
+  HOT_COUNT(HOT_FIND_COLLISION_CALLS, 1);
   list_t *axes = get_axes2(shape1, shape2);
   double overlap = LARGE;
   vector_t collision_axis = {0.0, 0.0};
@@ -22,6 +24,7 @@ collision_info_t find_collision(list_t *shape1, list_t *shape2) {
     double min2 = polygon_proj_min(shape2, *(vector_t*) list_get(axes, i));
     double max2 = polygon_proj_max(shape2, *(vector_t*) list_get(axes, i));
     if ((max2 < min1) || (max1 < min2)) {
+         list_free(axes);
          return info;
        }
        else {
@@ -34,9 +37,81 @@ collision_info_t find_collision(list_t *shape1, list_t *shape2) {
          }
        }
   }
+  list_free(axes);
   return (collision_info_t){true, collision_axis};
 }
 
+/**
+ * The times during a sweep at which the two shapes might overlap.
+ */
+typedef struct sweep_window {
+  double enter;
+  double exit;
+  // The axis the shapes are last to overlap on, facing against the motion
+  vector_t normal;
+} sweep_window_t;
+
+/**
+ * Narrows a sweep's window to when the shapes' projections onto one axis
+ * overlap, returning false if they never do.
+ */
+bool sweep_axis(sweep_window_t *window, list_t *shape1, vector_t displacement, \
+  list_t *shape2, vector_t axis) {
+  double min1 = polygon_proj_min(shape1, axis);
+  double max1 = polygon_proj_max(shape1, axis);
+  double min2 = polygon_proj_min(shape2, axis);
+  double max2 = polygon_proj_max(shape2, axis);
+  double speed = vec_dot(displacement, axis);
+  if (speed == 0) {
+    return max1 >= min2 && max2 >= min1;
+  }
+  double t1 = (min2 - max1) / speed;
+  double t2 = (max2 - min1) / speed;
+  double enter = fmin(t1, t2);
+  double exit = fmax(t1, t2);
+  if (enter > window->enter) {
+    window->enter = enter;
+    window->normal = speed > 0 ? vec_negate(axis) : axis;
+  }
+  window->exit = fmin(window->exit, exit);
+  return window->enter <= window->exit;
+}
+
+/**
+ * Narrows a sweep's window by the edge normals of one of its shapes.
+ */
+bool sweep_edges(sweep_window_t *window, list_t *shape1, vector_t displacement, \
+  list_t *shape2, list_t *edges) {
+  size_t len = list_size(edges);
+  for (size_t i = 0; i < len; i++) {
+    vector_t a = *(vector_t *) list_get(edges, i);
+    vector_t b = *(vector_t *) list_get(edges, (i + 1) % len);
+    vector_t axis = {a.y - b.y, b.x - a.x};
+    double length = sqrt(vec_dot(axis, axis));
+    if (length == 0) {
+      continue;
+    }
+    axis = vec_multiply(1 / length, axis);
+    if (!sweep_axis(window, shape1, displacement, shape2, axis)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+sweep_info_t find_sweep(list_t *shape1, vector_t displacement, list_t *shape2) {
+  sweep_info_t miss = {false, 0, VEC_ZERO};
+  sweep_window_t window = {-INFINITY, INFINITY, VEC_ZERO};
+  if (!sweep_edges(&window, shape1, displacement, shape2, shape1) || \
+    !sweep_edges(&window, shape1, displacement, shape2, shape2)) {
+    return miss;
+  }
+  if (window.enter < 0 || window.enter > 1) {
+    return miss;
+  }
+  return (sweep_info_t) {true, window.enter, window.normal};
+}
+
 double find_min(double first, double second) {
   if (first < second) {
     return first;
@@ -45,6 +120,7 @@ double find_min(double first, double second) {
 }
 vector_t *edge_perp(vector_t vec) {
   vector_t *vec_normal = malloc(sizeof(vector_t));
+  HOT_COUNT(HOT_ALLOCATIONS, 1);
   vec_normal->x =  -1 * vec.y;
   vec_normal->y = vec.x;
   return vec_normal;
@@ -52,6 +128,7 @@ vector_t *edge_perp(vector_t vec) {
 list_t *get_axes1(list_t *shape) {
   size_t len = list_size(shape);
   list_t *result = list_init(len, free);
+  HOT_COUNT(HOT_SAT_AXES, len);
   for (size_t i = 0; i < len; i++) {
     vector_t vec = *(vector_t *)(list_get(shape, i % len));
     vec = vec_subtract(vec, *(vector_t *)(list_get(shape, (i + 1) % len)));
@@ -69,10 +146,16 @@ list_t *get_axes2(list_t *shape1, list_t *shape2) {
   for (size_t i = 0; i < list_size(shape2); i++) {
     list_add(result, list_get(axes2, i));
   }
+  // The axes now belong to the result, so only the lists are freed
+  list_truncate(axes1, 0);
+  list_truncate(axes2, 0);
+  list_free(axes1);
+  list_free(axes2);
   return result;
 }
 
 double polygon_proj_min(list_t *shape, vector_t line) {
+  HOT_COUNT(HOT_PROJECTIONS, 1);
   double min = vec_dot(*(vector_t*) list_get(shape, 0), line);
   for (size_t i = 0; i < list_size(shape); i++) {
     if (vec_dot(*((vector_t*) list_get(shape, i)), line) < min) {
@@ -83,6 +166,7 @@ double polygon_proj_min(list_t *shape, vector_t line) {
 }
 
 double polygon_proj_max(list_t *shape, vector_t line) {
+  HOT_COUNT(HOT_PROJECTIONS, 1);
   double max = vec_dot(*((vector_t*) list_get(shape, 0)), line);
   for (size_t i = 0; i < list_size(shape); i++) {
     if (vec_dot(*((vector_t*) list_get(shape, i)), line) > max) {
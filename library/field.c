@@ -0,0 +1,261 @@
+#include "field.h"
+#include "body.h"
+#include "list.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct field {
+  vector_t origin;
+  double cell_size;
+  size_t cols;
+  size_t rows;
+  // Components of the field at each grid point, row by row
+  double *x;
+  double *y;
+} field_t;
+
+typedef struct field_force {
+  scene_t *scene;
+  field_t *field;
+  list_t *bodies;
+  // Whether the field is a flow to drag the bodies along
+  bool drag;
+  double gamma;
+  // Centroids of the bodies and the field sampled at them
+  double *scratch;
+  size_t capacity;
+} field_force_t;
+
+/**
+ * The number of per-body arrays in a field force's scratch space.
+ */
+#define FIELD_FORCE_ARRAYS 4
+
+/**
+ * Checks whether a non-empty grid has too many points
+ * for the size of an array of their components to fit in a size_t.
+ */
+bool field_too_big(size_t cols, size_t rows) {
+  return cols > SIZE_MAX / rows / sizeof(double);
+}
+
+/**
+ * Allocates a field that is 0 everywhere,
+ * or returns NULL if there isn't enough memory for it.
+ */
+field_t *field_alloc(vector_t origin, double cell_size, size_t cols, \
+  size_t rows) {
+  field_t *field = malloc(sizeof(field_t));
+  if (field == NULL) {
+    return NULL;
+  }
+  field->origin = origin;
+  field->cell_size = cell_size;
+  field->cols = cols;
+  field->rows = rows;
+  field->x = calloc(cols * rows, sizeof(double));
+  field->y = calloc(cols * rows, sizeof(double));
+  if (field->x == NULL || field->y == NULL) {
+    field_free(field);
+    return NULL;
+  }
+  return field;
+}
+
+field_t *field_init(vector_t origin, double cell_size, size_t cols, \
+  size_t rows) {
+  assert(cell_size > 0);
+  assert(cols > 0 && rows > 0);
+  assert(!field_too_big(cols, rows));
+  field_t *field = field_alloc(origin, cell_size, cols, rows);
+  assert(field != NULL);
+  return field;
+}
+
+field_t *field_init_from_func(vector_t origin, double cell_size, size_t cols, \
+  size_t rows, field_func_t func, void *aux) {
+  field_t *field = field_init(origin, cell_size, cols, rows);
+  for (size_t row = 0; row < rows; row++) {
+    for (size_t col = 0; col < cols; col++) {
+      vector_t position = {
+        origin.x + col * cell_size,
+        origin.y + row * cell_size
+      };
+      field_set(field, col, row, func(position, aux));
+    }
+  }
+  return field;
+}
+
+field_t *field_load(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    return NULL;
+  }
+  size_t cols, rows;
+  vector_t origin;
+  double cell_size;
+  if (fscanf(file, "%zu %zu %lf %lf %lf", &cols, &rows, &origin.x, \
+    &origin.y, &cell_size) != 5 || cols == 0 || rows == 0 || \
+    field_too_big(cols, rows) || !(cell_size > 0)) {
+    fclose(file);
+    return NULL;
+  }
+  field_t *field = field_alloc(origin, cell_size, cols, rows);
+  if (field == NULL) {
+    fclose(file);
+    return NULL;
+  }
+  for (size_t i = 0; i < cols * rows; i++) {
+    if (fscanf(file, "%lf %lf", &field->x[i], &field->y[i]) != 2) {
+      fclose(file);
+      field_free(field);
+      return NULL;
+    }
+  }
+  fclose(file);
+  return field;
+}
+
+void field_free(field_t *field) {
+  free(field->x);
+  free(field->y);
+  free(field);
+}
+
+vector_t field_get(field_t *field, size_t col, size_t row) {
+  assert(col < field->cols && row < field->rows);
+  size_t i = row * field->cols + col;
+  return (vector_t) {field->x[i], field->y[i]};
+}
+
+void field_set(field_t *field, size_t col, size_t row, vector_t value) {
+  assert(col < field->cols && row < field->rows);
+  size_t i = row * field->cols + col;
+  field->x[i] = value.x;
+  field->y[i] = value.y;
+}
+
+void field_sample_batch(field_t *field, const double *x, const double *y, \
+  size_t count, double *out_x, double *out_y) {
+  double inv_cell = 1 / field->cell_size;
+  double max_col = field->cols - 1;
+  double max_row = field->rows - 1;
+  size_t cols = field->cols;
+  // The last cell starts one point before the edge, unless the grid
+  // is only one point wide, in which case it has 0 width
+  size_t last_col = cols > 1 ? cols - 2 : 0;
+  size_t last_row = field->rows > 1 ? field->rows - 2 : 0;
+  size_t step_col = cols > 1 ? 1 : 0;
+  size_t step_row = field->rows > 1 ? cols : 0;
+  for (size_t i = 0; i < count; i++) {
+    double gx = fmin(fmax((x[i] - field->origin.x) * inv_cell, 0), max_col);
+    double gy = fmin(fmax((y[i] - field->origin.y) * inv_cell, 0), max_row);
+    size_t col = (size_t) gx;
+    size_t row = (size_t) gy;
+    col = col < last_col ? col : last_col;
+    row = row < last_row ? row : last_row;
+    double fx = gx - col;
+    double fy = gy - row;
+    size_t p00 = row * cols + col;
+    size_t p10 = p00 + step_col;
+    size_t p01 = p00 + step_row;
+    size_t p11 = p01 + step_col;
+    double w00 = (1 - fx) * (1 - fy);
+    double w10 = fx * (1 - fy);
+    double w01 = (1 - fx) * fy;
+    double w11 = fx * fy;
+    out_x[i] = w00 * field->x[p00] + w10 * field->x[p10] + \
+      w01 * field->x[p01] + w11 * field->x[p11];
+    out_y[i] = w00 * field->y[p00] + w10 * field->y[p10] + \
+      w01 * field->y[p01] + w11 * field->y[p11];
+  }
+}
+
+vector_t field_sample(field_t *field, vector_t position) {
+  vector_t value;
+  field_sample_batch(field, &position.x, &position.y, 1, &value.x, &value.y);
+  return value;
+}
+
+void field_force_free(field_force_t *force) {
+  free(force->scratch);
+  free(force);
+}
+
+/**
+ * Registers a field force with its scene.
+ */
+void field_force_add(scene_t *scene, field_t *field, list_t *bodies, \
+  bool drag, double gamma) {
+  field_force_t *force = malloc(sizeof(field_force_t));
+  assert(force != NULL);
+  force->scene = scene;
+  force->field = field;
+  force->bodies = bodies;
+  force->drag = drag;
+  force->gamma = gamma;
+  force->scratch = NULL;
+  force->capacity = 0;
+  scene_add_bodies_force_creator(scene, field_force_creator, force, \
+    bodies != NULL ? bodies : list_init(0, NULL), \
+    (free_func_t) field_force_free);
+}
+
+void create_field_force(scene_t *scene, field_t *field, list_t *bodies) {
+  field_force_add(scene, field, bodies, false, 0);
+}
+
+void create_flow_drag(scene_t *scene, field_t *field, double gamma, \
+  list_t *bodies) {
+  field_force_add(scene, field, bodies, true, gamma);
+}
+
+/**
+ * Gets the i-th body a field force applies to, or NULL to skip it.
+ */
+body_t *field_force_body(field_force_t *force, size_t i) {
+  if (force->bodies != NULL) {
+    return list_get(force->bodies, i);
+  }
+  body_t *body = scene_get_body(force->scene, i);
+  return body->mass != INFINITY ? body : NULL;
+}
+
+void field_force_creator(void *aux) {
+  field_force_t *force = aux;
+  size_t n = force->bodies != NULL ? list_size(force->bodies) : \
+    scene_bodies(force->scene);
+  if (n > force->capacity) {
+    force->capacity = n;
+    force->scratch = realloc(force->scratch, \
+      FIELD_FORCE_ARRAYS * n * sizeof(double));
+    assert(force->scratch != NULL);
+  }
+  double *pos_x = force->scratch;
+  double *pos_y = pos_x + force->capacity;
+  double *out_x = pos_y + force->capacity;
+  double *out_y = out_x + force->capacity;
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = field_force_body(force, i);
+    pos_x[i] = body != NULL ? body->centroid.x : 0;
+    pos_y[i] = body != NULL ? body->centroid.y : 0;
+  }
+
+  field_sample_batch(force->field, pos_x, pos_y, n, out_x, out_y);
+
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = field_force_body(force, i);
+    if (body == NULL) {
+      continue;
+    }
+    vector_t value = {out_x[i], out_y[i]};
+    if (force->drag) {
+      value = vec_multiply(force->gamma, vec_subtract(value, body->velocity));
+    }
+    body_add_force(body, value);
+  }
+}
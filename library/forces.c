@@ -5,38 +5,122 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "collision.h"
+#include <assert.h>
 
 const double MIN_DIST = 5.0;
 
+typedef struct bulk_drag {
+  scene_t *scene;
+  list_t *bodies;
+  double gamma;
+} bulk_drag_t;
+
+/**
+ * Calculates the force of gravity on body1 of a gravity force.
+ */
+vector_t gravity_force(aux_t *force) {
+  body_t *bod1 = force->body1;
+  body_t *bod2 = force->body2;
+  vector_t pos1 = bod1->centroid;
+  vector_t pos2 = bod2->centroid;
+  double dx = pos2.x - pos1.x;
+  double dy = pos2.y - pos1.y;
+  double distance = sqrt(dx * dx + dy * dy);
+  if (distance <= MIN_DIST) {
+    return VEC_ZERO;
+  }
+  vector_t unit = (vector_t) {dx / distance, dy / distance};
+  double force_mag = force->constant * bod1->mass * bod2->mass / \
+    (distance * distance);
+  return vec_multiply(force_mag, unit);
+}
+
+/**
+ * Calculates the spring force on body1 of a spring force.
+ */
+vector_t spring_force(aux_t *force) {
+  vector_t pos1 = force->body1->centroid;
+  vector_t pos2 = force->body2->centroid;
+  return vec_multiply(force->constant, vec_subtract(pos2, pos1));
+}
+
+/**
+ * Calculates the force of drag on body1 of a drag force.
+ */
+vector_t drag_force(aux_t *force) {
+  vector_t vel = force->body1->velocity;
+  return vec_multiply(force->constant, (vector_t) {-1 * vel.x, -1 * vel.y});
+}
+
+void gravity_force_batch(aux_t *forces, size_t count, vector_t *out) {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = gravity_force(&forces[i]);
+  }
+}
+
+void gravity_creator_batch(aux_t *forces, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    vector_t force = gravity_force(&forces[i]);
+    body_add_force(forces[i].body1, force);
+    body_add_force(forces[i].body2, vec_negate(force));
+  }
+}
+
 void gravity_creator(void *aux) {
-  body_t *bod1 = ((aux_t *) aux)->body1;
-  body_t *bod2 = ((aux_t *) aux)->body2;
-  vector_t pos1 = body_get_centroid(bod1);
-  vector_t pos2 = body_get_centroid(bod2);
-  double distance = sqrt(pow((pos2.x - pos1.x), 2) + pow((pos2.y - pos1.y), 2));
-  if (distance > MIN_DIST) {
-    vector_t unit = (vector_t) {(pos2.x - pos1.x) / distance, \
-      (pos2.y - pos1.y) / distance};
-    double force_mag = ((aux_t *) aux)->constant * body_get_mass(bod1) * \
-      body_get_mass(bod2) / pow(distance, 2);
-    body_add_force(bod1, vec_multiply(force_mag, unit));
-    body_add_force(bod2, vec_negate(vec_multiply(force_mag, unit)));
+  gravity_creator_batch(aux, 1);
+}
+
+void spring_force_batch(aux_t *forces, size_t count, vector_t *out) {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = spring_force(&forces[i]);
+  }
+}
+
+void spring_creator_batch(aux_t *forces, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    vector_t force = spring_force(&forces[i]);
+    body_add_force(forces[i].body1, force);
+    body_add_force(forces[i].body2, vec_negate(force));
   }
 }
 
 void spring_creator(void *aux) {
-  vector_t pos1 = body_get_centroid(((aux_t*) aux)->body1);
-  vector_t pos2 = body_get_centroid(((aux_t*) aux)->body2);
-  vector_t force = vec_multiply(((aux_t*) aux)->constant, vec_subtract(pos2, pos1));
-  body_add_force(((aux_t*) aux)->body1, force);
-  body_add_force(((aux_t*) aux)->body2, vec_negate(force));
+  spring_creator_batch(aux, 1);
+}
+
+void drag_force_batch(aux_t *forces, size_t count, vector_t *out) {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = drag_force(&forces[i]);
+  }
+}
+
+void drag_creator_batch(aux_t *forces, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    body_add_force(forces[i].body1, drag_force(&forces[i]));
+  }
 }
 
 void drag_creator(void *aux) {
-  vector_t vel = body_get_velocity(((aux_t*) aux)->body1);
-  vector_t force = vec_multiply(((aux_t*) aux)->constant, (vector_t) \
-    {-1 * vel.x, -1 * vel.y});
-  body_add_force(((aux_t*) aux)->body1, force);
+  drag_creator_batch(aux, 1);
+}
+
+void bulk_drag_creator(void *aux) {
+  bulk_drag_t *drag = aux;
+  if (drag->bodies != NULL) {
+    size_t n = list_size(drag->bodies);
+    for (size_t i = 0; i < n; i++) {
+      body_t *body = list_get(drag->bodies, i);
+      body_add_force(body, vec_multiply(-drag->gamma, body->velocity));
+    }
+    return;
+  }
+  size_t n = scene_bodies(drag->scene);
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = scene_get_body(drag->scene, i);
+    if (body->mass != INFINITY) {
+      body_add_force(body, vec_multiply(-drag->gamma, body->velocity));
+    }
+  }
 }
 
 void collision_handler_1(body_t *body1, body_t *body2, vector_t axis, void *aux){
@@ -47,11 +131,18 @@ void collision_handler_1(body_t *body1, body_t *body2, vector_t axis, void *aux)
 }
 
 void collision_creator(void *aux) {
-  collision_info_t info = find_collision((((aux_t*) aux)->body1)->shape, (((aux_t*) aux)->body2)->shape);
+  body_t *body1 = ((aux_t*) aux)->body1;
+  body_t *body2 = ((aux_t*) aux)->body2;
+  collision_respond(aux, find_collision(body1->shape, body2->shape));
+}
+
+void collision_respond(aux_t *aux, collision_info_t info) {
+  aux->collided = info.collided;
+  // The handler may add forces to the scene, moving this record,
+  // so the record is not used after the handler is called
   if (info.collided) {
-    ((aux_t*) aux)->handler(((aux_t*) aux)->body1, ((aux_t*) aux)->body2, info.axis, ((aux_t*) aux)->aux);
+    aux->handler(aux->body1, aux->body2, info.axis, aux->aux);
   }
-  ((aux_t *) aux)->collided = info.collided;
 }
 
 void collision_handler_2(body_t *body1, body_t *body2, vector_t axis, void *aux){
@@ -76,50 +167,55 @@ void collision_handler_2(body_t *body1, body_t *body2, vector_t axis, void *aux)
 }
 
 void create_newtonian_gravity(scene_t *scene, double g, body_t *body1, body_t *body2) {
-  aux_t *aux = malloc(sizeof(aux_t));
-  aux->constant = g;
-  aux->body1 = body1;
-  aux->body2 = body2;
-  aux->collided = false;
-  aux->handler = NULL;
-  scene_add_force_creator(scene, (force_creator_t) gravity_creator, \
-    aux, free);
+  aux_t aux = {.constant = g, .body1 = body1, .body2 = body2};
+  scene_add_typed_force(scene, FORCE_GRAVITY, &aux);
 }
 
 void create_spring(scene_t *scene, double k, body_t *body1, body_t *body2) {
-  aux_t *aux = malloc(sizeof(aux_t));
-  aux->constant = k;
-  aux->body1 = body1;
-  aux->body2 = body2;
-  aux->collided = false;
-  aux->handler = NULL;
-  scene_add_force_creator(scene, (force_creator_t) spring_creator, \
-   aux, free);
+  aux_t aux = {.constant = k, .body1 = body1, .body2 = body2};
+  scene_add_typed_force(scene, FORCE_SPRING, &aux);
 }
 
 void create_drag(scene_t *scene, double gamma, body_t *body) {
-  aux_t *aux = malloc(sizeof(aux_t));
-  aux->constant = gamma;
-  aux->body1 = body;
-  aux->body2 = NULL;
-  aux->collided = false;
-  aux->handler = NULL;
-  scene_add_force_creator(scene, (force_creator_t) drag_creator, \
-  aux, free);
+  aux_t aux = {.constant = gamma, .body1 = body, .body2 = NULL};
+  scene_add_typed_force(scene, FORCE_DRAG, &aux);
+}
+
+/**
+ * Copies a bulk drag for a fork of its scene.
+ */
+void *bulk_drag_copy(void *aux, scene_t *fork, list_t *bodies) {
+  bulk_drag_t *drag = aux;
+  bulk_drag_t *copy = malloc(sizeof(bulk_drag_t));
+  assert(copy != NULL);
+  copy->scene = fork;
+  copy->bodies = drag->bodies != NULL ? bodies : NULL;
+  copy->gamma = drag->gamma;
+  return copy;
+}
+
+void create_bulk_drag(scene_t *scene, double gamma, list_t *bodies) {
+  bulk_drag_t *drag = malloc(sizeof(bulk_drag_t));
+  assert(drag != NULL);
+  drag->scene = scene;
+  drag->bodies = bodies;
+  drag->gamma = gamma;
+  scene_add_bodies_force_creator(scene, bulk_drag_creator, drag, \
+    bodies != NULL ? bodies : list_init(0, NULL), free);
+  scene_set_force_copier(scene, bulk_drag_copy);
 }
 
 void create_collision(scene_t *scene, body_t *body1, body_t *body2, \
   collision_handler_t handler, void *aux, free_func_t freer){
-    aux_t *aux_copy = malloc(sizeof(aux_t));
-    aux_copy->body1 = body1;
-    aux_copy->body2 = body2;
-    aux_copy->aux = aux;
-    aux_copy->handler = handler;
-    list_t *b_list = list_init(2, (free_func_t)body_free);
-    list_add(b_list, body1);
-    list_add(b_list, body2);
-    scene_add_bodies_force_creator(scene, (force_creator_t) collision_creator, \
-    aux_copy, b_list, freer);
+    aux_t record = {
+      .body1 = body1,
+      .body2 = body2,
+      .collided = false,
+      .handler = handler,
+      .aux = aux,
+      .freer = freer
+    };
+    scene_add_typed_force(scene, FORCE_COLLISION, &record);
   }
 
 void create_destructive_collision(scene_t *scene, body_t *body1, body_t *body2) {
@@ -0,0 +1,91 @@
+#include "hot_counters.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+const char *const HOT_COUNTER_NAMES[NUM_HOT_COUNTERS] = {
+  [HOT_LIST_GROWS] = "list grows",
+  [HOT_FIND_COLLISION_CALLS] = "find_collision calls",
+  [HOT_SAT_AXES] = "SAT axes",
+  [HOT_PROJECTIONS] = "polygon projections",
+  [HOT_TRIG_CALLS] = "trig calls",
+  [HOT_SHAPE_COPIES] = "shape copies",
+  [HOT_ALLOCATIONS] = "allocations",
+  [HOT_FREES] = "frees"
+};
+
+/**
+ * One thread's counters.
+ */
+typedef struct hot_block {
+  // Only written by the thread, but read by hot_counter_total()
+  atomic_size_t counts[NUM_HOT_COUNTERS];
+  struct hot_block *next;
+} hot_block_t;
+
+// Every thread's counters, newest first
+static _Atomic(hot_block_t *) hot_blocks = NULL;
+static _Thread_local hot_block_t *thread_block = NULL;
+
+/**
+ * Gets the calling thread's counters, adding them to the list of counters
+ * the first time the thread counts anything.
+ */
+hot_block_t *hot_thread_block(void) {
+  if (thread_block != NULL) {
+    return thread_block;
+  }
+  hot_block_t *block = malloc(sizeof(hot_block_t));
+  assert(block != NULL);
+  for (size_t c = 0; c < NUM_HOT_COUNTERS; c++) {
+    atomic_init(&block->counts[c], 0);
+  }
+  block->next = atomic_load(&hot_blocks);
+  while (!atomic_compare_exchange_weak(&hot_blocks, &block->next, block)) {
+  }
+  thread_block = block;
+  return block;
+}
+
+void hot_count(hot_counter_t counter, size_t n) {
+  atomic_size_t *count = &hot_thread_block()->counts[counter];
+  // No other thread writes the count, so it needn't be a read-modify-write
+  atomic_store_explicit(count, \
+    atomic_load_explicit(count, memory_order_relaxed) + n, \
+    memory_order_relaxed);
+}
+
+size_t hot_counter_get(hot_counter_t counter) {
+  return atomic_load_explicit(&hot_thread_block()->counts[counter], \
+    memory_order_relaxed);
+}
+
+size_t hot_counter_total(hot_counter_t counter) {
+  size_t total = 0;
+  for (hot_block_t *block = atomic_load(&hot_blocks); block != NULL; \
+    block = block->next) {
+    total += atomic_load_explicit(&block->counts[counter], \
+      memory_order_relaxed);
+  }
+  return total;
+}
+
+/**
+ * Sets one thread's counters to zero.
+ */
+void hot_block_reset(hot_block_t *block) {
+  for (size_t c = 0; c < NUM_HOT_COUNTERS; c++) {
+    atomic_store_explicit(&block->counts[c], 0, memory_order_relaxed);
+  }
+}
+
+void hot_counters_reset(void) {
+  hot_block_reset(hot_thread_block());
+}
+
+void hot_counters_reset_all(void) {
+  for (hot_block_t *block = atomic_load(&hot_blocks); block != NULL; \
+    block = block->next) {
+    hot_block_reset(block);
+  }
+}
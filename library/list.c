@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include "list.h"
+#include "hot_counters.h"
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -20,15 +21,20 @@ list_t *list_init(size_t initial_size, free_func_t freer){
   list->lst = malloc(initial_size * sizeof(void *));
   list->freer = freer;
   assert(list->lst != NULL);
+  HOT_COUNT(HOT_ALLOCATIONS, 2);
   return list;
 }
 
 void list_free(list_t *list) {
-  for (int k = 0; k < (int)(list->size); k++) {
-      list->freer(list->lst[k]);
+  if (list->freer != NULL) {
+    for (int k = 0; k < (int)(list->size); k++) {
+        list->freer(list->lst[k]);
+    }
+    HOT_COUNT(HOT_FREES, list->size);
   }
   free(list->lst);
   free(list);
+  HOT_COUNT(HOT_FREES, 2);
 }
 
 size_t list_size(list_t *list) {
@@ -45,11 +51,36 @@ void list_add(list_t *list, void *value) {
   if (list->size == list->max_size) {
     list->max_size = 2 * (list->max_size) + 1;
     list->lst = realloc(list->lst, list->max_size * sizeof(void *));
+    HOT_COUNT(HOT_LIST_GROWS, 1);
+    HOT_COUNT(HOT_ALLOCATIONS, 1);
   }
   (list->lst)[list->size] = value;
   list->size++;
 }
 
+void list_set(list_t *list, size_t index, void *value) {
+  assert(index < list->size);
+  assert(value != NULL);
+  list->lst[index] = value;
+}
+
+void list_truncate(list_t *list, size_t size) {
+  assert(size <= list->size);
+  list->size = size;
+}
+
+size_t list_remove_if(list_t *list, list_predicate_t predicate, void *aux) {
+  size_t kept = 0;
+  for (size_t i = 0; i < list->size; i++) {
+    if (!predicate(list->lst[i], aux)) {
+      list->lst[kept++] = list->lst[i];
+    }
+  }
+  size_t removed = list->size - kept;
+  list->size = kept;
+  return removed;
+}
+
 void *list_remove(list_t *list, size_t index) {
   assert(list->size > 0 && index < list->size && index >= 0);
   void *toReturn = list->lst[index];
@@ -0,0 +1,315 @@
+#include "pair_potential.h"
+#include "body.h"
+#include "list.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t INIT_NEIGHBORS = 16;
+
+typedef struct pair_potential {
+  list_t *bodies;
+  double cutoff;
+  double skin;
+  pair_force_t force;
+  void *params;
+  free_func_t freer;
+  size_t rebuilds;
+  // Per-body arrays, one entry per body
+  double *scratch;
+  double *pos_x;
+  double *pos_y;
+  double *force_x;
+  double *force_y;
+  // Positions at the last rebuild of the neighbor list
+  double *built_x;
+  double *built_y;
+  // The neighbors j > i of each body i are
+  // neighbors[neighbor_start[i]] to neighbors[neighbor_start[i + 1] - 1]
+  size_t *neighbor_start;
+  size_t *neighbors;
+  size_t neighbor_capacity;
+  // Cell list: the bodies in cell c are
+  // cell_bodies[cell_start[c]] to cell_bodies[cell_start[c + 1] - 1]
+  size_t *body_cell;
+  size_t *cell_bodies;
+  size_t *cell_start;
+  size_t cell_capacity;
+} pair_potential_t;
+
+/**
+ * The number of per-body arrays of doubles in a pair potential's scratch space.
+ */
+#define POTENTIAL_ARRAYS 6
+
+typedef struct soft_repulsion {
+  double k;
+  double diameter;
+} soft_repulsion_t;
+
+typedef struct lennard_jones {
+  double epsilon;
+  double sigma;
+} lennard_jones_t;
+
+void pair_potential_free(pair_potential_t *potential) {
+  if (potential->freer != NULL) {
+    potential->freer(potential->params);
+  }
+  free(potential->scratch);
+  free(potential->neighbor_start);
+  free(potential->neighbors);
+  free(potential->body_cell);
+  free(potential->cell_bodies);
+  free(potential->cell_start);
+  free(potential);
+}
+
+pair_potential_t *create_pair_potential(scene_t *scene, list_t *bodies, \
+  double cutoff, double skin, pair_force_t force, void *params, \
+  free_func_t freer) {
+  assert(cutoff > 0);
+  assert(skin >= 0);
+  pair_potential_t *potential = malloc(sizeof(pair_potential_t));
+  assert(potential != NULL);
+  size_t n = list_size(bodies);
+  potential->bodies = bodies;
+  potential->cutoff = cutoff;
+  potential->skin = skin;
+  potential->force = force;
+  potential->params = params;
+  potential->freer = freer;
+  potential->rebuilds = 0;
+  potential->scratch = malloc(POTENTIAL_ARRAYS * n * sizeof(double));
+  potential->neighbor_start = calloc(n + 1, sizeof(size_t));
+  potential->body_cell = malloc(n * sizeof(size_t));
+  potential->cell_bodies = malloc(n * sizeof(size_t));
+  assert(n == 0 || (potential->scratch != NULL &&
+    potential->body_cell != NULL && potential->cell_bodies != NULL));
+  assert(potential->neighbor_start != NULL);
+  double **arrays[POTENTIAL_ARRAYS] = {
+    &potential->pos_x, &potential->pos_y,
+    &potential->force_x, &potential->force_y,
+    &potential->built_x, &potential->built_y
+  };
+  for (size_t a = 0; a < POTENTIAL_ARRAYS; a++) {
+    *arrays[a] = potential->scratch + a * n;
+  }
+  potential->neighbors = NULL;
+  potential->neighbor_capacity = 0;
+  potential->cell_start = NULL;
+  potential->cell_capacity = 0;
+  scene_add_bodies_force_creator(scene, pair_potential_creator, potential, \
+    bodies, (free_func_t) pair_potential_free);
+  return potential;
+}
+
+double soft_repulsion_force(double distance, void *params) {
+  soft_repulsion_t *repulsion = params;
+  return repulsion->k * (repulsion->diameter - distance);
+}
+
+pair_potential_t *create_soft_repulsion(scene_t *scene, list_t *bodies, \
+  double k, double diameter, double skin) {
+  soft_repulsion_t *repulsion = malloc(sizeof(soft_repulsion_t));
+  assert(repulsion != NULL);
+  repulsion->k = k;
+  repulsion->diameter = diameter;
+  return create_pair_potential(scene, bodies, diameter, skin, \
+    soft_repulsion_force, repulsion, free);
+}
+
+double lennard_jones_force(double distance, void *params) {
+  lennard_jones_t *lj = params;
+  double s2 = lj->sigma * lj->sigma / (distance * distance);
+  double s6 = s2 * s2 * s2;
+  return 24 * lj->epsilon * (2 * s6 * s6 - s6) / distance;
+}
+
+pair_potential_t *create_lennard_jones(scene_t *scene, list_t *bodies, \
+  double epsilon, double sigma, double cutoff, double skin) {
+  lennard_jones_t *lj = malloc(sizeof(lennard_jones_t));
+  assert(lj != NULL);
+  lj->epsilon = epsilon;
+  lj->sigma = sigma;
+  return create_pair_potential(scene, bodies, cutoff, skin, \
+    lennard_jones_force, lj, free);
+}
+
+size_t pair_potential_pairs(pair_potential_t *potential) {
+  return potential->neighbor_start[list_size(potential->bodies)];
+}
+
+size_t pair_potential_rebuilds(pair_potential_t *potential) {
+  return potential->rebuilds;
+}
+
+/**
+ * Checks whether any body has moved more than half the skin
+ * since the neighbor list was last built, in which case a pair
+ * that was further apart than the cutoff plus the skin may now be
+ * within the cutoff.
+ */
+bool pair_potential_stale(pair_potential_t *potential, size_t n) {
+  if (potential->rebuilds == 0) {
+    return true;
+  }
+  double limit = potential->skin * potential->skin / 4;
+  for (size_t i = 0; i < n; i++) {
+    double dx = potential->pos_x[i] - potential->built_x[i];
+    double dy = potential->pos_y[i] - potential->built_y[i];
+    if (dx * dx + dy * dy > limit) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Sorts the bodies into a grid of cells at least cutoff + skin wide,
+ * so that every pair within that distance is in the same or adjacent cells.
+ * The bodies' positions must be finite.
+ * Returns the number of cells, and the size of the grid through cols and rows.
+ */
+size_t pair_potential_bin(pair_potential_t *potential, size_t n, \
+  size_t *cols, size_t *rows) {
+  double min_x = INFINITY, min_y = INFINITY;
+  double max_x = -INFINITY, max_y = -INFINITY;
+  for (size_t i = 0; i < n; i++) {
+    // Cells can't be found for NaN or infinite positions
+    assert(isfinite(potential->pos_x[i]) && isfinite(potential->pos_y[i]));
+    min_x = fmin(min_x, potential->pos_x[i]);
+    min_y = fmin(min_y, potential->pos_y[i]);
+    max_x = fmax(max_x, potential->pos_x[i]);
+    max_y = fmax(max_y, potential->pos_y[i]);
+  }
+  // The widening loop below would never end on an infinite spread
+  assert(isfinite(max_x - min_x) && isfinite(max_y - min_y));
+  double width = potential->cutoff + potential->skin;
+  // Widen the cells of sparse sets so that there are O(n) cells
+  while (((max_x - min_x) / width + 1) * ((max_y - min_y) / width + 1) > \
+    2.0 * n + 2) {
+    width *= 2;
+  }
+  *cols = (size_t) ((max_x - min_x) / width) + 1;
+  *rows = (size_t) ((max_y - min_y) / width) + 1;
+  size_t cells = *cols * *rows;
+  if (cells + 1 > potential->cell_capacity) {
+    potential->cell_capacity = cells + 1;
+    potential->cell_start = realloc(potential->cell_start, \
+      potential->cell_capacity * sizeof(size_t));
+    assert(potential->cell_start != NULL);
+  }
+
+  // Counting sort of the bodies by cell
+  size_t *cell_start = potential->cell_start;
+  for (size_t c = 0; c <= cells; c++) {
+    cell_start[c] = 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    size_t col = (size_t) ((potential->pos_x[i] - min_x) / width);
+    size_t row = (size_t) ((potential->pos_y[i] - min_y) / width);
+    potential->body_cell[i] = row * *cols + col;
+    cell_start[potential->body_cell[i] + 1]++;
+  }
+  for (size_t c = 0; c < cells; c++) {
+    cell_start[c + 1] += cell_start[c];
+  }
+  for (size_t i = 0; i < n; i++) {
+    potential->cell_bodies[cell_start[potential->body_cell[i]]++] = i;
+  }
+  for (size_t c = cells; c > 0; c--) {
+    cell_start[c] = cell_start[c - 1];
+  }
+  cell_start[0] = 0;
+  return cells;
+}
+
+/**
+ * Rebuilds the list of the neighbors of each body within the cutoff
+ * plus the skin, checking only the bodies in the adjacent cells.
+ * Each pair is listed once, under its lower index.
+ */
+void pair_potential_rebuild(pair_potential_t *potential, size_t n) {
+  size_t cols, rows;
+  pair_potential_bin(potential, n, &cols, &rows);
+  double range = potential->cutoff + potential->skin;
+  double range2 = range * range;
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    potential->neighbor_start[i] = count;
+    size_t col = potential->body_cell[i] % cols;
+    size_t row = potential->body_cell[i] / cols;
+    for (size_t r = row > 0 ? row - 1 : 0; r <= row + 1 && r < rows; r++) {
+      for (size_t c = col > 0 ? col - 1 : 0; c <= col + 1 && c < cols; c++) {
+        size_t cell = r * cols + c;
+        for (size_t b = potential->cell_start[cell];
+          b < potential->cell_start[cell + 1]; b++) {
+          size_t j = potential->cell_bodies[b];
+          double dx = potential->pos_x[j] - potential->pos_x[i];
+          double dy = potential->pos_y[j] - potential->pos_y[i];
+          if (j <= i || dx * dx + dy * dy > range2) {
+            continue;
+          }
+          if (count == potential->neighbor_capacity) {
+            potential->neighbor_capacity = count == 0 ? INIT_NEIGHBORS : \
+              2 * count;
+            potential->neighbors = realloc(potential->neighbors, \
+              potential->neighbor_capacity * sizeof(size_t));
+            assert(potential->neighbors != NULL);
+          }
+          potential->neighbors[count++] = j;
+        }
+      }
+    }
+  }
+  potential->neighbor_start[n] = count;
+  for (size_t i = 0; i < n; i++) {
+    potential->built_x[i] = potential->pos_x[i];
+    potential->built_y[i] = potential->pos_y[i];
+  }
+  potential->rebuilds++;
+}
+
+void pair_potential_creator(void *aux) {
+  pair_potential_t *potential = aux;
+  size_t n = list_size(potential->bodies);
+  if (n == 0) {
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = list_get(potential->bodies, i);
+    potential->pos_x[i] = body->centroid.x;
+    potential->pos_y[i] = body->centroid.y;
+    potential->force_x[i] = 0.0;
+    potential->force_y[i] = 0.0;
+  }
+  if (pair_potential_stale(potential, n)) {
+    pair_potential_rebuild(potential, n);
+  }
+
+  double cutoff2 = potential->cutoff * potential->cutoff;
+  for (size_t i = 0; i < n; i++) {
+    for (size_t p = potential->neighbor_start[i];
+      p < potential->neighbor_start[i + 1]; p++) {
+      size_t j = potential->neighbors[p];
+      double dx = potential->pos_x[j] - potential->pos_x[i];
+      double dy = potential->pos_y[j] - potential->pos_y[i];
+      double distance2 = dx * dx + dy * dy;
+      if (distance2 >= cutoff2 || distance2 == 0) {
+        continue;
+      }
+      double distance = sqrt(distance2);
+      double magnitude = potential->force(distance, potential->params) / \
+        distance;
+      potential->force_x[i] -= magnitude * dx;
+      potential->force_y[i] -= magnitude * dy;
+      potential->force_x[j] += magnitude * dx;
+      potential->force_y[j] += magnitude * dy;
+    }
+  }
+  for (size_t i = 0; i < n; i++) {
+    body_add_force(list_get(potential->bodies, i),
+      (vector_t) {potential->force_x[i], potential->force_y[i]});
+  }
+}
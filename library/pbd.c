@@ -0,0 +1,236 @@
+#include "pbd.h"
+#include "body.h"
+#include "list.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t INIT_CONSTRAINTS = 16;
+
+typedef enum {
+  CONSTRAINT_DISTANCE,
+  CONSTRAINT_CONTACT,
+  CONSTRAINT_PIN,
+  CONSTRAINT_PLANE
+} constraint_kind_t;
+
+typedef struct constraint {
+  constraint_kind_t kind;
+  size_t body1;
+  size_t body2;
+  // Distance for distance and contact constraints
+  double length;
+  // Fraction of the error corrected per iteration, for distance constraints
+  double stiffness;
+  // Position of a pin, or a point on the line of a plane
+  vector_t point;
+  // Unit normal of a plane
+  vector_t normal;
+} constraint_t;
+
+typedef struct pbd {
+  scene_t *scene;
+  list_t *bodies;
+  size_t iterations;
+  constraint_t *constraints;
+  size_t size;
+  size_t capacity;
+  // Per-body arrays, one entry per body
+  vector_t *start;
+  vector_t *predicted;
+  double *inverse_mass;
+} pbd_t;
+
+void pbd_free(pbd_t *pbd) {
+  free(pbd->constraints);
+  free(pbd->start);
+  free(pbd->predicted);
+  free(pbd->inverse_mass);
+  free(pbd);
+}
+
+pbd_t *create_pbd(scene_t *scene, list_t *bodies, size_t iterations) {
+  assert(iterations > 0);
+  pbd_t *pbd = malloc(sizeof(pbd_t));
+  assert(pbd != NULL);
+  size_t n = list_size(bodies);
+  pbd->scene = scene;
+  pbd->bodies = bodies;
+  pbd->iterations = iterations;
+  pbd->constraints = NULL;
+  pbd->size = 0;
+  pbd->capacity = 0;
+  pbd->start = malloc(n * sizeof(vector_t));
+  pbd->predicted = malloc(n * sizeof(vector_t));
+  pbd->inverse_mass = malloc(n * sizeof(double));
+  assert(n == 0 || (pbd->start != NULL && pbd->predicted != NULL &&
+    pbd->inverse_mass != NULL));
+  scene_add_solver(scene, pbd_solver, pbd, bodies, (free_func_t) pbd_free);
+  return pbd;
+}
+
+/**
+ * Appends a constraint to a solver, checking that its bodies are valid.
+ */
+void pbd_add(pbd_t *pbd, constraint_t constraint) {
+  size_t n = list_size(pbd->bodies);
+  assert(constraint.body1 < n);
+  assert(constraint.body2 < n);
+  if (pbd->size == pbd->capacity) {
+    pbd->capacity = pbd->capacity == 0 ? INIT_CONSTRAINTS : 2 * pbd->capacity;
+    pbd->constraints = realloc(pbd->constraints, \
+      pbd->capacity * sizeof(constraint_t));
+    assert(pbd->constraints != NULL);
+  }
+  pbd->constraints[pbd->size++] = constraint;
+}
+
+void pbd_add_distance(pbd_t *pbd, size_t body1, size_t body2, double length, \
+  double stiffness) {
+  assert(body1 != body2);
+  assert(stiffness > 0 && stiffness <= 1);
+  // Spread the correction over the iterations so that the total correction
+  // per tick is the given stiffness, however many iterations there are
+  double per_iteration = 1 - pow(1 - stiffness, 1.0 / pbd->iterations);
+  pbd_add(pbd, (constraint_t) {
+    .kind = CONSTRAINT_DISTANCE, .body1 = body1, .body2 = body2,
+    .length = length, .stiffness = per_iteration
+  });
+}
+
+void pbd_add_contact(pbd_t *pbd, size_t body1, size_t body2, double distance) {
+  assert(body1 != body2);
+  pbd_add(pbd, (constraint_t) {
+    .kind = CONSTRAINT_CONTACT, .body1 = body1, .body2 = body2,
+    .length = distance, .stiffness = 1
+  });
+}
+
+void pbd_add_pin(pbd_t *pbd, size_t body, vector_t position) {
+  pbd_add(pbd, (constraint_t) {
+    .kind = CONSTRAINT_PIN, .body1 = body, .body2 = body, .point = position
+  });
+}
+
+void pbd_add_plane(pbd_t *pbd, size_t body, vector_t point, vector_t normal) {
+  double length = sqrt(vec_dot(normal, normal));
+  assert(length > 0);
+  pbd_add(pbd, (constraint_t) {
+    .kind = CONSTRAINT_PLANE, .body1 = body, .body2 = body, .point = point,
+    .normal = vec_multiply(1 / length, normal)
+  });
+}
+
+size_t pbd_constraints(pbd_t *pbd) {
+  return pbd->size;
+}
+
+/**
+ * Moves two bodies along the line between them towards a distance apart,
+ * splitting the correction in proportion to their inverse masses.
+ * Contacts only push the bodies apart.
+ */
+void pbd_project_pair(pbd_t *pbd, constraint_t *c) {
+  double w1 = pbd->inverse_mass[c->body1];
+  double w2 = pbd->inverse_mass[c->body2];
+  if (w1 + w2 == 0) {
+    return;
+  }
+  vector_t *x1 = &pbd->predicted[c->body1];
+  vector_t *x2 = &pbd->predicted[c->body2];
+  vector_t d = vec_subtract(*x1, *x2);
+  double distance = sqrt(vec_dot(d, d));
+  if (distance == 0) {
+    return;
+  }
+  double error = distance - c->length;
+  if (c->kind == CONSTRAINT_CONTACT && error >= 0) {
+    return;
+  }
+  vector_t correction = vec_multiply(c->stiffness * error / distance, d);
+  *x1 = vec_subtract(*x1, vec_multiply(w1 / (w1 + w2), correction));
+  *x2 = vec_add(*x2, vec_multiply(w2 / (w1 + w2), correction));
+}
+
+void pbd_project(pbd_t *pbd, constraint_t *c) {
+  vector_t *x = &pbd->predicted[c->body1];
+  switch (c->kind) {
+    case CONSTRAINT_DISTANCE:
+    case CONSTRAINT_CONTACT:
+      pbd_project_pair(pbd, c);
+      break;
+    case CONSTRAINT_PIN:
+      // Pinned bodies are placed before projecting (see pbd_solver())
+      break;
+    case CONSTRAINT_PLANE: {
+      double depth = vec_dot(vec_subtract(*x, c->point), c->normal);
+      if (depth < 0 && pbd->inverse_mass[c->body1] > 0) {
+        *x = vec_subtract(*x, vec_multiply(depth, c->normal));
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * Computes how far the scene moves a body per unit of its velocity
+ * over a tick with no force or impulse, i.e. dt when there is no drag.
+ * Matches the exponential damping in body_tick_with_drag().
+ */
+double pbd_travel(double drag, double mass, double dt) {
+  if (drag == 0) {
+    return dt;
+  }
+  double rate = drag / mass;
+  return -expm1(-rate * dt) / rate;
+}
+
+void pbd_solver(void *aux) {
+  pbd_t *pbd = aux;
+  double dt = scene_get_dt(pbd->scene);
+  if (dt <= 0) {
+    return;
+  }
+  size_t n = list_size(pbd->bodies);
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = list_get(pbd->bodies, i);
+    double w = body->mass == INFINITY ? 0 : 1 / body->mass;
+    vector_t velocity = vec_add(body->velocity, vec_multiply(w, \
+      vec_add(vec_multiply(dt, body->force), body->impulse)));
+    pbd->inverse_mass[i] = w;
+    pbd->start[i] = body->centroid;
+    pbd->predicted[i] = vec_add(body->centroid, vec_multiply(dt, velocity));
+  }
+
+  // Pinned bodies are moved to their pins and then treated as having
+  // infinite mass, so the other constraints don't pull them off
+  for (size_t c = 0; c < pbd->size; c++) {
+    constraint_t *pin = &pbd->constraints[c];
+    if (pin->kind == CONSTRAINT_PIN && pbd->inverse_mass[pin->body1] > 0) {
+      pbd->predicted[pin->body1] = pin->point;
+      pbd->inverse_mass[pin->body1] = 0;
+    }
+  }
+
+  for (size_t it = 0; it < pbd->iterations; it++) {
+    for (size_t c = 0; c < pbd->size; c++) {
+      pbd_project(pbd, &pbd->constraints[c]);
+    }
+  }
+
+  // With no force or impulse left, the scene moves each body by its velocity
+  // times pbd_travel(), which is shorter than dt under the scene's drag,
+  // so dividing by it takes the body exactly to its projected position
+  double drag = scene_get_drag(pbd->scene);
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = list_get(pbd->bodies, i);
+    if (body->mass == INFINITY) {
+      continue;
+    }
+    double travel = pbd_travel(drag, body->mass, dt);
+    body->velocity = vec_multiply(1 / travel, \
+      vec_subtract(pbd->predicted[i], pbd->start[i]));
+    body->force = VEC_ZERO;
+    body->impulse = VEC_ZERO;
+  }
+}
@@ -1,4 +1,5 @@
 #include "polygon.h"
+#include <math.h>
 #include "list.h"
 #include "vector.h"
 
@@ -50,3 +51,93 @@ void polygon_rotate(list_t *polygon, double angle, vector_t point) {
     // Translates polygon back to its original frame
     polygon_translate(polygon, point);
 }
+
+aabb_t polygon_bounds(list_t *polygon) {
+    vector_t first = *(vector_t*) list_get(polygon, 0);
+    aabb_t bounds = {first, first};
+    int num_vertices = (int)(list_size(polygon));
+    for (int k = 1; k < num_vertices; k++) {
+        vector_t *vertex = (vector_t*) list_get(polygon, k);
+        bounds.min.x = fmin(bounds.min.x, vertex->x);
+        bounds.min.y = fmin(bounds.min.y, vertex->y);
+        bounds.max.x = fmax(bounds.max.x, vertex->x);
+        bounds.max.y = fmax(bounds.max.y, vertex->y);
+    }
+    return bounds;
+}
+
+bool aabb_overlap(aabb_t a, aabb_t b) {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x && \
+        a.min.y <= b.max.y && b.min.y <= a.max.y;
+}
+
+bool polygon_contains(list_t *polygon, vector_t point) {
+    // Counts the edges crossed by a ray from the point in the +x direction
+    bool inside = false;
+    int num_vertices = (int)(list_size(polygon));
+    for (int k = 0; k < num_vertices; k++) {
+        vector_t *a = (vector_t*) list_get(polygon, k);
+        vector_t *b = (vector_t*) list_get(polygon, (k + 1) % num_vertices);
+        if ((a->y > point.y) != (b->y > point.y)) {
+            double cross_x = a->x + (point.y - a->y) / (b->y - a->y) * (b->x - a->x);
+            if (point.x < cross_x) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+double polygon_distance(list_t *polygon, vector_t point) {
+    if (polygon_contains(polygon, point)) {
+        return 0;
+    }
+    double nearest = INFINITY;
+    int num_vertices = (int)(list_size(polygon));
+    for (int k = 0; k < num_vertices; k++) {
+        vector_t a = *(vector_t*) list_get(polygon, k);
+        vector_t b = *(vector_t*) list_get(polygon, (k + 1) % num_vertices);
+        // Projects the point onto the edge, clamped to its endpoints
+        vector_t edge = vec_subtract(b, a);
+        double length_sq = vec_dot(edge, edge);
+        double t = length_sq > 0 ? vec_dot(vec_subtract(point, a), edge) / length_sq : 0;
+        t = fmax(0, fmin(1, t));
+        vector_t offset = vec_subtract(point, vec_add(a, vec_multiply(t, edge)));
+        nearest = fmin(nearest, sqrt(vec_dot(offset, offset)));
+    }
+    return nearest;
+}
+
+double polygon_raycast(list_t *polygon, vector_t origin, vector_t direction, vector_t *normal) {
+    double nearest = INFINITY;
+    vector_t nearest_edge = VEC_ZERO;
+    int num_vertices = (int)(list_size(polygon));
+    for (int k = 0; k < num_vertices; k++) {
+        vector_t a = *(vector_t*) list_get(polygon, k);
+        vector_t b = *(vector_t*) list_get(polygon, (k + 1) % num_vertices);
+        // Solves origin + t * direction = a + u * edge for t and u
+        vector_t edge = vec_subtract(b, a);
+        double denominator = vec_cross(direction, edge);
+        if (denominator == 0) {
+            continue;
+        }
+        vector_t to_edge = vec_subtract(a, origin);
+        double t = vec_cross(to_edge, edge) / denominator;
+        double u = vec_cross(to_edge, direction) / denominator;
+        if (t >= 0 && u >= 0 && u <= 1 && t < nearest) {
+            nearest = t;
+            nearest_edge = edge;
+        }
+    }
+    // A ray from inside crosses an edge on its way out, which isn't a hit
+    if (nearest == INFINITY || polygon_contains(polygon, origin)) {
+        return INFINITY;
+    }
+    vector_t perpendicular = {-nearest_edge.y, nearest_edge.x};
+    if (vec_dot(perpendicular, direction) > 0) {
+        perpendicular = vec_negate(perpendicular);
+    }
+    *normal = vec_multiply(1 / sqrt(vec_dot(perpendicular, perpendicular)), \
+        perpendicular);
+    return nearest;
+}
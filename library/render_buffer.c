@@ -0,0 +1,102 @@
+#include "render_buffer.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "trace.h"
+
+// Set in the ready index when its frame hasn't been acquired yet
+const unsigned FRESH_FRAME = 4;
+// Bits of the ready index that hold a frame's index
+const unsigned FRAME_INDEX = 3;
+
+typedef struct render_buffer {
+  render_frame_t frames[3];
+  // The latest published frame, with FRESH_FRAME set until it is acquired
+  atomic_uint ready;
+  // The frame being written, only used by the publishing thread
+  unsigned back;
+  // The frame being drawn, only used by the acquiring thread
+  unsigned front;
+  size_t published;
+} render_buffer_t;
+
+render_buffer_t *render_buffer_init(void) {
+  render_buffer_t *buffer = malloc(sizeof(render_buffer_t));
+  assert(buffer != NULL);
+  for (size_t f = 0; f < 3; f++) {
+    buffer->frames[f] = (render_frame_t) {NULL, 0, NULL, 0, 0, 0, 0, 0};
+  }
+  buffer->front = 0;
+  atomic_init(&buffer->ready, 1);
+  buffer->back = 2;
+  buffer->published = 0;
+  return buffer;
+}
+
+void render_buffer_free(render_buffer_t *buffer) {
+  for (size_t f = 0; f < 3; f++) {
+    free(buffer->frames[f].bodies);
+    free(buffer->frames[f].vertices);
+  }
+  free(buffer);
+}
+
+/**
+ * Copies a scene's bodies into a frame, growing its arrays if needed.
+ */
+void render_frame_copy(render_frame_t *frame, scene_t *scene, double alpha) {
+  size_t body_count = scene_bodies(scene);
+  size_t vertex_count = 0;
+  for (size_t i = 0; i < body_count; i++) {
+    vertex_count += list_size(scene_get_body(scene, i)->shape);
+  }
+  if (body_count > frame->body_capacity) {
+    frame->body_capacity = body_count;
+    frame->bodies = realloc(frame->bodies, \
+      body_count * sizeof(render_body_t));
+    assert(frame->bodies != NULL);
+  }
+  if (vertex_count > frame->vertex_capacity) {
+    frame->vertex_capacity = vertex_count;
+    frame->vertices = realloc(frame->vertices, \
+      vertex_count * sizeof(vector_t));
+    assert(frame->vertices != NULL);
+  }
+
+  size_t first = 0;
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    size_t n = list_size(body->shape);
+    frame->bodies[i] = (render_body_t) {
+      body->centroid, body->orientation,
+      body->prev_centroid, body->prev_orientation,
+      body->color, first, n
+    };
+    for (size_t v = 0; v < n; v++) {
+      frame->vertices[first + v] = *(vector_t *) list_get(body->shape, v);
+    }
+    first += n;
+  }
+  frame->body_count = body_count;
+  frame->vertex_count = vertex_count;
+  frame->alpha = alpha;
+}
+
+void render_buffer_publish(render_buffer_t *buffer, scene_t *scene, \
+  double alpha) {
+  TRACE_BEGIN("publish");
+  render_frame_t *frame = &buffer->frames[buffer->back];
+  render_frame_copy(frame, scene, alpha);
+  frame->sequence = ++buffer->published;
+  buffer->back = atomic_exchange(&buffer->ready, \
+    buffer->back | FRESH_FRAME) & FRAME_INDEX;
+  TRACE_END("publish");
+}
+
+const render_frame_t *render_buffer_acquire(render_buffer_t *buffer) {
+  if (atomic_load(&buffer->ready) & FRESH_FRAME) {
+    buffer->front = atomic_exchange(&buffer->ready, buffer->front) & \
+      FRAME_INDEX;
+  }
+  return &buffer->frames[buffer->front];
+}
@@ -4,11 +4,28 @@
 #include <stdio.h>
 #include "color.h"
 #include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
 #include "polygon.h"
 #include "body.h"
 #include "list.h"
+#include "forces.h"
+#include "worker_pool.h"
+#include "render_buffer.h"
+#include "spatial_index.h"
 
 const int NUMBER_BODIES = 10;
+const size_t INIT_TYPED_FORCES = 8;
+// Fewest built-in forces worth splitting between threads
+const size_t MIN_PARALLEL_FORCES = 1024;
+// Fewest collision records worth checking on several threads
+const size_t MIN_PARALLEL_COLLISIONS = 256;
+// Fewest bodies worth integrating on several threads
+const size_t MIN_PARALLEL_BODIES = 1024;
+// Fewest rays worth casting on several threads
+const size_t MIN_PARALLEL_RAYS = 256;
 
 typedef struct force {
   void *aux;
@@ -16,6 +33,14 @@ typedef struct force {
   free_func_t freer;
   list_t *bodies;
   int forRemoval;
+  // Slot of the force in each body's reverse index, parallel to bodies
+  size_t *ref_slots;
+  // If non-NULL, incremented when the force is marked for removal
+  size_t *tombstones;
+  // Whether the force creator is a solver (see scene_add_solver())
+  bool solver;
+  // If non-NULL, copies aux for a fork of the scene
+  force_copier_t copier;
 } force_t;
 
 force_t *force_init(void *aux, force_creator_t forcer, free_func_t freer) {
@@ -26,6 +51,10 @@ force_t *force_init(void *aux, force_creator_t forcer, free_func_t freer) {
   toReturn->freer = freer;
   toReturn->bodies = NULL;
   toReturn->forRemoval = 0;
+  toReturn->ref_slots = NULL;
+  toReturn->tombstones = NULL;
+  toReturn->solver = false;
+  toReturn->copier = NULL;
   return toReturn;
 }
 
@@ -37,6 +66,9 @@ force_t *force_init2(void *aux, force_creator_t forcer, free_func_t freer, \
 }
 
 void force_remove(force_t *f){
+  if (!f->forRemoval && f->tombstones != NULL) {
+    (*f->tombstones)++;
+  }
   f->forRemoval = 1;
 }
 
@@ -45,26 +77,257 @@ int force_is_removed(force_t *f){
 }
 
 void force_free(force_t *f) {
-  f->freer(f->aux);
+  if (f->freer != NULL) {
+    f->freer(f->aux);
+  }
+  if (f->bodies != NULL) {
+    list_free(f->bodies);
+  }
+  free(f->ref_slots);
   free(f);
 }
 
+/**
+ * The built-in forces of one kind, stored contiguously by value,
+ * with parallel arrays of bookkeeping for removing them.
+ */
+typedef struct force_group {
+  aux_t *forces;
+  // Whether each force has been marked for removal
+  bool *removed;
+  // Slot of each force in its body1's and body2's reverse index of forces
+  size_t *slots1;
+  size_t *slots2;
+  // Force on body1 of each force, computed by the parallel force phase
+  vector_t *outputs;
+  size_t size;
+  size_t capacity;
+  size_t tombstones;
+} force_group_t;
+
+/**
+ * The batched evaluator for each kind of force, indexed by force_kind_t.
+ * Collisions are evaluated one at a time instead (see scene_tick()).
+ */
+void (*const FORCE_BATCHES[NUM_FORCE_KINDS])(aux_t *forces, size_t count) = {
+  [FORCE_GRAVITY] = gravity_creator_batch,
+  [FORCE_SPRING] = spring_creator_batch,
+  [FORCE_DRAG] = drag_creator_batch,
+  [FORCE_COLLISION] = NULL
+};
+
+/**
+ * The evaluator for each kind of force that computes the forces
+ * without applying them, for the parallel force phase.
+ */
+void (*const FORCE_KERNELS[NUM_FORCE_KINDS])(aux_t *forces, size_t count, \
+  vector_t *out) = {
+  [FORCE_GRAVITY] = gravity_force_batch,
+  [FORCE_SPRING] = spring_force_batch,
+  [FORCE_DRAG] = drag_force_batch,
+  [FORCE_COLLISION] = NULL
+};
+
+/**
+ * The kinds of mutations to a scene that can be deferred.
+ */
+typedef enum {
+  COMMAND_ADD_BODY,
+  COMMAND_REMOVE_BODY,
+  COMMAND_ADD_FORCE,
+  COMMAND_ADD_TYPED_FORCE,
+  COMMAND_REMOVE_FORCE,
+  // A body that left the world bounds, to pass to the bounds handler
+  COMMAND_OUT_OF_BOUNDS
+} command_kind_t;
+
+/**
+ * A mutation to a scene recorded during a tick, to be applied later.
+ */
+typedef struct command {
+  command_kind_t kind;
+  // The body to add or remove
+  body_t *body;
+  // The force creator to add or remove
+  force_t *force;
+  // The built-in force to add, and its kind
+  force_kind_t force_kind;
+  aux_t record;
+} command_t;
+
+/**
+ * The commands recorded by one thread, in the order they were issued.
+ */
+typedef struct command_buffer {
+  command_t *commands;
+  size_t size;
+  size_t capacity;
+  // Times the buffer has grown since its commands were last applied
+  size_t allocations;
+} command_buffer_t;
+
+/**
+ * The kind in a force_ref_t that refers to a force creator
+ * in the scene's list of forces.
+ */
+const int FORCE_CREATOR = NUM_FORCE_KINDS;
+
 typedef struct scene {
   list_t *bodies;
   list_t *forces;
+  force_group_t groups[NUM_FORCE_KINDS];
+  // Number of force creators marked for removal since the last tick
+  size_t creator_tombstones;
+  // Bodies marked for removal since the last tick
+  list_t *graveyard;
+  double drag;
+  double dt;
+  // Threads to split the forces, collisions, and integration between,
+  // or NULL to run them on the calling thread
+  worker_pool_t *pool;
+  bool owns_pool;
+  // Result of checking each collision record, for the parallel collision phase
+  collision_info_t *contacts;
+  size_t contact_capacity;
+  // Time not yet simulated by scene_step_fixed()
+  double accumulator;
+  double alpha;
+  // Incremented whenever bodies or forces are added or removed,
+  // which snapshots taken before can't be restored across
+  size_t structure;
+  // If non-NULL, each tick's bodies are published to it for drawing
+  render_buffer_t *render_buffer;
+  // Map from body handles to bodies: the body in each slot (NULL if free)
+  // and the generation of handles to it
+  body_t **slots;
+  size_t *generations;
+  size_t slot_count;
+  size_t slot_capacity;
+  // Stack of free slots, reused before new slots are added
+  size_t *free_slots;
+  size_t free_count;
+  // Whether a tick is calling force creators, collision handlers, or solvers,
+  // whose mutations to the scene are deferred
+  bool deferring;
+  // Whether a tick is running, so removed bodies can't be freed until it ends
+  bool ticking;
+  // Mutations deferred during a tick, one buffer per thread of the pool
+  command_buffer_t *commands;
+  size_t command_buffers;
+  // Guards buffer 0, which every thread outside the pool shares: the one
+  // ticking the scene, and any ticking another scene that shares the pool
+  // and runs this one's callbacks while waiting for its own
+  pthread_mutex_t command_lock;
+  // Grid of the bodies' bounding boxes for spatial queries, built on the
+  // first query after the bodies have moved or been added or removed
+  spatial_index_t *index;
+  bool index_stale;
+  size_t index_structure;
+  // Timings and counters of the latest ticks, or NULL until they are enabled
+  tick_stats_t *stats;
+  // Box the bodies are kept in by their bounds policies, if has_bounds
+  bool has_bounds;
+  aabb_t bounds;
+  bounds_handler_t bounds_handler;
+  void *bounds_aux;
+  // The scene this one was forked from, if any, and the number of forks
+  // of this one not yet freed, which borrow its bodies' info
+  struct scene *parent;
+  atomic_size_t forks;
 } scene_t;
 
+void typed_force_free(aux_t *force) {
+  if (force->freer != NULL && force->aux != NULL) {
+    force->freer(force->aux);
+  }
+}
+
 scene_t *scene_init(void) {
   scene_t *toReturn = malloc(sizeof(scene_t));
   assert(toReturn != NULL);
   toReturn->bodies = list_init(NUMBER_BODIES, (free_func_t) body_free);
   toReturn->forces = list_init(1, (free_func_t) force_free);
+  for (size_t k = 0; k < NUM_FORCE_KINDS; k++) {
+    toReturn->groups[k] = (force_group_t) {
+      NULL, NULL, NULL, NULL, NULL, 0, 0, 0
+    };
+  }
+  toReturn->creator_tombstones = 0;
+  toReturn->graveyard = list_init(1, NULL);
+  toReturn->drag = 0;
+  toReturn->dt = 0;
+  toReturn->pool = NULL;
+  toReturn->owns_pool = false;
+  toReturn->contacts = NULL;
+  toReturn->contact_capacity = 0;
+  toReturn->accumulator = 0;
+  toReturn->alpha = 0;
+  toReturn->structure = 0;
+  toReturn->render_buffer = NULL;
+  toReturn->slots = NULL;
+  toReturn->generations = NULL;
+  toReturn->slot_count = 0;
+  toReturn->slot_capacity = 0;
+  toReturn->free_slots = NULL;
+  toReturn->free_count = 0;
+  toReturn->deferring = false;
+  toReturn->ticking = false;
+  toReturn->commands = NULL;
+  toReturn->command_buffers = 0;
+  pthread_mutex_init(&toReturn->command_lock, NULL);
+  toReturn->index = NULL;
+  toReturn->index_stale = true;
+  toReturn->index_structure = 0;
+  toReturn->stats = NULL;
+#ifdef TRACE
+  // Phases are traced as they are timed
+  scene_enable_stats(toReturn);
+#endif
+  toReturn->has_bounds = false;
+  toReturn->bounds_handler = NULL;
+  toReturn->bounds_aux = NULL;
+  toReturn->parent = NULL;
+  atomic_init(&toReturn->forks, 0);
   return toReturn;
 }
 
 void scene_free(scene_t *scene) {
+  assert(atomic_load(&scene->forks) == 0);
   list_free(scene->bodies);
   list_free(scene->forces);
+  for (size_t k = 0; k < NUM_FORCE_KINDS; k++) {
+    force_group_t *group = &scene->groups[k];
+    for (size_t i = 0; i < group->size; i++) {
+      typed_force_free(&group->forces[i]);
+    }
+    free(group->forces);
+    free(group->removed);
+    free(group->slots1);
+    free(group->slots2);
+    free(group->outputs);
+  }
+  list_free(scene->graveyard);
+  if (scene->owns_pool) {
+    worker_pool_free(scene->pool);
+  }
+  free(scene->contacts);
+  free(scene->slots);
+  free(scene->generations);
+  free(scene->free_slots);
+  for (size_t t = 0; t < scene->command_buffers; t++) {
+    free(scene->commands[t].commands);
+  }
+  free(scene->commands);
+  pthread_mutex_destroy(&scene->command_lock);
+  if (scene->index != NULL) {
+    spatial_index_free(scene->index);
+  }
+  if (scene->stats != NULL) {
+    tick_stats_free(scene->stats);
+  }
+  if (scene->parent != NULL) {
+    atomic_fetch_sub(&scene->parent->forks, 1);
+  }
   free(scene);
 }
 
@@ -76,12 +339,145 @@ body_t *scene_get_body(scene_t *scene, size_t index) {
   return (body_t*) list_get(scene->bodies, index);
 }
 
+size_t scene_typed_forces(scene_t *scene, force_kind_t kind) {
+  assert(kind < NUM_FORCE_KINDS);
+  return scene->groups[kind].size;
+}
+
 force_t *scene_get_force(scene_t *scene, size_t index) {
   return (force_t*) list_get(scene->forces, index);
 }
 
+/**
+ * Gives a body a slot in a scene's map of handles,
+ * reusing the most recently freed slot if there is one.
+ */
+void scene_assign_slot(scene_t *scene, body_t *body) {
+  if (scene->free_count > 0) {
+    body->slot = scene->free_slots[--scene->free_count];
+    scene->slots[body->slot] = body;
+    return;
+  }
+  if (scene->slot_count == scene->slot_capacity) {
+    scene->slot_capacity = 2 * scene->slot_capacity + NUMBER_BODIES;
+    scene->slots = realloc(scene->slots, \
+      scene->slot_capacity * sizeof(body_t *));
+    scene->generations = realloc(scene->generations, \
+      scene->slot_capacity * sizeof(size_t));
+    scene->free_slots = realloc(scene->free_slots, \
+      scene->slot_capacity * sizeof(size_t));
+    assert(scene->slots != NULL && scene->generations != NULL &&
+      scene->free_slots != NULL);
+    tick_stats_count(scene->stats, TICK_ALLOCATIONS, 3);
+  }
+  body->slot = scene->slot_count++;
+  scene->slots[body->slot] = body;
+  // Generations start at 1, so the handle {0, 0} is never valid
+  scene->generations[body->slot] = 1;
+}
+
+/**
+ * Frees the slot of a body removed from a scene,
+ * invalidating every handle to it.
+ */
+void scene_free_slot(scene_t *scene, body_t *body) {
+  scene->slots[body->slot] = NULL;
+  scene->generations[body->slot]++;
+  scene->free_slots[scene->free_count++] = body->slot;
+}
+
+/**
+ * Gets the calling thread's buffer of deferred commands,
+ * or NULL if mutations to a scene should be applied at once.
+ * A buffer shared with other threads is locked until it is released
+ * with scene_release_command_buffer().
+ */
+command_buffer_t *scene_command_buffer(scene_t *scene) {
+  if (!scene->deferring) {
+    return NULL;
+  }
+  if (scene->pool == NULL) {
+    return &scene->commands[0];
+  }
+  size_t t = worker_pool_thread_index(scene->pool);
+  if (t == 0) {
+    pthread_mutex_lock(&scene->command_lock);
+  }
+  return &scene->commands[t];
+}
+
+/**
+ * Releases a buffer returned from scene_command_buffer().
+ */
+void scene_release_command_buffer(scene_t *scene, command_buffer_t *buffer) {
+  if (scene->pool != NULL && buffer == &scene->commands[0]) {
+    pthread_mutex_unlock(&scene->command_lock);
+  }
+}
+
+/**
+ * Adds a command to the end of a buffer.
+ */
+void command_push(command_buffer_t *buffer, command_t command) {
+  if (buffer->size == buffer->capacity) {
+    buffer->capacity = 2 * buffer->capacity + 1;
+    buffer->commands = realloc(buffer->commands, \
+      buffer->capacity * sizeof(command_t));
+    assert(buffer->commands != NULL);
+    buffer->allocations++;
+  }
+  buffer->commands[buffer->size++] = command;
+}
+
 void scene_add_body(scene_t *scene, body_t *body) {
+  command_buffer_t *buffer = scene_command_buffer(scene);
+  if (buffer != NULL) {
+    command_push(buffer, (command_t) {.kind = COMMAND_ADD_BODY, .body = body});
+    scene_release_command_buffer(scene, buffer);
+    return;
+  }
   list_add(scene->bodies, body);
+  scene_assign_slot(scene, body);
+  scene->structure++;
+  body->graveyard = scene->graveyard;
+  body_save_pose(body);
+  if (body_is_removed(body)) {
+    list_add(scene->graveyard, body);
+  }
+}
+
+body_handle_t scene_get_handle(scene_t *scene, body_t *body) {
+  assert(body->slot < scene->slot_count && scene->slots[body->slot] == body);
+  return (body_handle_t) {body->slot, scene->generations[body->slot]};
+}
+
+body_t *scene_lookup(scene_t *scene, body_handle_t handle) {
+  if (handle.index >= scene->slot_count || \
+    scene->generations[handle.index] != handle.generation) {
+    return NULL;
+  }
+  body_t *body = scene->slots[handle.index];
+  return body_is_removed(body) ? NULL : body;
+}
+
+bool scene_handle_valid(scene_t *scene, body_handle_t handle) {
+  return scene_lookup(scene, handle) != NULL;
+}
+
+bool scene_remove_handle(scene_t *scene, body_handle_t handle) {
+  body_t *body = scene_lookup(scene, handle);
+  if (body == NULL) {
+    return false;
+  }
+  command_buffer_t *buffer = scene_command_buffer(scene);
+  if (buffer != NULL) {
+    command_push(buffer, \
+      (command_t) {.kind = COMMAND_REMOVE_BODY, .body = body});
+    scene_release_command_buffer(scene, buffer);
+    return true;
+  }
+  body_remove(body);
+  return true;
 }
 
 //deprecated
@@ -89,55 +485,1371 @@ void scene_remove_body(scene_t *scene, size_t index) {
   body_remove(scene_get_body(scene, index));
 }
 
+/**
+ * Finds where a force stores the slot of a reference to it
+ * in a body's reverse index of forces.
+ */
+size_t *force_ref_slot(scene_t *scene, force_ref_t ref) {
+  if (ref.kind == FORCE_CREATOR) {
+    force_t *f = list_get(scene->forces, ref.index);
+    return &f->ref_slots[ref.position];
+  }
+  force_group_t *group = &scene->groups[ref.kind];
+  return ref.position == 0 ?
+    &group->slots1[ref.index] : &group->slots2[ref.index];
+}
+
+/**
+ * Removes a force from a body's reverse index of forces,
+ * fixing up the slot of the reference moved into its place.
+ */
+void force_ref_detach(scene_t *scene, body_t *body, size_t slot) {
+  if (body_remove_force_ref(body, slot)) {
+    *force_ref_slot(scene, body->force_refs[slot]) = slot;
+  }
+}
+
+/**
+ * Points the references to a force in a body's reverse index
+ * at the force's new index after it is moved.
+ */
+void force_ref_move(body_t *body, size_t slot, size_t index) {
+  body->force_refs[slot].index = index;
+}
+
+/**
+ * Removes the forces marked for removal from a group,
+ * keeping the remaining forces in order.
+ */
+void force_group_compact(scene_t *scene, force_group_t *group) {
+  size_t kept = 0;
+  for (size_t i = 0; i < group->size; i++) {
+    aux_t *f = &group->forces[i];
+    if (group->removed[i]) {
+      if (!body_is_removed(f->body1)) {
+        force_ref_detach(scene, f->body1, group->slots1[i]);
+      }
+      if (f->body2 != NULL && !body_is_removed(f->body2)) {
+        force_ref_detach(scene, f->body2, group->slots2[i]);
+      }
+      typed_force_free(f);
+      continue;
+    }
+    if (kept != i) {
+      group->forces[kept] = *f;
+      group->removed[kept] = false;
+      group->slots1[kept] = group->slots1[i];
+      group->slots2[kept] = group->slots2[i];
+      force_ref_move(f->body1, group->slots1[kept], kept);
+      if (f->body2 != NULL) {
+        force_ref_move(f->body2, group->slots2[kept], kept);
+      }
+    }
+    kept++;
+  }
+  group->size = kept;
+  group->tombstones = 0;
+  scene->structure++;
+}
+
+/**
+ * Removes and frees the force creators marked for removal,
+ * keeping the remaining force creators in order.
+ */
+void scene_compact_forces(scene_t *scene) {
+  size_t kept = 0;
+  size_t size = list_size(scene->forces);
+  for (size_t i = 0; i < size; i++) {
+    force_t *f = list_get(scene->forces, i);
+    size_t n = list_size(f->bodies);
+    if (force_is_removed(f)) {
+      for (size_t j = 0; j < n; j++) {
+        body_t *body = list_get(f->bodies, j);
+        if (!body_is_removed(body)) {
+          force_ref_detach(scene, body, f->ref_slots[j]);
+        }
+      }
+      force_free(f);
+      continue;
+    }
+    if (kept != i) {
+      list_set(scene->forces, kept, f);
+      for (size_t j = 0; j < n; j++) {
+        force_ref_move(list_get(f->bodies, j), f->ref_slots[j], kept);
+      }
+    }
+    kept++;
+  }
+  list_truncate(scene->forces, kept);
+  scene->creator_tombstones = 0;
+  scene->structure++;
+}
+
 void scene_remove_force(scene_t *scene, size_t index) {
-  list_remove(scene->forces, index);
+  force_t *f = scene_get_force(scene, index);
+  command_buffer_t *buffer = scene_command_buffer(scene);
+  if (buffer != NULL) {
+    command_push(buffer, (command_t) {.kind = COMMAND_REMOVE_FORCE, .force = f});
+    scene_release_command_buffer(scene, buffer);
+    return;
+  }
+  force_remove(f);
+  scene_compact_forces(scene);
 }
 
 //deprecated
 void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
                              free_func_t freer) {
-  scene_add_bodies_force_creator(scene, forcer, aux, list_init(1, freer), freer);
+  scene_add_bodies_force_creator(scene, forcer, aux, list_init(1, NULL), freer);
+}
+
+/**
+ * Adds a force creator to a scene's list of forces,
+ * registering it with the bodies it acts on,
+ * or defers adding it until the end of the tick's callbacks.
+ */
+void scene_add_force(scene_t *scene, force_t *f) {
+  command_buffer_t *buffer = scene_command_buffer(scene);
+  if (buffer != NULL) {
+    command_push(buffer, (command_t) {.kind = COMMAND_ADD_FORCE, .force = f});
+    scene_release_command_buffer(scene, buffer);
+    return;
+  }
+  size_t n = list_size(f->bodies);
+  f->tombstones = &scene->creator_tombstones;
+  for (size_t i = 0; i < n; i++) {
+    force_ref_t ref = {FORCE_CREATOR, list_size(scene->forces), i};
+    f->ref_slots[i] = body_add_force_ref(list_get(f->bodies, i), ref);
+  }
+  list_add(scene->forces, f);
+  scene->structure++;
+}
 
+/**
+ * Allocates a force creator for a scene, not yet added to it.
+ */
+force_t *scene_force_init(force_creator_t forcer, void *aux, list_t *bodies, \
+  free_func_t freer) {
+  force_t *f = force_init2(aux, forcer, freer, bodies);
+  size_t n = list_size(bodies);
+  f->ref_slots = malloc(n * sizeof(size_t));
+  assert(n == 0 || f->ref_slots != NULL);
+  return f;
 }
 
 void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer, \
   void *aux, list_t *bodies, free_func_t freer){
-  list_add(scene->forces, force_init2(aux, forcer, freer, bodies));
+  scene_add_force(scene, scene_force_init(forcer, aux, bodies, freer));
+}
+
+void scene_add_solver(scene_t *scene, force_creator_t solver, void *aux, \
+  list_t *bodies, free_func_t freer) {
+  force_t *f = scene_force_init(solver, aux, bodies, freer);
+  f->solver = true;
+  scene_add_force(scene, f);
+}
+
+void scene_set_force_copier(scene_t *scene, force_copier_t copier) {
+  // The force may still be waiting in the calling thread's buffer
+  command_buffer_t *buffer = scene_command_buffer(scene);
+  force_t *f;
+  if (buffer != NULL && buffer->size > 0 && \
+    buffer->commands[buffer->size - 1].kind == COMMAND_ADD_FORCE) {
+    f = buffer->commands[buffer->size - 1].force;
+  }
+  else {
+    f = list_get(scene->forces, list_size(scene->forces) - 1);
+  }
+  f->copier = copier;
+  if (buffer != NULL) {
+    scene_release_command_buffer(scene, buffer);
+  }
+}
+
+void scene_add_typed_force(scene_t *scene, force_kind_t kind, aux_t *force) {
+  assert(kind < NUM_FORCE_KINDS);
+  assert(force->body1 != NULL);
+  assert(force->body1 != force->body2);
+  command_buffer_t *buffer = scene_command_buffer(scene);
+  if (buffer != NULL) {
+    command_push(buffer, (command_t) {
+      .kind = COMMAND_ADD_TYPED_FORCE, .force_kind = kind, .record = *force
+    });
+    scene_release_command_buffer(scene, buffer);
+    return;
+  }
+  force_group_t *group = &scene->groups[kind];
+  if (group->size == group->capacity) {
+    group->capacity = group->capacity == 0 ? INIT_TYPED_FORCES : \
+      2 * group->capacity;
+    group->forces = realloc(group->forces, group->capacity * sizeof(aux_t));
+    group->removed = realloc(group->removed, group->capacity * sizeof(bool));
+    group->slots1 = realloc(group->slots1, group->capacity * sizeof(size_t));
+    group->slots2 = realloc(group->slots2, group->capacity * sizeof(size_t));
+    group->outputs = realloc(group->outputs, \
+      group->capacity * sizeof(vector_t));
+    assert(group->forces != NULL && group->removed != NULL &&
+      group->slots1 != NULL && group->slots2 != NULL &&
+      group->outputs != NULL);
+    tick_stats_count(scene->stats, TICK_ALLOCATIONS, 5);
+  }
+  size_t i = group->size++;
+  scene->structure++;
+  group->forces[i] = *force;
+  group->removed[i] = false;
+  group->slots1[i] = body_add_force_ref(force->body1, \
+    (force_ref_t) {kind, i, 0});
+  if (force->body2 != NULL) {
+    group->slots2[i] = body_add_force_ref(force->body2, \
+      (force_ref_t) {kind, i, 1});
+  }
+}
+
+void scene_set_drag(scene_t *scene, double gamma) {
+  scene->drag = gamma;
+}
+
+double scene_get_drag(scene_t *scene) {
+  return scene->drag;
+}
+
+void scene_set_bounds(scene_t *scene, aabb_t bounds, bounds_handler_t handler, \
+  void *aux) {
+  assert(bounds.min.x <= bounds.max.x && bounds.min.y <= bounds.max.y);
+  scene->has_bounds = true;
+  scene->bounds = bounds;
+  scene->bounds_handler = handler;
+  scene->bounds_aux = aux;
+}
+
+void scene_clear_bounds(scene_t *scene) {
+  scene->has_bounds = false;
+  scene->bounds_handler = NULL;
+  scene->bounds_aux = NULL;
+}
+
+void scene_set_threads(scene_t *scene, size_t threads) {
+  assert(threads > 0);
+  worker_pool_t *pool = threads > 1 ? worker_pool_init(threads) : NULL;
+  scene_set_pool(scene, pool);
+  scene->owns_pool = pool != NULL;
+}
+
+void scene_set_pool(scene_t *scene, worker_pool_t *pool) {
+  if (scene->owns_pool) {
+    worker_pool_free(scene->pool);
+  }
+  scene->pool = pool;
+  scene->owns_pool = false;
+}
+
+void scene_set_render_buffer(scene_t *scene, render_buffer_t *buffer) {
+  scene->render_buffer = buffer;
+}
+
+/**
+ * Marks every force acting on a removed body for removal,
+ * using the body's reverse index of forces.
+ */
+void scene_tombstone_forces(scene_t *scene, body_t *body) {
+  for (size_t r = 0; r < body->force_ref_count; r++) {
+    force_ref_t ref = body->force_refs[r];
+    if (ref.kind == FORCE_CREATOR) {
+      force_remove(list_get(scene->forces, ref.index));
+      continue;
+    }
+    force_group_t *group = &scene->groups[ref.kind];
+    if (!group->removed[ref.index]) {
+      group->removed[ref.index] = true;
+      group->tombstones++;
+    }
+  }
+}
+
+/**
+ * Checks whether a body in a scene's list of bodies has been removed.
+ */
+bool body_is_reaped(void *body, void *aux) {
+  return body_is_removed(body);
+}
+
+/**
+ * Marks every force acting on a body marked for removal for removal,
+ * returning the number of forces marked for removal in all.
+ */
+size_t scene_tombstone_graveyard(scene_t *scene) {
+  size_t dead = list_size(scene->graveyard);
+  for (size_t d = 0; d < dead; d++) {
+    scene_tombstone_forces(scene, list_get(scene->graveyard, d));
+  }
+  size_t tombstones = scene->creator_tombstones;
+  for (size_t k = 0; k < NUM_FORCE_KINDS; k++) {
+    tombstones += scene->groups[k].tombstones;
+  }
+  return tombstones;
+}
+
+/**
+ * Removes the bodies and forces marked for removal
+ * from the scene's arrays, once their forces are marked.
+ */
+void scene_compact(scene_t *scene) {
+  size_t dead = list_size(scene->graveyard);
+  for (size_t k = 0; k < NUM_FORCE_KINDS; k++) {
+    if (scene->groups[k].tombstones > 0) {
+      force_group_compact(scene, &scene->groups[k]);
+    }
+  }
+  if (scene->creator_tombstones > 0) {
+    scene_compact_forces(scene);
+  }
+
+  if (dead == 0) {
+    return;
+  }
+  for (size_t d = 0; d < dead; d++) {
+    scene_free_slot(scene, list_get(scene->graveyard, d));
+  }
+  list_remove_if(scene->bodies, body_is_reaped, NULL);
+  // The scene owns its bodies, so they are freed once nothing refers to them
+  for (size_t d = 0; d < dead; d++) {
+    body_free(list_get(scene->graveyard, d));
+  }
+  list_truncate(scene->graveyard, 0);
+  scene->structure++;
+}
+
+/**
+ * Removes the bodies marked for removal and every force acting on them.
+ * Only the forces of the removed bodies are visited to find the forces
+ * to remove, and nothing is scanned if no body or force was removed.
+ */
+void scene_reap(scene_t *scene) {
+  scene_tombstone_graveyard(scene);
+  scene_compact(scene);
+}
+
+size_t scene_remove_if(scene_t *scene, body_predicate_t predicate, void *aux) {
+  size_t n = scene_bodies(scene);
+  size_t removed = 0;
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (!predicate(body, aux)) {
+      removed += body_is_removed(body);
+      continue;
+    }
+    removed++;
+    command_buffer_t *buffer = scene_command_buffer(scene);
+    if (buffer != NULL) {
+      command_push(buffer, \
+        (command_t) {.kind = COMMAND_REMOVE_BODY, .body = body});
+      scene_release_command_buffer(scene, buffer);
+    }
+    else {
+      body_remove(body);
+    }
+  }
+  // A tick may still be looping over the bodies, e.g. calling the
+  // handlers of their collisions, so it reaps them once it is done
+  if (!scene->ticking) {
+    scene_reap(scene);
+  }
+  return removed;
+}
+
+double scene_get_dt(scene_t *scene) {
+  return scene->dt;
+}
+
+/**
+ * Computes a thread's share of the built-in forces into the groups' outputs:
+ * those with indices in [start, end), counting through the kinds in order.
+ * Each force is written to its own output, so threads never share writes.
+ */
+void force_task(void *aux, size_t start, size_t end) {
+  scene_t *scene = aux;
+  size_t offset = 0;
+  for (size_t k = 0; k < NUM_FORCE_KINDS; k++) {
+    if (FORCE_KERNELS[k] == NULL) {
+      continue;
+    }
+    force_group_t *group = &scene->groups[k];
+    size_t first = start > offset ? start - offset : 0;
+    size_t last = end > offset ? end - offset : 0;
+    last = last < group->size ? last : group->size;
+    if (first < last) {
+      FORCE_KERNELS[k](group->forces + first, last - first, \
+        group->outputs + first);
+    }
+    offset += group->size;
+  }
+}
+
+/**
+ * Applies the built-in forces computed by force_task() to the bodies
+ * in the same order as the serial loops. Every force is computed the same
+ * way on any thread and summed in the same order, so the result does not
+ * depend on the number of threads.
+ */
+void scene_apply_force_outputs(scene_t *scene) {
+  for (size_t k = 0; k < NUM_FORCE_KINDS; k++) {
+    if (FORCE_KERNELS[k] == NULL) {
+      continue;
+    }
+    force_group_t *group = &scene->groups[k];
+    for (size_t i = 0; i < group->size; i++) {
+      aux_t *f = &group->forces[i];
+      body_add_force(f->body1, group->outputs[i]);
+      if (f->body2 != NULL) {
+        body_add_force(f->body2, vec_negate(group->outputs[i]));
+      }
+    }
+  }
+}
+
+/**
+ * Checks a thread's share of the collision records for collisions,
+ * storing the results in the scene's contacts.
+ */
+void collision_task(void *aux, size_t start, size_t end) {
+  scene_t *scene = aux;
+  aux_t *collisions = scene->groups[FORCE_COLLISION].forces;
+  for (size_t c = start; c < end; c++) {
+    scene->contacts[c] = find_collision(collisions[c].body1->shape, \
+      collisions[c].body2->shape);
+  }
+}
+
+/**
+ * Makes room for the results of checking count collision records.
+ */
+void scene_reserve_contacts(scene_t *scene, size_t count) {
+  if (count > scene->contact_capacity) {
+    scene->contact_capacity = count;
+    scene->contacts = realloc(scene->contacts, \
+      count * sizeof(collision_info_t));
+    assert(scene->contacts != NULL);
+    tick_stats_count(scene->stats, TICK_ALLOCATIONS, 1);
+  }
+}
+
+/**
+ * Gets how far a box spanning [low, high] along one axis must move
+ * to lie within [min, max], lining it up with min if it is too big to fit.
+ */
+double clamp_shift(double low, double high, double min, double max) {
+  if (low < min || high - low > max - min) {
+    return min - low;
+  }
+  return high > max ? max - high : 0;
+}
+
+/**
+ * Gets how far a box spanning [low, high] along one axis must move,
+ * once it is entirely past one end of [min, max],
+ * to come back in through the other end by as much as it overshot.
+ */
+double wrap_shift(double low, double high, double min, double max) {
+  double period = (max - min) + (high - low);
+  if (low > max) {
+    return -period;
+  }
+  return high < min ? period : 0;
+}
+
+/**
+ * Applies a body's bounds policy after it has been integrated.
+ * Clamping and wrapping only move the body itself, so they happen at once;
+ * removals and handler calls change the scene, so they are deferred.
+ */
+void scene_enforce_bounds(scene_t *scene, body_t *body) {
+  aabb_t box = body->bounds;
+  aabb_t world = scene->bounds;
+  vector_t shift = VEC_ZERO;
+  switch (body->bounds_policy) {
+    case BOUNDS_IGNORE:
+      return;
+    case BOUNDS_CLAMP:
+      shift.x = clamp_shift(box.min.x, box.max.x, world.min.x, world.max.x);
+      shift.y = clamp_shift(box.min.y, box.max.y, world.min.y, world.max.y);
+      body_set_centroid(body, vec_add(body->centroid, shift));
+      // Only the velocity out of the bounds is lost
+      if (shift.x * body->velocity.x < 0) {
+        body->velocity.x = 0;
+      }
+      if (shift.y * body->velocity.y < 0) {
+        body->velocity.y = 0;
+      }
+      return;
+    case BOUNDS_WRAP:
+      shift.x = wrap_shift(box.min.x, box.max.x, world.min.x, world.max.x);
+      shift.y = wrap_shift(box.min.y, box.max.y, world.min.y, world.max.y);
+      body_set_centroid(body, vec_add(body->centroid, shift));
+      // The body jumps rather than sweeping across the world when drawn
+      body->prev_centroid = vec_add(body->prev_centroid, shift);
+      return;
+    case BOUNDS_REMOVE:
+    case BOUNDS_CALLBACK:
+      if (aabb_overlap(box, world)) {
+        return;
+      }
+      command_buffer_t *buffer = scene_command_buffer(scene);
+      command_push(buffer, (command_t) {
+        .kind = body->bounds_policy == BOUNDS_REMOVE ? \
+          COMMAND_REMOVE_BODY : COMMAND_OUT_OF_BOUNDS,
+        .body = body
+      });
+      scene_release_command_buffer(scene, buffer);
+      return;
+  }
+}
+
+/**
+ * Ticks a thread's share of the scene's bodies,
+ * and applies their bounds policies if the scene has bounds.
+ * Each body only moves itself, so bodies can be ticked in any order.
+ */
+void body_tick_task(void *aux, size_t start, size_t end) {
+  scene_t *scene = aux;
+  bool bounded = scene->has_bounds;
+  for (size_t i = start; i < end; i++) {
+    body_t *body = scene_get_body(scene, i);
+    body_tick_with_drag(body, scene->dt, scene->drag);
+    if (bounded && !body_is_removed(body)) {
+      scene_enforce_bounds(scene, body);
+    }
+  }
+}
+
+/**
+ * Starts deferring mutations to a scene, with a buffer for each thread
+ * that might call back into it.
+ */
+void scene_begin_deferring(scene_t *scene) {
+  size_t threads = scene->pool != NULL ? worker_pool_threads(scene->pool) : 1;
+  if (threads > scene->command_buffers) {
+    scene->commands = realloc(scene->commands, \
+      threads * sizeof(command_buffer_t));
+    assert(scene->commands != NULL);
+    for (size_t t = scene->command_buffers; t < threads; t++) {
+      scene->commands[t] = (command_buffer_t) {NULL, 0, 0, 0};
+    }
+    scene->command_buffers = threads;
+    tick_stats_count(scene->stats, TICK_ALLOCATIONS, 1);
+  }
+  scene->deferring = true;
+}
+
+/**
+ * Stops deferring mutations to a scene and applies the deferred commands,
+ * each thread's in the order they were issued, one thread after another.
+ */
+void scene_apply_commands(scene_t *scene) {
+  scene->deferring = false;
+  for (size_t t = 0; t < scene->command_buffers; t++) {
+    command_buffer_t *buffer = &scene->commands[t];
+    for (size_t c = 0; c < buffer->size; c++) {
+      command_t *command = &buffer->commands[c];
+      switch (command->kind) {
+        case COMMAND_ADD_BODY:
+          scene_add_body(scene, command->body);
+          break;
+        case COMMAND_REMOVE_BODY:
+          body_remove(command->body);
+          break;
+        case COMMAND_ADD_FORCE:
+          scene_add_force(scene, command->force);
+          break;
+        case COMMAND_ADD_TYPED_FORCE:
+          scene_add_typed_force(scene, command->force_kind, &command->record);
+          break;
+        case COMMAND_REMOVE_FORCE:
+          force_remove(command->force);
+          break;
+        case COMMAND_OUT_OF_BOUNDS:
+          if (scene->bounds_handler != NULL) {
+            scene->bounds_handler(scene, command->body, scene->bounds_aux);
+          }
+          break;
+      }
+    }
+    buffer->size = 0;
+    tick_stats_count(scene->stats, TICK_ALLOCATIONS, buffer->allocations);
+    buffer->allocations = 0;
+  }
+}
+
+/**
+ * Removes the bodies marked for removal and every force acting on them
+ * like scene_reap(), recording the removals in the tick's stats.
+ */
+void scene_reap_recorded(scene_t *scene) {
+  tick_stats_t *stats = scene->stats;
+  tick_stats_count(stats, TICK_BODIES_REMOVED, list_size(scene->graveyard));
+  tick_stats_count(stats, TICK_FORCES_REMOVED, \
+    scene_tombstone_graveyard(scene));
+  tick_stats_lap(stats, TICK_PHASE_REMOVAL_SCAN);
+  scene_compact(scene);
+  tick_stats_lap(stats, TICK_PHASE_COMPACTION);
+}
+
+/**
+ * Runs one tick of a scene, without publishing it to its render buffer.
+ */
+void scene_step(scene_t *scene, double dt) {
+  scene->dt = dt;
+  scene->ticking = true;
+  scene->index_stale = true;
+  tick_stats_t *stats = scene->stats;
+  tick_stats_begin(stats);
+  size_t total = 0;
+  for (size_t k = 0; k < NUM_FORCE_KINDS; k++) {
+    if (FORCE_KERNELS[k] != NULL) {
+      total += scene->groups[k].size;
+    }
+  }
+  force_group_t *collisions = &scene->groups[FORCE_COLLISION];
+  bool parallel = scene->pool != NULL && worker_pool_threads(scene->pool) > 1;
+  bool parallel_forces = parallel && total >= MIN_PARALLEL_FORCES;
+  // Number of collision records checked on the pool, ahead of their handlers
+  size_t checked = parallel && collisions->size >= MIN_PARALLEL_COLLISIONS ? \
+    collisions->size : 0;
+
+  // Collision checks only read the bodies' shapes, which forces don't change,
+  // so they run alongside the built-in forces. Their handlers are still
+  // called in order after the force creators, like in the serial loop.
+  pool_job_t *jobs[2];
+  size_t job_count = 0;
+  if (parallel_forces) {
+    jobs[job_count++] = worker_pool_submit(scene->pool, force_task, scene, \
+      total, NULL, 0);
+  }
+  if (checked > 0) {
+    scene_reserve_contacts(scene, checked);
+    jobs[job_count++] = worker_pool_submit(scene->pool, collision_task, \
+      scene, checked, NULL, 0);
+  }
+  for (size_t j = 0; j < job_count; j++) {
+    worker_pool_wait(scene->pool, jobs[j]);
+  }
+
+  if (parallel_forces) {
+    scene_apply_force_outputs(scene);
+  }
+  else {
+    for (size_t k = 0; k < NUM_FORCE_KINDS; k++) {
+      if (FORCE_BATCHES[k] != NULL) {
+        FORCE_BATCHES[k](scene->groups[k].forces, scene->groups[k].size);
+      }
+    }
+  }
+  tick_stats_count(stats, TICK_FORCES_EVALUATED, total);
+  tick_stats_lap(stats, TICK_PHASE_FORCES);
+
+  // Bodies and forces added or removed by force creators and collision
+  // handlers are only applied once they have all been called,
+  // so the arrays being looped over don't change
+  scene_begin_deferring(scene);
+  size_t force_count = list_size(scene->forces);
+  size_t evaluated = 0;
+  for (size_t n = 0; n < force_count; n++) {
+    force_t *f = list_get(scene->forces, n);
+    if (!f->solver) {
+      f->forcer(f->aux);
+      evaluated++;
+    }
+  }
+  tick_stats_count(stats, TICK_FORCES_EVALUATED, evaluated);
+  tick_stats_lap(stats, TICK_PHASE_CREATORS);
+
+  size_t collision_count = collisions->size;
+  size_t axes = 0;
+  size_t found = 0;
+  for (size_t c = 0; c < collision_count; c++) {
+    aux_t *record = &collisions->forces[c];
+    axes += list_size(record->body1->shape) + list_size(record->body2->shape);
+    if (c < checked) {
+      collision_respond(record, scene->contacts[c]);
+    }
+    else {
+      collision_creator(record);
+    }
+    // The record stays put, since forces added by handlers are deferred
+    found += record->collided;
+  }
+  tick_stats_count(stats, TICK_PAIR_TESTS, collision_count);
+  tick_stats_count(stats, TICK_SAT_AXES, axes);
+  tick_stats_count(stats, TICK_COLLISIONS, found);
+  tick_stats_lap(stats, TICK_PHASE_COLLISIONS);
+  scene_apply_commands(scene);
+  tick_stats_lap(stats, TICK_PHASE_COMMANDS);
+
+  scene_reap_recorded(scene);
+
+  // Solvers see every force of the tick, and only the bodies that remain
+  scene_begin_deferring(scene);
+  force_count = list_size(scene->forces);
+  for (size_t n = 0; n < force_count; n++) {
+    force_t *f = list_get(scene->forces, n);
+    if (f->solver) {
+      f->forcer(f->aux);
+      tick_stats_count(stats, TICK_FORCES_EVALUATED, 1);
+    }
+  }
+  tick_stats_lap(stats, TICK_PHASE_SOLVERS);
+  scene_apply_commands(scene);
+  tick_stats_lap(stats, TICK_PHASE_COMMANDS);
+
+  // Bodies leaving the world bounds are removed or passed to the handler
+  // once every body has moved
+  scene_begin_deferring(scene);
+  size_t body_count = scene_bodies(scene);
+  if (parallel && body_count >= MIN_PARALLEL_BODIES) {
+    worker_pool_run(scene->pool, body_tick_task, scene, body_count);
+  }
+  else {
+    body_tick_task(scene, 0, body_count);
+  }
+  tick_stats_lap(stats, TICK_PHASE_INTEGRATION);
+  scene_apply_commands(scene);
+  tick_stats_lap(stats, TICK_PHASE_COMMANDS);
+  // Bodies removed since the bodies were last reaped, e.g. by solvers or
+  // for leaving the world bounds, don't last into the next tick
+  if (list_size(scene->graveyard) > 0) {
+    scene_reap_recorded(scene);
+  }
+  scene->ticking = false;
+  tick_stats_end(stats);
 }
 
 void scene_tick(scene_t *scene, double dt) {
+  scene_step(scene, dt);
+  if (scene->render_buffer != NULL) {
+    render_buffer_publish(scene->render_buffer, scene, 1);
+  }
+}
+
+size_t scene_step_fixed(scene_t *scene, double frame_dt, double fixed_dt, \
+  size_t max_substeps) {
+  assert(fixed_dt > 0);
+  scene->accumulator += frame_dt;
+  size_t steps = 0;
+  while (scene->accumulator >= fixed_dt && steps < max_substeps) {
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+      body_save_pose(scene_get_body(scene, i));
+    }
+    scene_step(scene, fixed_dt);
+    scene->accumulator -= fixed_dt;
+    steps++;
+  }
+  // Drop whatever the substep budget couldn't catch up on, so one slow frame
+  // doesn't leave every following frame running the maximum number of steps
+  if (scene->accumulator >= fixed_dt) {
+    scene->accumulator = fmod(scene->accumulator, fixed_dt);
+  }
+  scene->alpha = scene->accumulator / fixed_dt;
+  if (scene->render_buffer != NULL) {
+    render_buffer_publish(scene->render_buffer, scene, scene->alpha);
+  }
+  return steps;
+}
+
+double scene_get_alpha(scene_t *scene) {
+  return scene->alpha;
+}
+
+typedef struct scene_snapshot {
+  scene_t *scene;
+  size_t structure;
+  char *data;
+  size_t size;
+  size_t capacity;
+} scene_snapshot_t;
+
+/**
+ * The dynamic state of a body, as stored in a snapshot.
+ * Each body's state is followed in the snapshot by its vertices.
+ */
+typedef struct body_state {
+  vector_t centroid;
+  vector_t velocity;
+  double orientation;
+  vector_t prev_centroid;
+  double prev_orientation;
+  vector_t force;
+  vector_t impulse;
+  double mass;
+  aabb_t bounds;
+  int removed;
+  size_t vertices;
+} body_state_t;
+
+/**
+ * The dynamic state of a scene itself, at the start of a snapshot.
+ */
+typedef struct scene_state {
+  double dt;
+  double accumulator;
+  double alpha;
+  size_t creator_tombstones;
+  size_t graveyard;
+} scene_state_t;
+
+scene_snapshot_t *scene_snapshot_init(void) {
+  scene_snapshot_t *snapshot = malloc(sizeof(scene_snapshot_t));
+  assert(snapshot != NULL);
+  snapshot->scene = NULL;
+  snapshot->structure = 0;
+  snapshot->data = NULL;
+  snapshot->size = 0;
+  snapshot->capacity = 0;
+  return snapshot;
+}
+
+void scene_snapshot_free(scene_snapshot_t *snapshot) {
+  free(snapshot->data);
+  free(snapshot);
+}
+
+size_t scene_snapshot_size(scene_snapshot_t *snapshot) {
+  return snapshot->size;
+}
+
+/**
+ * Gets the state that a physics collision keeps in its handler's aux,
+ * or NULL if a collision record has a different handler.
+ */
+bool *collision_handler_state(aux_t *record) {
+  if (record->handler != (collision_handler_t) collision_handler_2) {
+    return NULL;
+  }
+  return &((aux_t *) record->aux)->collided;
+}
 
-  for (size_t n = 0; n < list_size(scene->forces); n++) {
+/**
+ * Copies a value into a snapshot's buffer, or out of it when restoring,
+ * and advances the cursor past it.
+ */
+void snapshot_copy(scene_snapshot_t *snapshot, size_t *cursor, void *value, \
+  size_t size, bool restoring) {
+  if (restoring) {
+    memcpy(value, snapshot->data + *cursor, size);
+  }
+  else {
+    memcpy(snapshot->data + *cursor, value, size);
+  }
+  *cursor += size;
+}
+
+/**
+ * Checks whether a shape's vertices differ from those stored in a snapshot.
+ */
+bool shape_differs(list_t *shape, char *vertices) {
+  size_t n = list_size(shape);
+  for (size_t v = 0; v < n; v++) {
+    if (memcmp(list_get(shape, v), vertices + v * sizeof(vector_t), \
+      sizeof(vector_t)) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Copies all of a scene's dynamic state into a snapshot's buffer,
+ * or out of it when restoring. Both directions visit the state
+ * in the same order, so the buffer needs no other layout information.
+ */
+void snapshot_copy_scene(scene_snapshot_t *snapshot, scene_t *scene, \
+  bool restoring) {
+  size_t cursor = 0;
+  scene_state_t state = {
+    scene->dt, scene->accumulator, scene->alpha,
+    scene->creator_tombstones, list_size(scene->graveyard)
+  };
+  snapshot_copy(snapshot, &cursor, &state, sizeof(state), restoring);
+  if (restoring) {
+    scene->dt = state.dt;
+    scene->accumulator = state.accumulator;
+    scene->alpha = state.alpha;
+    scene->creator_tombstones = state.creator_tombstones;
+    // Bodies removed since the snapshot are no longer removed
+    list_truncate(scene->graveyard, state.graveyard);
+  }
+
+  size_t body_count = scene_bodies(scene);
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    list_t *shape = body->shape;
+    body_state_t body_state = {
+      body->centroid, body->velocity, body->orientation,
+      body->prev_centroid, body->prev_orientation,
+      body->force, body->impulse, body->mass, body->bounds, body->forRemoval,
+      list_size(shape)
+    };
+    snapshot_copy(snapshot, &cursor, &body_state, sizeof(body_state), \
+      restoring);
+    if (restoring) {
+      body->centroid = body_state.centroid;
+      body->velocity = body_state.velocity;
+      body->orientation = body_state.orientation;
+      body->prev_centroid = body_state.prev_centroid;
+      body->prev_orientation = body_state.prev_orientation;
+      body->force = body_state.force;
+      body->impulse = body_state.impulse;
+      body->mass = body_state.mass;
+      body->bounds = body_state.bounds;
+      body->forRemoval = body_state.removed;
+    }
+    // A shape shared with a fork is only copied if its vertices differ
+    size_t size = body_state.vertices * sizeof(vector_t);
+    if (restoring && body->shape_owners != NULL && \
+      !shape_differs(shape, snapshot->data + cursor)) {
+      cursor += size;
+      continue;
+    }
+    if (restoring) {
+      body_unshare_shape(body);
+      shape = body->shape;
+    }
+    // The vertices are copied in place, so the shape keeps its identity
+    for (size_t v = 0; v < body_state.vertices; v++) {
+      snapshot_copy(snapshot, &cursor, list_get(shape, v), sizeof(vector_t), \
+        restoring);
+    }
+  }
+
+  force_group_t *collisions = &scene->groups[FORCE_COLLISION];
+  for (size_t c = 0; c < collisions->size; c++) {
+    aux_t *record = &collisions->forces[c];
+    snapshot_copy(snapshot, &cursor, &record->collided, sizeof(bool), \
+      restoring);
+    bool *handler_state = collision_handler_state(record);
+    if (handler_state != NULL) {
+      snapshot_copy(snapshot, &cursor, handler_state, sizeof(bool), restoring);
+    }
+  }
+
+  size_t force_count = list_size(scene->forces);
+  for (size_t n = 0; n < force_count; n++) {
     force_t *f = list_get(scene->forces, n);
-    f->forcer(f->aux);
+    snapshot_copy(snapshot, &cursor, &f->forRemoval, sizeof(int), restoring);
   }
+  assert(cursor == snapshot->size);
+}
 
-  for (size_t k = 0; k < list_size(scene->forces); k++){
-    force_t *f = scene_get_force(scene, k);
-    for (size_t l = 0; l < list_size(f->bodies); l++){
-      if (body_is_removed(list_get(f->bodies, l))){
-         force_remove(f);
-      }
+void scene_snapshot(scene_t *scene, scene_snapshot_t *snapshot) {
+  size_t size = sizeof(scene_state_t);
+  size_t body_count = scene_bodies(scene);
+  for (size_t i = 0; i < body_count; i++) {
+    size += sizeof(body_state_t) + \
+      list_size(scene_get_body(scene, i)->shape) * sizeof(vector_t);
+  }
+  force_group_t *collisions = &scene->groups[FORCE_COLLISION];
+  for (size_t c = 0; c < collisions->size; c++) {
+    size += sizeof(bool);
+    if (collision_handler_state(&collisions->forces[c]) != NULL) {
+      size += sizeof(bool);
+    }
+  }
+  size += list_size(scene->forces) * sizeof(int);
+
+  if (size > snapshot->capacity) {
+    snapshot->capacity = size;
+    snapshot->data = realloc(snapshot->data, size);
+    assert(snapshot->data != NULL);
+  }
+  snapshot->scene = scene;
+  snapshot->structure = scene->structure;
+  snapshot->size = size;
+  snapshot_copy_scene(snapshot, scene, false);
+}
+
+bool scene_restore(scene_t *scene, scene_snapshot_t *snapshot) {
+  if (snapshot->scene != scene || snapshot->structure != scene->structure) {
+    return false;
+  }
+  // Shapes can be replaced without adding or removing bodies,
+  // so check that each shape still has room for its vertices first
+  size_t cursor = sizeof(scene_state_t);
+  size_t body_count = scene_bodies(scene);
+  for (size_t i = 0; i < body_count; i++) {
+    body_state_t body_state;
+    memcpy(&body_state, snapshot->data + cursor, sizeof(body_state));
+    if (body_state.vertices != list_size(scene_get_body(scene, i)->shape)) {
+      return false;
+    }
+    cursor += sizeof(body_state) + body_state.vertices * sizeof(vector_t);
+  }
+  snapshot_copy_scene(snapshot, scene, true);
+  scene->index_stale = true;
+  return true;
+}
+
+/**
+ * A body of a scene paired with its copy in a fork of the scene.
+ */
+typedef struct body_pair {
+  body_t *body;
+  body_t *copy;
+} body_pair_t;
+
+int body_pair_compare(const void *a, const void *b) {
+  uintptr_t body1 = (uintptr_t) ((const body_pair_t *) a)->body;
+  uintptr_t body2 = (uintptr_t) ((const body_pair_t *) b)->body;
+  return (body1 > body2) - (body1 < body2);
+}
+
+/**
+ * Finds a fork's copy of a body, in pairs sorted by body_pair_compare().
+ * Asserts that the body is in the original scene.
+ */
+body_t *fork_body(body_pair_t *pairs, size_t count, body_t *body) {
+  if (body == NULL) {
+    return NULL;
+  }
+  body_pair_t key = {body, NULL};
+  body_pair_t *pair = bsearch(&key, pairs, count, sizeof(body_pair_t), \
+    body_pair_compare);
+  assert(pair != NULL);
+  return pair->copy;
+}
+
+/**
+ * Checks whether a collision record keeps its own state in its handler's aux,
+ * a record like itself that a fork must copy.
+ */
+bool collision_handler_owns_record(aux_t *record) {
+  return record->aux != NULL && record->freer == free && \
+    (record->handler == (collision_handler_t) collision_handler_1 || \
+    record->handler == (collision_handler_t) collision_handler_2);
+}
+
+/**
+ * Checks whether every force in a scene can be copied by scene_fork().
+ */
+bool scene_forkable(scene_t *scene) {
+  size_t force_count = list_size(scene->forces);
+  for (size_t n = 0; n < force_count; n++) {
+    force_t *f = list_get(scene->forces, n);
+    if (f->aux != NULL && f->copier == NULL) {
+      return false;
     }
   }
+  force_group_t *collisions = &scene->groups[FORCE_COLLISION];
+  for (size_t c = 0; c < collisions->size; c++) {
+    aux_t *record = &collisions->forces[c];
+    if (record->freer != NULL && !collision_handler_owns_record(record)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  for (size_t j = 0; j < list_size(scene->forces); j++) {
-    force_t *f = scene_get_force(scene, j);
-    if (force_is_removed(f)){
-      scene_remove_force(scene, j);
-      j--;
+/**
+ * Copies a scene's built-in forces of one kind into a fork,
+ * pointing them at the fork's bodies.
+ */
+void fork_force_group(force_group_t *group, force_group_t *copy, \
+  body_pair_t *pairs, size_t count) {
+  size_t n = group->size;
+  if (n == 0) {
+    return;
+  }
+  copy->size = n;
+  copy->capacity = n;
+  copy->tombstones = group->tombstones;
+  copy->forces = malloc(n * sizeof(aux_t));
+  copy->removed = malloc(n * sizeof(bool));
+  copy->slots1 = malloc(n * sizeof(size_t));
+  copy->slots2 = malloc(n * sizeof(size_t));
+  copy->outputs = malloc(n * sizeof(vector_t));
+  assert(copy->forces != NULL && copy->removed != NULL &&
+    copy->slots1 != NULL && copy->slots2 != NULL && copy->outputs != NULL);
+  memcpy(copy->forces, group->forces, n * sizeof(aux_t));
+  memcpy(copy->removed, group->removed, n * sizeof(bool));
+  memcpy(copy->slots1, group->slots1, n * sizeof(size_t));
+  memcpy(copy->slots2, group->slots2, n * sizeof(size_t));
+  for (size_t i = 0; i < n; i++) {
+    aux_t *record = &copy->forces[i];
+    record->body1 = fork_body(pairs, count, record->body1);
+    record->body2 = fork_body(pairs, count, record->body2);
+    if (collision_handler_owns_record(record)) {
+      aux_t *state = malloc(sizeof(aux_t));
+      assert(state != NULL);
+      *state = *(aux_t *) record->aux;
+      state->body1 = record->body1;
+      state->body2 = record->body2;
+      record->aux = state;
     }
   }
+}
 
-  for (size_t m = 0; m <scene_bodies(scene); m ++){
-    body_t *bod = scene_get_body((scene_t*) scene, m);
-    if (body_is_removed(bod)){
-      list_remove(scene->bodies, m);
-      m--;
+scene_t *scene_fork(scene_t *scene) {
+  if (!scene_forkable(scene)) {
+    return NULL;
+  }
+  scene_t *fork = scene_init();
+  fork->creator_tombstones = scene->creator_tombstones;
+  fork->drag = scene->drag;
+  fork->dt = scene->dt;
+  fork->accumulator = scene->accumulator;
+  fork->alpha = scene->alpha;
+  fork->has_bounds = scene->has_bounds;
+  fork->bounds = scene->bounds;
+  fork->bounds_handler = scene->bounds_handler;
+  fork->bounds_aux = scene->bounds_aux;
+
+  // Bodies keep their reverse indices of forces,
+  // since the forces are copied in the same order
+  size_t body_count = scene_bodies(scene);
+  body_pair_t *pairs = malloc(body_count * sizeof(body_pair_t));
+  assert(body_count == 0 || pairs != NULL);
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    body_t *copy = body_fork(body);
+    copy->graveyard = fork->graveyard;
+    list_add(fork->bodies, copy);
+    pairs[i] = (body_pair_t) {body, copy};
+  }
+  qsort(pairs, body_count, sizeof(body_pair_t), body_pair_compare);
+  // Handles to the scene's bodies refer to the same bodies in the fork
+  fork->slot_count = scene->slot_count;
+  fork->slot_capacity = scene->slot_count;
+  fork->free_count = scene->free_count;
+  if (scene->slot_count > 0) {
+    size_t n = scene->slot_count;
+    fork->slots = malloc(n * sizeof(body_t *));
+    fork->generations = malloc(n * sizeof(size_t));
+    fork->free_slots = malloc(n * sizeof(size_t));
+    assert(fork->slots != NULL && fork->generations != NULL &&
+      fork->free_slots != NULL);
+    for (size_t i = 0; i < n; i++) {
+      fork->slots[i] = fork_body(pairs, body_count, scene->slots[i]);
+    }
+    memcpy(fork->generations, scene->generations, n * sizeof(size_t));
+    memcpy(fork->free_slots, scene->free_slots, \
+      scene->free_count * sizeof(size_t));
+  }
+  size_t dead = list_size(scene->graveyard);
+  for (size_t d = 0; d < dead; d++) {
+    list_add(fork->graveyard, \
+      fork_body(pairs, body_count, list_get(scene->graveyard, d)));
+  }
+
+  for (size_t k = 0; k < NUM_FORCE_KINDS; k++) {
+    fork_force_group(&scene->groups[k], &fork->groups[k], pairs, body_count);
+  }
+  size_t force_count = list_size(scene->forces);
+  for (size_t n = 0; n < force_count; n++) {
+    force_t *f = list_get(scene->forces, n);
+    size_t m = list_size(f->bodies);
+    list_t *bodies = list_init(m, NULL);
+    for (size_t i = 0; i < m; i++) {
+      list_add(bodies, fork_body(pairs, body_count, list_get(f->bodies, i)));
     }
+    void *aux = f->copier != NULL ? f->copier(f->aux, fork, bodies) : NULL;
+    force_t *copy = force_init2(aux, f->forcer, f->freer, bodies);
+    copy->forRemoval = f->forRemoval;
+    copy->ref_slots = malloc(m * sizeof(size_t));
+    assert(m == 0 || copy->ref_slots != NULL);
+    memcpy(copy->ref_slots, f->ref_slots, m * sizeof(size_t));
+    copy->tombstones = &fork->creator_tombstones;
+    copy->solver = f->solver;
+    copy->copier = f->copier;
+    list_add(fork->forces, copy);
   }
+  free(pairs);
+  fork->parent = scene;
+  atomic_fetch_add(&scene->forks, 1);
+  return fork;
+}
 
-  for (size_t i = 0; i < scene_bodies(scene); i++){
-    body_tick(scene_get_body((scene_t*) scene, i), dt);
+/**
+ * Gets a scene's spatial index, rebuilding it if the bodies have changed.
+ */
+spatial_index_t *scene_index(scene_t *scene) {
+  if (scene->index == NULL) {
+    scene->index = spatial_index_init();
   }
+  else if (!scene->index_stale && scene->index_structure == scene->structure) {
+    return scene->index;
+  }
+  spatial_index_build(scene->index, scene->bodies);
+  scene->index_stale = false;
+  scene->index_structure = scene->structure;
+  return scene->index;
+}
+
+size_t scene_query_aabb(scene_t *scene, aabb_t box, body_t **results, \
+  size_t capacity) {
+  return spatial_index_query(scene_index(scene), box, NULL, NULL, results, \
+    capacity);
+}
+
+bool body_contains_point(body_t *body, vector_t *point) {
+  return polygon_contains(body->shape, *point);
+}
+
+size_t scene_query_point(scene_t *scene, vector_t point, body_t **results, \
+  size_t capacity) {
+  aabb_t box = {point, point};
+  return spatial_index_query(scene_index(scene), box, \
+    (body_filter_t) body_contains_point, &point, results, capacity);
+}
+
+/**
+ * A circle to find the bodies within, for scene_query_radius().
+ */
+typedef struct query_circle {
+  vector_t center;
+  double radius;
+} query_circle_t;
+
+bool body_within_circle(body_t *body, query_circle_t *circle) {
+  return polygon_distance(body->shape, circle->center) <= circle->radius;
+}
+
+size_t scene_query_radius(scene_t *scene, vector_t center, double radius, \
+  body_t **results, size_t capacity) {
+  vector_t corner = {radius, radius};
+  aabb_t box = {vec_subtract(center, corner), vec_add(center, corner)};
+  query_circle_t circle = {center, radius};
+  return spatial_index_query(scene_index(scene), box, \
+    (body_filter_t) body_within_circle, &circle, results, capacity);
+}
+
+/**
+ * The ray being cast by raycast_task(), and its nearest hit so far.
+ */
+typedef struct ray_query {
+  vector_t origin;
+  vector_t direction;
+  double distance;
+  vector_t normal;
+} ray_query_t;
+
+double ray_test(body_t *body, ray_query_t *query) {
+  vector_t normal;
+  double distance = polygon_raycast(body->shape, query->origin, \
+    query->direction, &normal);
+  if (distance < query->distance) {
+    query->distance = distance;
+    query->normal = normal;
+  }
+  return distance;
+}
+
+/**
+ * A batch of rays being cast by scene_raycast_batch().
+ */
+typedef struct ray_batch {
+  spatial_index_t *index;
+  const ray_t *rays;
+  ray_hit_t *hits;
+} ray_batch_t;
+
+void raycast_task(ray_batch_t *batch, size_t start, size_t end) {
+  for (size_t i = start; i < end; i++) {
+    const ray_t *ray = &batch->rays[i];
+    ray_hit_t *hit = &batch->hits[i];
+    *hit = (ray_hit_t) {NULL, VEC_ZERO, VEC_ZERO, INFINITY};
+    double length = sqrt(vec_dot(ray->direction, ray->direction));
+    if (length == 0) {
+      continue;
+    }
+    vector_t direction = vec_multiply(1 / length, ray->direction);
+    ray_query_t query = {ray->origin, direction, ray->max_distance, VEC_ZERO};
+    double distance;
+    body_t *body = spatial_index_raycast(batch->index, ray->origin, \
+      direction, ray->max_distance, (ray_test_t) ray_test, &query, &distance);
+    if (body != NULL) {
+      vector_t point = vec_add(ray->origin, vec_multiply(distance, direction));
+      *hit = (ray_hit_t) {body, point, query.normal, distance};
+    }
+  }
+}
+
+size_t scene_raycast_batch(scene_t *scene, const ray_t *rays, size_t n, \
+  ray_hit_t *hits) {
+  ray_batch_t batch = {scene_index(scene), rays, hits};
+  if (scene->pool != NULL && worker_pool_threads(scene->pool) > 1 && \
+    n >= MIN_PARALLEL_RAYS) {
+    worker_pool_run(scene->pool, (pool_task_t) raycast_task, &batch, n);
+  }
+  else {
+    raycast_task(&batch, 0, n);
+  }
+  size_t hit_count = 0;
+  for (size_t i = 0; i < n; i++) {
+    hit_count += hits[i].body != NULL;
+  }
+  return hit_count;
+}
+
+/**
+ * The shape being cast by scene_shape_cast(), and its first hit so far.
+ */
+typedef struct shape_query {
+  list_t *shape;
+  vector_t displacement;
+  body_t *body;
+  sweep_info_t sweep;
+} shape_query_t;
+
+bool shape_test(body_t *body, shape_query_t *query) {
+  sweep_info_t sweep = find_sweep(query->shape, query->displacement, \
+    body->shape);
+  if (sweep.hit && (query->body == NULL || \
+    sweep.fraction < query->sweep.fraction)) {
+    query->body = body;
+    query->sweep = sweep;
+  }
+  // Nothing needs to be stored, since the query keeps the first hit
+  return false;
+}
+
+bool scene_shape_cast(scene_t *scene, list_t *shape, vector_t direction, \
+  double max_distance, ray_hit_t *hit) {
+  *hit = (ray_hit_t) {NULL, VEC_ZERO, VEC_ZERO, INFINITY};
+  double length = sqrt(vec_dot(direction, direction));
+  if (length == 0) {
+    return false;
+  }
+  vector_t displacement = vec_multiply(max_distance / length, direction);
+  // Only bodies in the box swept out by the shape's bounding box can be hit
+  aabb_t bounds = polygon_bounds(shape);
+  aabb_t box = {
+    {
+      bounds.min.x + fmin(displacement.x, 0),
+      bounds.min.y + fmin(displacement.y, 0)
+    },
+    {
+      bounds.max.x + fmax(displacement.x, 0),
+      bounds.max.y + fmax(displacement.y, 0)
+    }
+  };
+  shape_query_t query = {shape, displacement, NULL, {false, 0, VEC_ZERO}};
+  spatial_index_query(scene_index(scene), box, (body_filter_t) shape_test, \
+    &query, NULL, 0);
+  if (query.body == NULL) {
+    return false;
+  }
+  double distance = query.sweep.fraction * max_distance;
+  vector_t moved = vec_multiply(query.sweep.fraction, displacement);
+  *hit = (ray_hit_t) {
+    query.body, vec_add(polygon_centroid(shape), moved),
+    query.sweep.normal, distance
+  };
+  return true;
+}
+
+void scene_enable_stats(scene_t *scene) {
+  if (scene->stats == NULL) {
+    scene->stats = tick_stats_init();
+  }
+}
+
+void scene_get_stats(scene_t *scene, scene_stats_t *stats) {
+  tick_stats_summarize(scene->stats, stats);
 }
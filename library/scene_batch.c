@@ -0,0 +1,148 @@
+#include "scene_batch.h"
+#include "polygon.h"
+#include "worker_pool.h"
+#include <assert.h>
+#include <stdlib.h>
+
+typedef struct scene_batch {
+  worker_pool_t *pool;
+  // Each template's vertices, relative to its centroid
+  list_t *templates;
+  scene_t **scenes;
+  // Number of ticks each scene has run
+  size_t *steps;
+  size_t size;
+  size_t capacity;
+} scene_batch_t;
+
+/**
+ * The parameters of a job over a batch's scenes.
+ */
+typedef struct batch_job {
+  scene_batch_t *batch;
+  void *aux;
+  // The first index the job builds scenes at
+  size_t first;
+  scene_builder_t build;
+  double dt;
+  size_t max_steps;
+  scene_done_t done;
+  scene_measure_t measure;
+  double *results;
+} batch_job_t;
+
+scene_batch_t *scene_batch_init(size_t threads) {
+  scene_batch_t *batch = malloc(sizeof(scene_batch_t));
+  assert(batch != NULL);
+  batch->pool = worker_pool_init(threads);
+  batch->templates = list_init(1, (free_func_t) list_free);
+  batch->scenes = NULL;
+  batch->steps = NULL;
+  batch->size = 0;
+  batch->capacity = 0;
+  return batch;
+}
+
+void scene_batch_free(scene_batch_t *batch) {
+  for (size_t i = 0; i < batch->size; i++) {
+    scene_free(batch->scenes[i]);
+  }
+  free(batch->scenes);
+  free(batch->steps);
+  list_free(batch->templates);
+  worker_pool_free(batch->pool);
+  free(batch);
+}
+
+size_t scene_batch_add_template(scene_batch_t *batch, list_t *shape) {
+  polygon_translate(shape, vec_negate(polygon_centroid(shape)));
+  list_add(batch->templates, shape);
+  return list_size(batch->templates) - 1;
+}
+
+list_t *scene_batch_instance(scene_batch_t *batch, size_t template, \
+  vector_t centroid) {
+  list_t *shape = list_get(batch->templates, template);
+  size_t n = list_size(shape);
+  list_t *copy = list_init(n, free);
+  for (size_t i = 0; i < n; i++) {
+    vector_t *vertex = malloc(sizeof(vector_t));
+    assert(vertex != NULL);
+    *vertex = vec_add(*(vector_t *) list_get(shape, i), centroid);
+    list_add(copy, vertex);
+  }
+  return copy;
+}
+
+void build_task(void *aux, size_t start, size_t end) {
+  batch_job_t *job = aux;
+  for (size_t i = start; i < end; i++) {
+    size_t index = job->first + i;
+    job->batch->scenes[index] = job->build(job->batch, index, job->aux);
+    job->batch->steps[index] = 0;
+  }
+}
+
+void scene_batch_build(scene_batch_t *batch, size_t count, \
+  scene_builder_t build, void *aux) {
+  if (batch->size + count > batch->capacity) {
+    batch->capacity = batch->size + count;
+    batch->scenes = realloc(batch->scenes, \
+      batch->capacity * sizeof(scene_t *));
+    batch->steps = realloc(batch->steps, batch->capacity * sizeof(size_t));
+    assert(batch->scenes != NULL && batch->steps != NULL);
+  }
+  batch_job_t job = {.batch = batch, .aux = aux, .first = batch->size, \
+    .build = build};
+  worker_pool_run(batch->pool, build_task, &job, count);
+  batch->size += count;
+}
+
+size_t scene_batch_size(scene_batch_t *batch) {
+  return batch->size;
+}
+
+scene_t *scene_batch_get(scene_batch_t *batch, size_t index) {
+  assert(index < batch->size);
+  return batch->scenes[index];
+}
+
+size_t scene_batch_steps(scene_batch_t *batch, size_t index) {
+  assert(index < batch->size);
+  return batch->steps[index];
+}
+
+void run_task(void *aux, size_t start, size_t end) {
+  batch_job_t *job = aux;
+  for (size_t i = start; i < end; i++) {
+    scene_t *scene = job->batch->scenes[i];
+    for (size_t step = 0; step < job->max_steps; step++) {
+      if (job->done != NULL && job->done(scene, i, job->aux)) {
+        break;
+      }
+      scene_tick(scene, job->dt);
+      job->batch->steps[i]++;
+    }
+  }
+}
+
+void scene_batch_run(scene_batch_t *batch, double dt, size_t max_steps, \
+  scene_done_t done, void *aux) {
+  batch_job_t job = {.batch = batch, .aux = aux, .dt = dt, \
+    .max_steps = max_steps, .done = done};
+  worker_pool_run(batch->pool, run_task, &job, batch->size);
+}
+
+void measure_task(void *aux, size_t start, size_t end) {
+  batch_job_t *job = aux;
+  for (size_t i = start; i < end; i++) {
+    job->results[i] = job->measure(job->batch->scenes[i], i, job->aux);
+  }
+}
+
+void scene_batch_measure(scene_batch_t *batch, scene_measure_t measure, \
+  void *aux, double *results) {
+  batch_job_t job = {.batch = batch, .aux = aux, .measure = measure, \
+    .results = results};
+  worker_pool_run(batch->pool, measure_task, &job, batch->size);
+}
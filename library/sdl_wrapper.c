@@ -4,7 +4,9 @@
 #include <time.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
+#include "polygon.h"
 #include "sdl_wrapper.h"
+#include "trace.h"
 
 const char WINDOW_TITLE[] = "CS 3";
 const int WINDOW_WIDTH = 1000;
@@ -49,6 +51,12 @@ void *body = NULL;
  * Scene to be passed to key_handler, or NULL if none has been configured.
  */
 void *scene = NULL;
+/**
+ * Pixel coordinates of the polygon sdl_render_frame() is drawing,
+ * kept between frames and grown to fit the body with the most vertices.
+ */
+int16_t *frame_x_points = NULL, *frame_y_points = NULL;
+size_t frame_point_capacity = 0;
 
 /** Computes the center of the window in pixel coordinates */
 vector_t get_window_center(void) {
@@ -215,6 +223,7 @@ void sdl_show(void) {
 }
 
 void sdl_render_scene(scene_t *scene) {
+    TRACE_BEGIN("render");
     sdl_clear();
     size_t body_count = scene_bodies(scene);
     for (size_t i = 0; i < body_count; i++) {
@@ -224,6 +233,71 @@ void sdl_render_scene(scene_t *scene) {
         list_free(shape);
     }
     sdl_show();
+    TRACE_END("render");
+}
+
+void sdl_render_scene_interpolated(scene_t *scene, double alpha) {
+    TRACE_BEGIN("render");
+    sdl_clear();
+    size_t body_count = scene_bodies(scene);
+    for (size_t i = 0; i < body_count; i++) {
+        body_t *body = scene_get_body(scene, i);
+        list_t *shape = body_get_interpolated_shape(body, alpha);
+        sdl_draw_polygon(shape, body_get_color(body));
+        list_free(shape);
+    }
+    sdl_show();
+    TRACE_END("render");
+}
+
+void sdl_render_frame(const render_frame_t *frame) {
+    TRACE_BEGIN("render");
+    sdl_clear();
+    vector_t window_center = get_window_center();
+    for (size_t i = 0; i < frame->body_count; i++) {
+        const render_body_t *body = &frame->bodies[i];
+        size_t n = body->vertex_count;
+        assert(n >= 3);
+        if (n > frame_point_capacity) {
+            frame_point_capacity = n;
+            frame_x_points = realloc(frame_x_points, \
+                sizeof(*frame_x_points) * n);
+            frame_y_points = realloc(frame_y_points, \
+                sizeof(*frame_y_points) * n);
+            assert(frame_x_points != NULL);
+            assert(frame_y_points != NULL);
+        }
+
+        // Interpolate the pose, then turn each published vertex
+        // about the published centroid and move it to the interpolated one
+        double alpha = frame->alpha;
+        double angle = body->prev_orientation + \
+            alpha * (body->orientation - body->prev_orientation);
+        vector_t centroid = vec_add(body->prev_centroid, vec_multiply(alpha, \
+            vec_subtract(body->centroid, body->prev_centroid)));
+        double cos_turn = cos(angle - body->orientation),
+               sin_turn = sin(angle - body->orientation);
+        for (size_t v = 0; v < n; v++) {
+            vector_t offset = vec_subtract(
+                frame->vertices[body->first_vertex + v], body->centroid);
+            vector_t vertex = {
+                centroid.x + offset.x * cos_turn - offset.y * sin_turn,
+                centroid.y + offset.x * sin_turn + offset.y * cos_turn
+            };
+            vector_t pixel = get_window_position(vertex, window_center);
+            frame_x_points[v] = pixel.x;
+            frame_y_points[v] = pixel.y;
+        }
+
+        rgb_color_t color = body->color;
+        filledPolygonRGBA(
+            renderer,
+            frame_x_points, frame_y_points, n,
+            color.r * 255, color.g * 255, color.b * 255, 255
+        );
+    }
+    sdl_show();
+    TRACE_END("render");
 }
 
 void sdl_on_key(key_handler_t handler, void *b, void *s) {
@@ -0,0 +1,370 @@
+#include "spatial_index.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Most cells per indexed body; sparse sets get wider cells instead
+const size_t MAX_CELLS_PER_BODY = 4;
+
+/**
+ * An indexed body, with its bounding box and the range of cells it covers.
+ */
+typedef struct index_entry {
+  body_t *body;
+  aabb_t bounds;
+  size_t first_col;
+  size_t first_row;
+  size_t last_col;
+  size_t last_row;
+} index_entry_t;
+
+typedef struct spatial_index {
+  index_entry_t *entries;
+  size_t count;
+  size_t capacity;
+  // Size of each body, to pick the cell size from
+  double *extents;
+  // The grid's lower left corner, cell size, and number of cells
+  vector_t origin;
+  double cell_size;
+  size_t cols;
+  size_t rows;
+  // The entries in cell c are cell_entries[cell_start[c]]
+  // to cell_entries[cell_start[c + 1] - 1]
+  size_t *cell_start;
+  size_t cell_capacity;
+  size_t *cell_entries;
+  size_t cell_entry_capacity;
+} spatial_index_t;
+
+spatial_index_t *spatial_index_init(void) {
+  spatial_index_t *index = malloc(sizeof(spatial_index_t));
+  assert(index != NULL);
+  index->entries = NULL;
+  index->count = 0;
+  index->capacity = 0;
+  index->extents = NULL;
+  index->origin = VEC_ZERO;
+  index->cell_size = 1;
+  index->cols = 0;
+  index->rows = 0;
+  index->cell_start = NULL;
+  index->cell_capacity = 0;
+  index->cell_entries = NULL;
+  index->cell_entry_capacity = 0;
+  return index;
+}
+
+void spatial_index_free(spatial_index_t *index) {
+  free(index->entries);
+  free(index->extents);
+  free(index->cell_start);
+  free(index->cell_entries);
+  free(index);
+}
+
+int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Finds the cell along one axis that contains a coordinate,
+ * clamped to the grid.
+ */
+size_t grid_coord(double x, double origin, double cell_size, size_t cells) {
+  double c = floor((x - origin) / cell_size);
+  if (!(c > 0)) {
+    return 0;
+  }
+  if (c >= (double) (cells - 1)) {
+    return cells - 1;
+  }
+  return (size_t) c;
+}
+
+/**
+ * Collects the bodies to index with their bounding boxes,
+ * and returns the box around all of them.
+ */
+aabb_t index_collect(spatial_index_t *index, list_t *bodies) {
+  size_t n = list_size(bodies);
+  if (n > index->capacity) {
+    index->capacity = n;
+    index->entries = realloc(index->entries, n * sizeof(index_entry_t));
+    index->extents = realloc(index->extents, n * sizeof(double));
+    assert(index->entries != NULL && index->extents != NULL);
+  }
+  index->count = 0;
+  aabb_t world = {{INFINITY, INFINITY}, {-INFINITY, -INFINITY}};
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = list_get(bodies, i);
+    if (body_is_removed(body)) {
+      continue;
+    }
+    aabb_t bounds = body_get_bounds(body);
+    index->extents[index->count] = fmax(bounds.max.x - bounds.min.x, \
+      bounds.max.y - bounds.min.y);
+    index->entries[index->count++] = (index_entry_t) {body, bounds, 0, 0, 0, 0};
+    world.min.x = fmin(world.min.x, bounds.min.x);
+    world.min.y = fmin(world.min.y, bounds.min.y);
+    world.max.x = fmax(world.max.x, bounds.max.x);
+    world.max.y = fmax(world.max.y, bounds.max.y);
+  }
+  return world;
+}
+
+/**
+ * Picks the size of the grid's cells: about the size of a typical body,
+ * so most bodies cover a few cells, but wide enough that there are
+ * at most MAX_CELLS_PER_BODY cells per body.
+ */
+void index_size_grid(spatial_index_t *index, aabb_t world) {
+  size_t n = index->count;
+  // The median isn't thrown off by a few huge bodies, like walls
+  qsort(index->extents, n, sizeof(double), compare_doubles);
+  double cell_size = index->extents[n / 2];
+  double width = world.max.x - world.min.x;
+  double height = world.max.y - world.min.y;
+  double max_cells = (double) (MAX_CELLS_PER_BODY * n);
+  if (!(cell_size > 0) || (width / cell_size + 1) * (height / cell_size + 1) > \
+    max_cells) {
+    // Solves (width / s + 1) * (height / s + 1) = max_cells for s
+    double a = max_cells - 1;
+    double b = width + height;
+    cell_size = (b + sqrt(b * b + 4 * a * width * height)) / (2 * a);
+  }
+  if (!(cell_size > 0)) {
+    cell_size = 1;
+  }
+  index->origin = world.min;
+  index->cell_size = cell_size;
+  index->cols = (size_t) floor(width / cell_size) + 1;
+  index->rows = (size_t) floor(height / cell_size) + 1;
+}
+
+void spatial_index_build(spatial_index_t *index, list_t *bodies) {
+  aabb_t world = index_collect(index, bodies);
+  if (index->count == 0) {
+    index->cols = 0;
+    index->rows = 0;
+    return;
+  }
+  index_size_grid(index, world);
+  size_t cells = index->cols * index->rows;
+  if (cells + 1 > index->cell_capacity) {
+    index->cell_capacity = cells + 1;
+    index->cell_start = realloc(index->cell_start, \
+      index->cell_capacity * sizeof(size_t));
+    assert(index->cell_start != NULL);
+  }
+
+  // Counting sort of the entries by cell, an entry in each cell it covers
+  size_t *cell_start = index->cell_start;
+  for (size_t c = 0; c <= cells; c++) {
+    cell_start[c] = 0;
+  }
+  size_t total = 0;
+  for (size_t e = 0; e < index->count; e++) {
+    index_entry_t *entry = &index->entries[e];
+    entry->first_col = grid_coord(entry->bounds.min.x, index->origin.x, \
+      index->cell_size, index->cols);
+    entry->first_row = grid_coord(entry->bounds.min.y, index->origin.y, \
+      index->cell_size, index->rows);
+    entry->last_col = grid_coord(entry->bounds.max.x, index->origin.x, \
+      index->cell_size, index->cols);
+    entry->last_row = grid_coord(entry->bounds.max.y, index->origin.y, \
+      index->cell_size, index->rows);
+    for (size_t row = entry->first_row; row <= entry->last_row; row++) {
+      for (size_t col = entry->first_col; col <= entry->last_col; col++) {
+        cell_start[row * index->cols + col + 1]++;
+        total++;
+      }
+    }
+  }
+  for (size_t c = 0; c < cells; c++) {
+    cell_start[c + 1] += cell_start[c];
+  }
+  if (total > index->cell_entry_capacity) {
+    index->cell_entry_capacity = total;
+    index->cell_entries = realloc(index->cell_entries, total * sizeof(size_t));
+    assert(index->cell_entries != NULL);
+  }
+  // Fills each cell from its end, leaving cell_start[c + 1] at the start
+  // of cell c
+  for (size_t e = index->count; e > 0; e--) {
+    index_entry_t *entry = &index->entries[e - 1];
+    for (size_t row = entry->first_row; row <= entry->last_row; row++) {
+      for (size_t col = entry->first_col; col <= entry->last_col; col++) {
+        size_t c = row * index->cols + col;
+        index->cell_entries[--cell_start[c + 1]] = e - 1;
+      }
+    }
+  }
+  for (size_t c = 0; c < cells; c++) {
+    cell_start[c] = cell_start[c + 1];
+  }
+  cell_start[cells] = total;
+}
+
+size_t spatial_index_query(spatial_index_t *index, aabb_t box, \
+  body_filter_t filter, void *aux, body_t **results, size_t capacity) {
+  if (index->count == 0) {
+    return 0;
+  }
+  size_t first_col = grid_coord(box.min.x, index->origin.x, index->cell_size, \
+    index->cols);
+  size_t first_row = grid_coord(box.min.y, index->origin.y, index->cell_size, \
+    index->rows);
+  size_t last_col = grid_coord(box.max.x, index->origin.x, index->cell_size, \
+    index->cols);
+  size_t last_row = grid_coord(box.max.y, index->origin.y, index->cell_size, \
+    index->rows);
+  size_t found = 0;
+  for (size_t row = first_row; row <= last_row; row++) {
+    for (size_t col = first_col; col <= last_col; col++) {
+      size_t c = row * index->cols + col;
+      for (size_t i = index->cell_start[c]; i < index->cell_start[c + 1]; i++) {
+        index_entry_t *entry = &index->entries[index->cell_entries[i]];
+        // A body covering several cells is only checked in the first cell
+        // that both it and the box cover
+        size_t shared_col = entry->first_col > first_col ? \
+          entry->first_col : first_col;
+        size_t shared_row = entry->first_row > first_row ? \
+          entry->first_row : first_row;
+        if (col != shared_col || row != shared_row) {
+          continue;
+        }
+        if (!aabb_overlap(entry->bounds, box)) {
+          continue;
+        }
+        if (filter != NULL && !filter(entry->body, aux)) {
+          continue;
+        }
+        if (found < capacity) {
+          results[found] = entry->body;
+        }
+        found++;
+      }
+    }
+  }
+  return found;
+}
+
+/**
+ * Finds the range of distances along a ray at which it is inside a box,
+ * given the reciprocal of the ray's direction.
+ * The range is empty (near > far) if the ray misses the box.
+ */
+void ray_box_range(aabb_t box, vector_t origin, vector_t inverse, \
+  double *near, double *far) {
+  double x1 = (box.min.x - origin.x) * inverse.x;
+  double x2 = (box.max.x - origin.x) * inverse.x;
+  double y1 = (box.min.y - origin.y) * inverse.y;
+  double y2 = (box.max.y - origin.y) * inverse.y;
+  // A ray parallel to an axis is inside the box along it everywhere or nowhere
+  if (isnan(x1) || isnan(x2)) {
+    x1 = -INFINITY;
+    x2 = INFINITY;
+  }
+  if (isnan(y1) || isnan(y2)) {
+    y1 = -INFINITY;
+    y2 = INFINITY;
+  }
+  *near = fmax(fmin(x1, x2), fmin(y1, y2));
+  *far = fmin(fmax(x1, x2), fmax(y1, y2));
+}
+
+/**
+ * Finds the distance along a ray at which it leaves a cell along one axis.
+ */
+double cell_exit(size_t cell, double grid_origin, double cell_size, \
+  double origin, double inverse) {
+  if (inverse > 0) {
+    return (grid_origin + (cell + 1) * cell_size - origin) * inverse;
+  }
+  if (inverse < 0) {
+    return (grid_origin + cell * cell_size - origin) * inverse;
+  }
+  return INFINITY;
+}
+
+body_t *spatial_index_raycast(spatial_index_t *index, vector_t origin, \
+  vector_t direction, double max_distance, ray_test_t test, void *aux, \
+  double *distance) {
+  if (index->count == 0) {
+    return NULL;
+  }
+  vector_t inverse = {1 / direction.x, 1 / direction.y};
+  aabb_t grid = {
+    index->origin,
+    {
+      index->origin.x + index->cols * index->cell_size,
+      index->origin.y + index->rows * index->cell_size
+    }
+  };
+  double near, far;
+  ray_box_range(grid, origin, inverse, &near, &far);
+  near = fmax(near, 0);
+  far = fmin(far, max_distance);
+  if (near > far) {
+    return NULL;
+  }
+
+  // Walks the cells like a line drawing algorithm (DDA), one step along
+  // whichever axis the ray reaches the next cell boundary on first
+  vector_t start = vec_add(origin, vec_multiply(near, direction));
+  size_t col = grid_coord(start.x, index->origin.x, index->cell_size, \
+    index->cols);
+  size_t row = grid_coord(start.y, index->origin.y, index->cell_size, \
+    index->rows);
+  double exit_x = cell_exit(col, index->origin.x, index->cell_size, origin.x, \
+    inverse.x);
+  double exit_y = cell_exit(row, index->origin.y, index->cell_size, origin.y, \
+    inverse.y);
+  double step_x = fabs(index->cell_size * inverse.x);
+  double step_y = fabs(index->cell_size * inverse.y);
+  body_t *nearest = NULL;
+  double nearest_distance = max_distance;
+  while (true) {
+    size_t c = row * index->cols + col;
+    for (size_t i = index->cell_start[c]; i < index->cell_start[c + 1]; i++) {
+      index_entry_t *entry = &index->entries[index->cell_entries[i]];
+      double box_near, box_far;
+      ray_box_range(entry->bounds, origin, inverse, &box_near, &box_far);
+      if (box_near > box_far || box_far < 0 || box_near > nearest_distance) {
+        continue;
+      }
+      double hit = test(entry->body, aux);
+      if (hit < nearest_distance) {
+        nearest = entry->body;
+        nearest_distance = hit;
+      }
+    }
+    // Bodies in later cells are hit further along than anything before
+    // the end of this cell
+    double exit = fmin(exit_x, exit_y);
+    if ((nearest != NULL && nearest_distance <= exit) || exit > far) {
+      break;
+    }
+    if (exit_x <= exit_y) {
+      if (inverse.x > 0 ? col + 1 >= index->cols : col == 0) {
+        break;
+      }
+      col = inverse.x > 0 ? col + 1 : col - 1;
+      exit_x += step_x;
+    }
+    else {
+      if (inverse.y > 0 ? row + 1 >= index->rows : row == 0) {
+        break;
+      }
+      row = inverse.y > 0 ? row + 1 : row - 1;
+      exit_y += step_y;
+    }
+  }
+  if (nearest != NULL) {
+    *distance = nearest_distance;
+  }
+  return nearest;
+}
@@ -0,0 +1,370 @@
+#include "spring_network.h"
+#include "body.h"
+#include "list.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t INIT_SPRINGS = 16;
+const double CG_TOLERANCE = 1e-10;
+const size_t CG_MAX_ITERATIONS = 1000;
+
+typedef struct spring_network {
+  scene_t *scene;
+  list_t *bodies;
+  bool implicit;
+  size_t iterations;
+  size_t size;
+  size_t capacity;
+  // Springs, one entry per spring in each array
+  size_t *body1;
+  size_t *body2;
+  double *k;
+  double *rest_length;
+  double *damping;
+  double *force_x;
+  double *force_y;
+  // Symmetric 2x2 blocks dt * D + dt^2 / 2 * K of each spring's Jacobian,
+  // where K and D are its derivatives with respect to position and velocity
+  double *jac_xx;
+  double *jac_xy;
+  double *jac_yy;
+  // Per-body scratch space, one entry per body in each array
+  double *scratch;
+  double *pos_x;
+  double *pos_y;
+  double *vel_x;
+  double *vel_y;
+  double *acc_x;
+  double *acc_y;
+  // Per-body conjugate-gradient state for implicit integration
+  double *mass;
+  double *dv_x;
+  double *dv_y;
+  double *res_x;
+  double *res_y;
+  double *dir_x;
+  double *dir_y;
+  double *prod_x;
+  double *prod_y;
+  double *pre_x;
+  double *pre_y;
+} spring_network_t;
+
+/**
+ * The number of per-body arrays in a spring network's scratch space.
+ */
+#define BODY_ARRAYS 17
+
+void spring_network_free(spring_network_t *network) {
+  free(network->body1);
+  free(network->body2);
+  free(network->k);
+  free(network->rest_length);
+  free(network->damping);
+  free(network->force_x);
+  free(network->force_y);
+  free(network->jac_xx);
+  free(network->jac_xy);
+  free(network->jac_yy);
+  free(network->scratch);
+  free(network);
+}
+
+spring_network_t *create_spring_network(scene_t *scene, list_t *bodies) {
+  spring_network_t *network = malloc(sizeof(spring_network_t));
+  assert(network != NULL);
+  size_t n = list_size(bodies);
+  network->scene = scene;
+  network->bodies = bodies;
+  network->implicit = false;
+  network->iterations = 0;
+  network->size = 0;
+  network->capacity = 0;
+  network->body1 = NULL;
+  network->body2 = NULL;
+  network->k = NULL;
+  network->rest_length = NULL;
+  network->damping = NULL;
+  network->force_x = NULL;
+  network->force_y = NULL;
+  network->jac_xx = NULL;
+  network->jac_xy = NULL;
+  network->jac_yy = NULL;
+  network->scratch = malloc(BODY_ARRAYS * n * sizeof(double));
+  assert(n == 0 || network->scratch != NULL);
+  double **arrays[BODY_ARRAYS] = {
+    &network->pos_x, &network->pos_y, &network->vel_x, &network->vel_y,
+    &network->acc_x, &network->acc_y, &network->mass,
+    &network->dv_x, &network->dv_y, &network->res_x, &network->res_y,
+    &network->dir_x, &network->dir_y, &network->prod_x, &network->prod_y,
+    &network->pre_x, &network->pre_y
+  };
+  for (size_t a = 0; a < BODY_ARRAYS; a++) {
+    *arrays[a] = network->scratch + a * n;
+  }
+  // The scene only reads the bodies list, so it can share the network's list
+  scene_add_bodies_force_creator(scene, spring_network_creator, network, \
+    bodies, (free_func_t) spring_network_free);
+  return network;
+}
+
+void spring_network_add(spring_network_t *network, size_t body1, size_t body2, \
+  double k, double rest_length, double damping) {
+  assert(body1 < list_size(network->bodies));
+  assert(body2 < list_size(network->bodies));
+  if (network->size == network->capacity) {
+    network->capacity = network->capacity == 0 ? INIT_SPRINGS : \
+      2 * network->capacity;
+    size_t cap = network->capacity;
+    network->body1 = realloc(network->body1, cap * sizeof(size_t));
+    network->body2 = realloc(network->body2, cap * sizeof(size_t));
+    network->k = realloc(network->k, cap * sizeof(double));
+    network->rest_length = realloc(network->rest_length, cap * sizeof(double));
+    network->damping = realloc(network->damping, cap * sizeof(double));
+    network->force_x = realloc(network->force_x, cap * sizeof(double));
+    network->force_y = realloc(network->force_y, cap * sizeof(double));
+    network->jac_xx = realloc(network->jac_xx, cap * sizeof(double));
+    network->jac_xy = realloc(network->jac_xy, cap * sizeof(double));
+    network->jac_yy = realloc(network->jac_yy, cap * sizeof(double));
+    assert(network->body1 != NULL && network->body2 != NULL &&
+      network->k != NULL && network->rest_length != NULL &&
+      network->damping != NULL && network->force_x != NULL &&
+      network->force_y != NULL && network->jac_xx != NULL &&
+      network->jac_xy != NULL && network->jac_yy != NULL);
+  }
+  size_t s = network->size;
+  network->body1[s] = body1;
+  network->body2[s] = body2;
+  network->k[s] = k;
+  network->rest_length[s] = rest_length;
+  network->damping[s] = damping;
+  network->size++;
+}
+
+size_t spring_network_size(spring_network_t *network) {
+  return network->size;
+}
+
+void spring_network_set_implicit(spring_network_t *network, bool implicit) {
+  network->implicit = implicit;
+  network->iterations = 0;
+}
+
+size_t spring_network_iterations(spring_network_t *network) {
+  return network->iterations;
+}
+
+/**
+ * Computes the force on body1 of each spring, which is independent per spring.
+ * If dt is positive, also computes each spring's Jacobian block
+ * and adds dt * force + dt^2 * K * velocity to acc for the implicit solve.
+ * Otherwise adds the forces to acc.
+ */
+void spring_network_forces(spring_network_t *net, double dt) {
+  for (size_t s = 0; s < net->size; s++) {
+    size_t i = net->body1[s];
+    size_t j = net->body2[s];
+    double dx = net->pos_x[j] - net->pos_x[i];
+    double dy = net->pos_y[j] - net->pos_y[i];
+    double dvx = net->vel_x[j] - net->vel_x[i];
+    double dvy = net->vel_y[j] - net->vel_y[i];
+    double len = sqrt(dx * dx + dy * dy);
+    double inv_len = len > 0 ? 1 / len : 0;
+    // k * (len - rest_length) / len, exactly k for springs of rest length 0
+    double stretch = net->k[s] * (1 - net->rest_length[s] * inv_len);
+    double damp = net->damping[s] * (dvx * dx + dvy * dy) * inv_len * inv_len;
+    net->force_x[s] = (stretch + damp) * dx;
+    net->force_y[s] = (stretch + damp) * dy;
+  }
+
+  if (dt <= 0) {
+    for (size_t s = 0; s < net->size; s++) {
+      net->acc_x[net->body1[s]] += net->force_x[s];
+      net->acc_y[net->body1[s]] += net->force_y[s];
+      net->acc_x[net->body2[s]] -= net->force_x[s];
+      net->acc_y[net->body2[s]] -= net->force_y[s];
+    }
+    return;
+  }
+
+  for (size_t s = 0; s < net->size; s++) {
+    size_t i = net->body1[s];
+    size_t j = net->body2[s];
+    double dx = net->pos_x[j] - net->pos_x[i];
+    double dy = net->pos_y[j] - net->pos_y[i];
+    double len = sqrt(dx * dx + dy * dy);
+    double inv_len = len > 0 ? 1 / len : 0;
+    double ux = dx * inv_len;
+    double uy = dy * inv_len;
+    // K = k * (u u^T + a * (I - u u^T)), dropping the transverse stiffness
+    // of compressed springs (a < 0) so that the system stays positive definite
+    double a = 1 - net->rest_length[s] * inv_len;
+    a = a > 0 ? a : 0;
+    double k = net->k[s];
+    double k_xx = k * (a + (1 - a) * ux * ux);
+    double k_xy = k * (1 - a) * ux * uy;
+    double k_yy = k * (a + (1 - a) * uy * uy);
+    double c = net->damping[s];
+    net->jac_xx[s] = dt * c * ux * ux + dt * dt / 2 * k_xx;
+    net->jac_xy[s] = dt * c * ux * uy + dt * dt / 2 * k_xy;
+    net->jac_yy[s] = dt * c * uy * uy + dt * dt / 2 * k_yy;
+    double dvx = net->vel_x[j] - net->vel_x[i];
+    double dvy = net->vel_y[j] - net->vel_y[i];
+    double rhs_x = dt * net->force_x[s] + dt * dt * (k_xx * dvx + k_xy * dvy);
+    double rhs_y = dt * net->force_y[s] + dt * dt * (k_xy * dvx + k_yy * dvy);
+    net->acc_x[i] += rhs_x;
+    net->acc_y[i] += rhs_y;
+    net->acc_x[j] -= rhs_x;
+    net->acc_y[j] -= rhs_y;
+  }
+}
+
+/**
+ * Computes prod = (M + sum of spring Jacobian blocks) * dir,
+ * the matrix of the implicit solve applied to the search direction.
+ */
+void spring_network_product(spring_network_t *net, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    double m = isinf(net->mass[i]) ? 0 : net->mass[i];
+    net->prod_x[i] = m * net->dir_x[i];
+    net->prod_y[i] = m * net->dir_y[i];
+  }
+  for (size_t s = 0; s < net->size; s++) {
+    size_t i = net->body1[s];
+    size_t j = net->body2[s];
+    double px = net->dir_x[i] - net->dir_x[j];
+    double py = net->dir_y[i] - net->dir_y[j];
+    double qx = net->jac_xx[s] * px + net->jac_xy[s] * py;
+    double qy = net->jac_xy[s] * px + net->jac_yy[s] * py;
+    net->prod_x[i] += qx;
+    net->prod_y[i] += qy;
+    net->prod_x[j] -= qx;
+    net->prod_y[j] -= qy;
+  }
+  // Bodies with infinite mass are fixed, so they are left out of the system
+  for (size_t i = 0; i < n; i++) {
+    if (isinf(net->mass[i])) {
+      net->prod_x[i] = 0;
+      net->prod_y[i] = 0;
+    }
+  }
+}
+
+double spring_network_dot(double *a_x, double *a_y, double *b_x, double *b_y, \
+  size_t n) {
+  double sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += a_x[i] * b_x[i] + a_y[i] * b_y[i];
+  }
+  return sum;
+}
+
+/**
+ * Solves (M - dt * D - dt^2 / 2 * K) * dv = dt * f + dt^2 * K * v
+ * for the change in velocity dv of each body over the tick, with the
+ * right-hand side in acc, by conjugate gradients with a Jacobi preconditioner.
+ * -D and -K are sums of positive semidefinite spring blocks,
+ * so the matrix is symmetric positive definite.
+ * dv = dt * f(x + dx, v + dv) / M with dx = dt * (v + dv / 2),
+ * matching how body_tick() moves bodies.
+ */
+void spring_network_solve(spring_network_t *net, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    net->pre_x[i] = net->mass[i];
+    net->pre_y[i] = net->mass[i];
+  }
+  for (size_t s = 0; s < net->size; s++) {
+    net->pre_x[net->body1[s]] += net->jac_xx[s];
+    net->pre_y[net->body1[s]] += net->jac_yy[s];
+    net->pre_x[net->body2[s]] += net->jac_xx[s];
+    net->pre_y[net->body2[s]] += net->jac_yy[s];
+  }
+  for (size_t i = 0; i < n; i++) {
+    bool fixed = isinf(net->mass[i]);
+    net->pre_x[i] = fixed || net->pre_x[i] == 0 ? 0 : 1 / net->pre_x[i];
+    net->pre_y[i] = fixed || net->pre_y[i] == 0 ? 0 : 1 / net->pre_y[i];
+    net->dv_x[i] = 0;
+    net->dv_y[i] = 0;
+    net->res_x[i] = fixed ? 0 : net->acc_x[i];
+    net->res_y[i] = fixed ? 0 : net->acc_y[i];
+    net->dir_x[i] = net->pre_x[i] * net->res_x[i];
+    net->dir_y[i] = net->pre_y[i] * net->res_y[i];
+  }
+
+  double rhs_norm = spring_network_dot(net->res_x, net->res_y, \
+    net->res_x, net->res_y, n);
+  double rz = spring_network_dot(net->res_x, net->res_y, \
+    net->dir_x, net->dir_y, n);
+  net->iterations = 0;
+  if (rhs_norm == 0) {
+    return;
+  }
+  while (net->iterations < CG_MAX_ITERATIONS) {
+    net->iterations++;
+    spring_network_product(net, n);
+    double curvature = spring_network_dot(net->dir_x, net->dir_y, \
+      net->prod_x, net->prod_y, n);
+    if (curvature <= 0) {
+      break;
+    }
+    double alpha = rz / curvature;
+    for (size_t i = 0; i < n; i++) {
+      net->dv_x[i] += alpha * net->dir_x[i];
+      net->dv_y[i] += alpha * net->dir_y[i];
+      net->res_x[i] -= alpha * net->prod_x[i];
+      net->res_y[i] -= alpha * net->prod_y[i];
+    }
+    double res_norm = spring_network_dot(net->res_x, net->res_y, \
+      net->res_x, net->res_y, n);
+    if (res_norm <= CG_TOLERANCE * CG_TOLERANCE * rhs_norm) {
+      break;
+    }
+    double new_rz = 0;
+    for (size_t i = 0; i < n; i++) {
+      new_rz += net->pre_x[i] * net->res_x[i] * net->res_x[i] + \
+        net->pre_y[i] * net->res_y[i] * net->res_y[i];
+    }
+    double beta = new_rz / rz;
+    rz = new_rz;
+    for (size_t i = 0; i < n; i++) {
+      net->dir_x[i] = net->pre_x[i] * net->res_x[i] + beta * net->dir_x[i];
+      net->dir_y[i] = net->pre_y[i] * net->res_y[i] + beta * net->dir_y[i];
+    }
+  }
+}
+
+void spring_network_creator(void *network) {
+  spring_network_t *net = network;
+  size_t n = list_size(net->bodies);
+  for (size_t i = 0; i < n; i++) {
+    body_t *body = list_get(net->bodies, i);
+    net->pos_x[i] = body->centroid.x;
+    net->pos_y[i] = body->centroid.y;
+    net->vel_x[i] = body->velocity.x;
+    net->vel_y[i] = body->velocity.y;
+    net->mass[i] = body->mass;
+    net->acc_x[i] = 0.0;
+    net->acc_y[i] = 0.0;
+  }
+
+  double dt = net->implicit ? scene_get_dt(net->scene) : 0;
+  spring_network_forces(net, dt);
+  if (dt <= 0) {
+    for (size_t i = 0; i < n; i++) {
+      body_add_force(list_get(net->bodies, i),
+        (vector_t) {net->acc_x[i], net->acc_y[i]});
+    }
+    return;
+  }
+
+  spring_network_solve(net, n);
+  for (size_t i = 0; i < n; i++) {
+    if (!isinf(net->mass[i])) {
+      body_add_impulse(list_get(net->bodies, i), (vector_t) {
+        net->mass[i] * net->dv_x[i],
+        net->mass[i] * net->dv_y[i]
+      });
+    }
+  }
+}
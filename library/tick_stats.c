@@ -0,0 +1,163 @@
+#include "tick_stats.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include "trace.h"
+
+const size_t TICK_STATS_WINDOW = 128;
+const char *const TICK_PHASE_NAMES[NUM_TICK_PHASES] = {
+  [TICK_PHASE_FORCES] = "forces",
+  [TICK_PHASE_CREATORS] = "force creators",
+  [TICK_PHASE_COLLISIONS] = "collisions",
+  [TICK_PHASE_COMMANDS] = "commands",
+  [TICK_PHASE_REMOVAL_SCAN] = "removal scan",
+  [TICK_PHASE_COMPACTION] = "compaction",
+  [TICK_PHASE_SOLVERS] = "solvers",
+  [TICK_PHASE_INTEGRATION] = "integration"
+};
+// Fraction of the window at or below the reported percentile
+const double PERCENTILE = 0.99;
+
+/**
+ * The timings and counters of one tick.
+ */
+typedef struct tick_sample {
+  double tick_time;
+  double phase_times[NUM_TICK_PHASES];
+  size_t counters[NUM_TICK_COUNTERS];
+} tick_sample_t;
+
+typedef struct tick_stats {
+  // Ring buffer of the latest ticks, the newest at (next - 1)
+  tick_sample_t *samples;
+  size_t next;
+  size_t count;
+  // The tick being recorded
+  tick_sample_t current;
+  // When the tick began and when its last lap ended
+  double begin_time;
+  double lap_time;
+  // Space to sort one statistic over the window in
+  double *sorted;
+} tick_stats_t;
+
+tick_stats_t *tick_stats_init(void) {
+  tick_stats_t *stats = malloc(sizeof(tick_stats_t));
+  assert(stats != NULL);
+  stats->samples = malloc(TICK_STATS_WINDOW * sizeof(tick_sample_t));
+  stats->sorted = malloc(TICK_STATS_WINDOW * sizeof(double));
+  assert(stats->samples != NULL && stats->sorted != NULL);
+  stats->next = 0;
+  stats->count = 0;
+  stats->current = (tick_sample_t) {0};
+  stats->begin_time = 0;
+  stats->lap_time = 0;
+  return stats;
+}
+
+void tick_stats_free(tick_stats_t *stats) {
+  free(stats->samples);
+  free(stats->sorted);
+  free(stats);
+}
+
+void tick_stats_begin(tick_stats_t *stats) {
+  if (stats == NULL) {
+    return;
+  }
+  stats->current = (tick_sample_t) {0};
+  stats->begin_time = trace_now();
+  stats->lap_time = stats->begin_time;
+}
+
+void tick_stats_lap(tick_stats_t *stats, tick_phase_t phase) {
+  if (stats == NULL) {
+    return;
+  }
+  double now = trace_now();
+  stats->current.phase_times[phase] += now - stats->lap_time;
+  TRACE_SPAN(TICK_PHASE_NAMES[phase], stats->lap_time, now);
+  stats->lap_time = now;
+}
+
+void tick_stats_count(tick_stats_t *stats, tick_counter_t counter, size_t n) {
+  if (stats == NULL) {
+    return;
+  }
+  stats->current.counters[counter] += n;
+}
+
+void tick_stats_end(tick_stats_t *stats) {
+  if (stats == NULL) {
+    return;
+  }
+  double now = trace_now();
+  stats->current.tick_time = now - stats->begin_time;
+  TRACE_SPAN("tick", stats->begin_time, now);
+  stats->samples[stats->next] = stats->current;
+  stats->next = (stats->next + 1) % TICK_STATS_WINDOW;
+  if (stats->count < TICK_STATS_WINDOW) {
+    stats->count++;
+  }
+}
+
+int compare_samples(const void *a, const void *b) {
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Summarizes the values of one statistic over the window,
+ * which have been copied into stats->sorted.
+ */
+stat_summary_t summarize_sorted(tick_stats_t *stats) {
+  size_t n = stats->count;
+  double *sorted = stats->sorted;
+  qsort(sorted, n, sizeof(double), compare_samples);
+  double sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += sorted[i];
+  }
+  size_t rank = (size_t) ceil(PERCENTILE * n);
+  return (stat_summary_t) {
+    sorted[0], sum / n, sorted[rank > 0 ? rank - 1 : 0], sorted[n - 1]
+  };
+}
+
+void tick_stats_summarize(tick_stats_t *stats, scene_stats_t *summary) {
+  *summary = (scene_stats_t) {0};
+  if (stats == NULL || stats->count == 0) {
+    return;
+  }
+  summary->ticks = stats->count;
+  tick_sample_t *latest = &stats->samples[
+    (stats->next + TICK_STATS_WINDOW - 1) % TICK_STATS_WINDOW
+  ];
+  summary->tick_time = latest->tick_time;
+  for (size_t p = 0; p < NUM_TICK_PHASES; p++) {
+    summary->phase_times[p] = latest->phase_times[p];
+  }
+  for (size_t c = 0; c < NUM_TICK_COUNTERS; c++) {
+    summary->counters[c] = latest->counters[c];
+  }
+
+  // The samples fill the buffer from the start until the window is full,
+  // so the first count samples are the ones in the window
+  for (size_t i = 0; i < stats->count; i++) {
+    stats->sorted[i] = stats->samples[i].tick_time;
+  }
+  summary->tick_summary = summarize_sorted(stats);
+  for (size_t p = 0; p < NUM_TICK_PHASES; p++) {
+    for (size_t i = 0; i < stats->count; i++) {
+      stats->sorted[i] = stats->samples[i].phase_times[p];
+    }
+    summary->phase_summaries[p] = summarize_sorted(stats);
+  }
+  for (size_t c = 0; c < NUM_TICK_COUNTERS; c++) {
+    for (size_t i = 0; i < stats->count; i++) {
+      stats->sorted[i] = (double) stats->samples[i].counters[c];
+    }
+    summary->counter_summaries[c] = summarize_sorted(stats);
+  }
+}
@@ -0,0 +1,112 @@
+#include "trace.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+const unsigned long TRACE_EVENTS = 1 << 16;
+
+/**
+ * A span of work, or the start or end of one.
+ */
+typedef struct trace_record {
+  const char *name;
+  // 'B' or 'E' for the start or end of a span, or 'X' for a whole span
+  char phase;
+  // Microseconds, as in the trace-event format
+  double timestamp;
+  double duration;
+} trace_record_t;
+
+/**
+ * The ring buffer of events recorded by one thread.
+ */
+typedef struct trace_buffer {
+  trace_record_t *records;
+  // Number of events ever recorded; the newest is at (written - 1) % size
+  atomic_ulong written;
+  // The thread's id in the trace, in the order threads first record events
+  unsigned long thread;
+  struct trace_buffer *next;
+} trace_buffer_t;
+
+// Every thread's buffer, newest first
+static _Atomic(trace_buffer_t *) trace_buffers = NULL;
+static atomic_ulong trace_threads = 0;
+static _Thread_local trace_buffer_t *thread_buffer = NULL;
+
+double trace_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * Gets the calling thread's buffer, adding one to the list of buffers
+ * the first time the thread records an event.
+ */
+trace_buffer_t *trace_thread_buffer(void) {
+  if (thread_buffer != NULL) {
+    return thread_buffer;
+  }
+  trace_buffer_t *buffer = malloc(sizeof(trace_buffer_t));
+  assert(buffer != NULL);
+  buffer->records = malloc(TRACE_EVENTS * sizeof(trace_record_t));
+  assert(buffer->records != NULL);
+  atomic_init(&buffer->written, 0);
+  buffer->thread = atomic_fetch_add(&trace_threads, 1);
+  buffer->next = atomic_load(&trace_buffers);
+  while (!atomic_compare_exchange_weak(&trace_buffers, &buffer->next, \
+    buffer)) {
+  }
+  thread_buffer = buffer;
+  return buffer;
+}
+
+/**
+ * Adds an event to the calling thread's buffer.
+ */
+void trace_record(trace_record_t record) {
+  trace_buffer_t *buffer = trace_thread_buffer();
+  unsigned long written = atomic_load_explicit(&buffer->written, \
+    memory_order_relaxed);
+  buffer->records[written % TRACE_EVENTS] = record;
+  // Publishes the event to trace_write()
+  atomic_store_explicit(&buffer->written, written + 1, memory_order_release);
+}
+
+void trace_event(const char *name, char phase) {
+  trace_record((trace_record_t) {name, phase, trace_now() * 1e6, 0});
+}
+
+void trace_span(const char *name, double start, double end) {
+  trace_record((trace_record_t) {name, 'X', start * 1e6, (end - start) * 1e6});
+}
+
+bool trace_write(const char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    return false;
+  }
+  fputs("{\"traceEvents\":[", file);
+  bool first = true;
+  for (trace_buffer_t *buffer = atomic_load(&trace_buffers); buffer != NULL; \
+    buffer = buffer->next) {
+    unsigned long written = atomic_load_explicit(&buffer->written, \
+      memory_order_acquire);
+    unsigned long start = written > TRACE_EVENTS ? written - TRACE_EVENTS : 0;
+    for (unsigned long e = start; e < written; e++) {
+      trace_record_t *record = &buffer->records[e % TRACE_EVENTS];
+      fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,", \
+        first ? "" : ",", record->name, record->phase, record->timestamp);
+      if (record->phase == 'X') {
+        fprintf(file, "\"dur\":%.3f,", record->duration);
+      }
+      fprintf(file, "\"pid\":1,\"tid\":%lu}", buffer->thread);
+      first = false;
+    }
+  }
+  fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+  return fclose(file) == 0;
+}
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <math.h>
 #include "vector.h"
+#include "hot_counters.h"
 
 const vector_t VEC_ZERO = {0.0, 0.0};
 
@@ -44,6 +45,7 @@ double vec_cross(vector_t v1, vector_t v2){
 }
 
 vector_t vec_rotate(vector_t v, double angle){
+    HOT_COUNT(HOT_TRIG_CALLS, 4);
     double x_rot = v.x * cos(angle) + v.y * -sin(angle);
     double y_rot = v.x * sin(angle) + v.y * cos(angle);
     vector_t rotated = {x_rot, y_rot};
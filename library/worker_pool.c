@@ -0,0 +1,444 @@
+#include "worker_pool.h"
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "trace.h"
+
+/**
+ * The most chunks a worker's deque can hold.
+ * Chunks are only split while the deque is empty, so this is only reached
+ * by many jobs submitted at once from inside a task.
+ * Chunks that don't fit go on the pool's injection queue instead.
+ */
+#define DEQUE_CAPACITY 256
+
+// Chunks a job is split into per thread, at the finest
+const size_t CHUNKS_PER_THREAD = 16;
+// Times an idle thread looks for work before going to sleep
+const int IDLE_SPINS = 64;
+
+typedef struct pool_job {
+  pool_task_t task;
+  void *aux;
+  size_t count;
+  // The smallest range worth splitting off for another thread
+  size_t grain;
+  // Number of indices not yet processed
+  atomic_size_t remaining;
+  // Number of dependencies not yet finished, plus 1 while being submitted
+  atomic_size_t unmet;
+  atomic_bool done;
+  // Jobs that depend on this one, protected by the pool's lock
+  pool_job_t **dependents;
+  size_t dependent_count;
+  size_t dependent_capacity;
+} pool_job_t;
+
+/**
+ * A range of a job's indices waiting to be run.
+ */
+typedef struct chunk {
+  pool_job_t *job;
+  size_t start;
+  size_t end;
+  // The next chunk in the pool's injection queue
+  struct chunk *next;
+} chunk_t;
+
+/**
+ * A Chase-Lev work-stealing deque.
+ * Its owner pushes and takes chunks at the bottom, while other threads
+ * steal the oldest (and so largest) chunks from the top.
+ */
+typedef struct deque {
+  atomic_long top;
+  atomic_long bottom;
+  _Atomic(chunk_t *) buffer[DEQUE_CAPACITY];
+} deque_t;
+
+/**
+ * One of a pool's threads, which owns a deque.
+ */
+typedef struct worker {
+  worker_pool_t *pool;
+  size_t index;
+  pthread_t id;
+  deque_t deque;
+} worker_t;
+
+typedef struct worker_pool {
+  size_t threads;
+  // The pool's own threads, with indices 1 to threads - 1
+  worker_t *workers;
+  // Protects the injection queue, the dependents of jobs, and sleeping
+  pthread_mutex_t lock;
+  // Signaled when work is queued, a job finishes, or the pool is stopping
+  pthread_cond_t wake;
+  // Chunks queued by threads outside the pool, oldest first
+  chunk_t *inject_head;
+  chunk_t *inject_tail;
+  // Number of chunks in the injection queue, which can be read without the lock
+  atomic_size_t injected;
+  // Number of chunks in every deque and the injection queue
+  atomic_size_t queued;
+  // Number of threads sleeping on wake
+  atomic_size_t sleepers;
+  atomic_bool stopping;
+} worker_pool_t;
+
+/**
+ * The worker the current thread is, or NULL outside of any pool.
+ */
+static _Thread_local worker_t *current_worker = NULL;
+
+bool deque_push(deque_t *deque, chunk_t *chunk) {
+  long bottom = atomic_load(&deque->bottom);
+  long top = atomic_load(&deque->top);
+  if (bottom - top >= DEQUE_CAPACITY) {
+    return false;
+  }
+  atomic_store(&deque->buffer[bottom % DEQUE_CAPACITY], chunk);
+  atomic_store(&deque->bottom, bottom + 1);
+  return true;
+}
+
+chunk_t *deque_take(deque_t *deque) {
+  long bottom = atomic_load(&deque->bottom) - 1;
+  atomic_store(&deque->bottom, bottom);
+  long top = atomic_load(&deque->top);
+  if (top > bottom) {
+    atomic_store(&deque->bottom, bottom + 1);
+    return NULL;
+  }
+  chunk_t *chunk = atomic_load(&deque->buffer[bottom % DEQUE_CAPACITY]);
+  if (top == bottom) {
+    // The last chunk, which a thief may be stealing at the same time
+    if (!atomic_compare_exchange_strong(&deque->top, &top, top + 1)) {
+      chunk = NULL;
+    }
+    atomic_store(&deque->bottom, bottom + 1);
+  }
+  return chunk;
+}
+
+chunk_t *deque_steal(deque_t *deque) {
+  long top = atomic_load(&deque->top);
+  long bottom = atomic_load(&deque->bottom);
+  if (top >= bottom) {
+    return NULL;
+  }
+  chunk_t *chunk = atomic_load(&deque->buffer[top % DEQUE_CAPACITY]);
+  if (!atomic_compare_exchange_strong(&deque->top, &top, top + 1)) {
+    return NULL;
+  }
+  return chunk;
+}
+
+long deque_size(deque_t *deque) {
+  return atomic_load(&deque->bottom) - atomic_load(&deque->top);
+}
+
+/**
+ * Gets the current thread's worker if it belongs to a pool.
+ */
+worker_t *pool_worker(worker_pool_t *pool) {
+  return current_worker != NULL && current_worker->pool == pool ? \
+    current_worker : NULL;
+}
+
+/**
+ * Queues a chunk on the current thread's deque, or on the injection queue
+ * if the thread is not one of the pool's or its deque is full,
+ * and wakes any sleeping threads to run it.
+ */
+void pool_push(worker_pool_t *pool, chunk_t *chunk) {
+  // Counted before it is queued, so the count never drops below 0
+  // when the chunk is taken before this returns
+  atomic_fetch_add(&pool->queued, 1);
+  worker_t *worker = pool_worker(pool);
+  if (worker == NULL || !deque_push(&worker->deque, chunk)) {
+    chunk->next = NULL;
+    pthread_mutex_lock(&pool->lock);
+    if (pool->inject_tail != NULL) {
+      pool->inject_tail->next = chunk;
+    }
+    else {
+      pool->inject_head = chunk;
+    }
+    pool->inject_tail = chunk;
+    atomic_fetch_add(&pool->injected, 1);
+    pthread_mutex_unlock(&pool->lock);
+  }
+  if (atomic_load(&pool->sleepers) > 0) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+/**
+ * Finds a queued chunk to run: the newest on the thread's own deque,
+ * then the oldest in the injection queue, then one stolen from another worker.
+ */
+chunk_t *pool_find_work(worker_pool_t *pool) {
+  worker_t *worker = pool_worker(pool);
+  chunk_t *chunk = worker != NULL ? deque_take(&worker->deque) : NULL;
+  if (chunk == NULL && atomic_load(&pool->injected) > 0) {
+    pthread_mutex_lock(&pool->lock);
+    chunk = pool->inject_head;
+    if (chunk != NULL) {
+      pool->inject_head = chunk->next;
+      if (pool->inject_head == NULL) {
+        pool->inject_tail = NULL;
+      }
+      atomic_fetch_sub(&pool->injected, 1);
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+  // Start stealing after the thread's own worker, to spread out the thieves
+  size_t first = worker != NULL ? worker->index : 0;
+  for (size_t i = 1; chunk == NULL && i < pool->threads; i++) {
+    size_t victim = (first + i - 1) % (pool->threads - 1) + 1;
+    chunk = deque_steal(&pool->workers[victim].deque);
+  }
+  if (chunk != NULL) {
+    atomic_fetch_sub(&pool->queued, 1);
+  }
+  return chunk;
+}
+
+/**
+ * Queues the whole of a job whose dependencies have finished.
+ */
+void job_schedule(worker_pool_t *pool, pool_job_t *job);
+
+/**
+ * Marks a job as done and schedules any dependents it was the last
+ * dependency of. The job is not accessed after it is marked as done,
+ * since its waiter may free it.
+ */
+void job_finish(worker_pool_t *pool, pool_job_t *job) {
+  pthread_mutex_lock(&pool->lock);
+  pool_job_t **dependents = job->dependents;
+  size_t dependent_count = job->dependent_count;
+  atomic_store(&job->done, true);
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+  for (size_t i = 0; i < dependent_count; i++) {
+    if (atomic_fetch_sub(&dependents[i]->unmet, 1) == 1) {
+      job_schedule(pool, dependents[i]);
+    }
+  }
+  free(dependents);
+}
+
+void job_schedule(worker_pool_t *pool, pool_job_t *job) {
+  if (job->count == 0) {
+    job_finish(pool, job);
+    return;
+  }
+  chunk_t *chunk = malloc(sizeof(chunk_t));
+  assert(chunk != NULL);
+  *chunk = (chunk_t) {job, 0, job->count, NULL};
+  pool_push(pool, chunk);
+}
+
+/**
+ * Runs a chunk by lazy binary splitting: while the chunk is larger
+ * than its job's grain and the thread has no other chunks queued
+ * for idle threads to steal, the upper half is split off and queued.
+ * Otherwise the next grain of indices is run.
+ * Idle threads thus always find large ranges to steal,
+ * however unevenly the work is spread over the indices.
+ */
+void chunk_run(worker_pool_t *pool, chunk_t *chunk) {
+  pool_job_t *job = chunk->job;
+  size_t start = chunk->start;
+  size_t end = chunk->end;
+  free(chunk);
+  worker_t *worker = pool_worker(pool);
+  while (start < end) {
+    bool starved = worker != NULL ? deque_size(&worker->deque) == 0 : \
+      atomic_load(&pool->injected) == 0;
+    if (end - start > job->grain && starved && pool->threads > 1) {
+      size_t middle = start + (end - start) / 2;
+      chunk_t *upper = malloc(sizeof(chunk_t));
+      assert(upper != NULL);
+      *upper = (chunk_t) {job, middle, end, NULL};
+      pool_push(pool, upper);
+      end = middle;
+      continue;
+    }
+    size_t stop = end - start > job->grain ? start + job->grain : end;
+    TRACE_BEGIN("task");
+    job->task(job->aux, start, stop);
+    TRACE_END("task");
+    if (atomic_fetch_sub(&job->remaining, stop - start) == stop - start) {
+      job_finish(pool, job);
+    }
+    start = stop;
+  }
+}
+
+/**
+ * Puts the current thread to sleep until work is queued,
+ * or until a job is done if one is given.
+ */
+void pool_sleep(worker_pool_t *pool, pool_job_t *job) {
+  TRACE_BEGIN("sleep");
+  atomic_fetch_add(&pool->sleepers, 1);
+  pthread_mutex_lock(&pool->lock);
+  while (atomic_load(&pool->queued) == 0 && !atomic_load(&pool->stopping) && \
+    (job == NULL || !atomic_load(&job->done))) {
+    pthread_cond_wait(&pool->wake, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  atomic_fetch_sub(&pool->sleepers, 1);
+  TRACE_END("sleep");
+}
+
+void *worker_loop(void *arg) {
+  worker_t *worker = arg;
+  worker_pool_t *pool = worker->pool;
+  current_worker = worker;
+  int idle = 0;
+  while (true) {
+    chunk_t *chunk = pool_find_work(pool);
+    if (chunk != NULL) {
+      chunk_run(pool, chunk);
+      idle = 0;
+      continue;
+    }
+    if (atomic_load(&pool->stopping)) {
+      break;
+    }
+    if (++idle < IDLE_SPINS) {
+      sched_yield();
+    }
+    else {
+      pool_sleep(pool, NULL);
+      idle = 0;
+    }
+  }
+  current_worker = NULL;
+  return NULL;
+}
+
+worker_pool_t *worker_pool_init(size_t threads) {
+  assert(threads > 0);
+  worker_pool_t *pool = malloc(sizeof(worker_pool_t));
+  assert(pool != NULL);
+  pool->threads = threads;
+  pool->workers = malloc(threads * sizeof(worker_t));
+  assert(pool->workers != NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pool->inject_head = NULL;
+  pool->inject_tail = NULL;
+  atomic_init(&pool->injected, 0);
+  atomic_init(&pool->queued, 0);
+  atomic_init(&pool->sleepers, 0);
+  atomic_init(&pool->stopping, false);
+  for (size_t t = 1; t < threads; t++) {
+    worker_t *worker = &pool->workers[t];
+    worker->pool = pool;
+    worker->index = t;
+    atomic_init(&worker->deque.top, 0);
+    atomic_init(&worker->deque.bottom, 0);
+  }
+  for (size_t t = 1; t < threads; t++) {
+    int error = pthread_create(&pool->workers[t].id, NULL, worker_loop, \
+      &pool->workers[t]);
+    assert(error == 0);
+  }
+  return pool;
+}
+
+void worker_pool_free(worker_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  atomic_store(&pool->stopping, true);
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+  for (size_t t = 1; t < pool->threads; t++) {
+    pthread_join(pool->workers[t].id, NULL);
+  }
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->workers);
+  free(pool);
+}
+
+size_t worker_pool_threads(worker_pool_t *pool) {
+  return pool->threads;
+}
+
+size_t worker_pool_thread_index(worker_pool_t *pool) {
+  worker_t *worker = pool_worker(pool);
+  return worker != NULL ? worker->index : 0;
+}
+
+pool_job_t *worker_pool_submit(worker_pool_t *pool, pool_task_t task, \
+  void *aux, size_t count, pool_job_t **deps, size_t dep_count) {
+  pool_job_t *job = malloc(sizeof(pool_job_t));
+  assert(job != NULL);
+  job->task = task;
+  job->aux = aux;
+  job->count = count;
+  size_t chunks = pool->threads * CHUNKS_PER_THREAD;
+  job->grain = count > chunks ? count / chunks : 1;
+  atomic_init(&job->remaining, count);
+  atomic_init(&job->unmet, 1);
+  atomic_init(&job->done, false);
+  job->dependents = NULL;
+  job->dependent_count = 0;
+  job->dependent_capacity = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  for (size_t i = 0; i < dep_count; i++) {
+    pool_job_t *dep = deps[i];
+    if (atomic_load(&dep->done)) {
+      continue;
+    }
+    if (dep->dependent_count == dep->dependent_capacity) {
+      dep->dependent_capacity = 2 * dep->dependent_capacity + 1;
+      dep->dependents = realloc(dep->dependents, \
+        dep->dependent_capacity * sizeof(pool_job_t *));
+      assert(dep->dependents != NULL);
+    }
+    dep->dependents[dep->dependent_count++] = job;
+    atomic_fetch_add(&job->unmet, 1);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  // Dependencies may have finished while the job was being submitted
+  if (atomic_fetch_sub(&job->unmet, 1) == 1) {
+    job_schedule(pool, job);
+  }
+  return job;
+}
+
+void worker_pool_wait(worker_pool_t *pool, pool_job_t *job) {
+  int idle = 0;
+  while (!atomic_load(&job->done)) {
+    chunk_t *chunk = pool_find_work(pool);
+    if (chunk != NULL) {
+      chunk_run(pool, chunk);
+      idle = 0;
+    }
+    else if (++idle < IDLE_SPINS) {
+      sched_yield();
+    }
+    else {
+      pool_sleep(pool, job);
+      idle = 0;
+    }
+  }
+  free(job);
+}
+
+void worker_pool_run(worker_pool_t *pool, pool_task_t task, void *aux, \
+  size_t count) {
+  worker_pool_wait(pool, worker_pool_submit(pool, task, aux, count, NULL, 0));
+}
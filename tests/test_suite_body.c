@@ -169,6 +169,45 @@ void test_forces() {
     body_free(body);
 }
 
+void test_body_tick_with_drag() {
+    const double MASS = 2;
+    const double GAMMA = 3;
+    const double DT = 0.5;
+    const int STEPS = 10;
+    const vector_t FORCE = {6, -3};
+    list_t *shape = list_init(3, free);
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, 0};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {0, +1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, 0};
+    list_add(shape, v);
+    body_t *body = body_init(shape, MASS, (rgb_color_t) {0, 0, 0});
+    body_set_centroid(body, VEC_ZERO);
+    vector_t v0 = {4, 1};
+    body_set_velocity(body, v0);
+    // Even with large timesteps, matches the analytic solution exactly
+    vector_t terminal = vec_multiply(1 / GAMMA, FORCE);
+    vector_t relative = vec_subtract(v0, terminal);
+    for (int i = 1; i <= STEPS; i++) {
+        body_add_force(body, FORCE);
+        body_tick_with_drag(body, DT, GAMMA);
+        double t = i * DT;
+        double decay = exp(-GAMMA / MASS * t);
+        vector_t velocity = vec_add(terminal, vec_multiply(decay, relative));
+        vector_t centroid = vec_add(
+            vec_multiply(t, terminal),
+            vec_multiply(MASS / GAMMA * (1 - decay), relative)
+        );
+        assert(vec_isclose(body_get_velocity(body), velocity));
+        assert(vec_isclose(body_get_centroid(body), centroid));
+    }
+    body_free(body);
+}
+
 void test_body_remove() {
     list_t *shape = list_init(3, free);
     vector_t *v = malloc(sizeof(*v));
@@ -242,6 +281,87 @@ void test_body_info_freer() {
     body_free(body);
 }
 
+// Tests that interpolated poses move from the saved pose to the current one
+void test_body_interpolation() {
+    list_t *shape = list_init(4, free);
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, +1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, +1};
+    list_add(shape, v);
+    body_t *body = body_init(shape, 1, (rgb_color_t) {0, 0, 0});
+    assert(vec_equal(body_get_interpolated_centroid(body, 0.5), VEC_ZERO));
+    body_set_centroid(body, (vector_t) {4, 2});
+    body_save_pose(body);
+    body_set_centroid(body, (vector_t) {8, 6});
+    body_set_rotation(body, M_PI / 2);
+    assert(vec_isclose(body_get_interpolated_centroid(body, 0), (vector_t) {4, 2}));
+    assert(vec_isclose(body_get_interpolated_centroid(body, 0.25), (vector_t) {5, 3}));
+    assert(vec_isclose(body_get_interpolated_centroid(body, 1), (vector_t) {8, 6}));
+    assert(isclose(body_get_interpolated_orientation(body, 0.5), M_PI / 4));
+
+    // Halfway through, the square is rotated by 45 degrees about (6, 4)
+    list_t *interpolated = body_get_interpolated_shape(body, 0.5);
+    assert(list_size(interpolated) == 4);
+    assert(vec_isclose(
+        *(vector_t *) list_get(interpolated, 0),
+        (vector_t) {6, 4 - sqrt(2)}
+    ));
+    assert(vec_isclose(
+        *(vector_t *) list_get(interpolated, 1),
+        (vector_t) {6 + sqrt(2), 4}
+    ));
+    list_free(interpolated);
+    // The body itself is not moved
+    assert(vec_isclose(body_get_centroid(body), (vector_t) {8, 6}));
+    body_free(body);
+}
+
+// Tests that a body's bounding box follows it as it moves and rotates
+void test_body_bounds() {
+    list_t *shape = list_init(4, free);
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {-2, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+2, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+2, +1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {-2, +1};
+    list_add(shape, v);
+    body_t *body = body_init(shape, 1, (rgb_color_t) {0, 0, 0});
+    assert(body_get_bounds_policy(body) == BOUNDS_IGNORE);
+    aabb_t bounds = body_get_bounds(body);
+    assert(vec_equal(bounds.min, (vector_t) {-2, -1}));
+    assert(vec_equal(bounds.max, (vector_t) {2, 1}));
+
+    body_set_centroid(body, (vector_t) {3, -1});
+    body_set_velocity(body, (vector_t) {1, 0});
+    body_tick(body, 1);
+    bounds = body_get_bounds(body);
+    assert(vec_isclose(bounds.min, (vector_t) {2, -2}));
+    assert(vec_isclose(bounds.max, (vector_t) {6, 0}));
+
+    body_set_rotation(body, M_PI / 2);
+    bounds = body_get_bounds(body);
+    assert(vec_isclose(bounds.min, (vector_t) {3, -3}));
+    assert(vec_isclose(bounds.max, (vector_t) {5, 1}));
+
+    body_set_bounds_policy(body, BOUNDS_WRAP);
+    assert(body_get_bounds_policy(body) == BOUNDS_WRAP);
+    body_free(body);
+}
+
 int main(int argc, char *argv[]) {
     // Run all tests if there are no command-line arguments
     bool all_tests = argc == 1;
@@ -256,9 +376,12 @@ int main(int argc, char *argv[]) {
     DO_TEST(test_body_tick)
     DO_TEST(test_infinite_mass)
     DO_TEST(test_forces)
+    DO_TEST(test_body_tick_with_drag)
     DO_TEST(test_body_remove)
     DO_TEST(test_body_info)
     DO_TEST(test_body_info_freer)
+    DO_TEST(test_body_interpolation)
+    DO_TEST(test_body_bounds)
 
     puts("body_test PASS");
 }
@@ -0,0 +1,182 @@
+#include "field.h"
+#include "forces.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+list_t *make_shape() {
+    list_t *shape = list_init(4, free);
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, +1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, +1};
+    list_add(shape, v);
+    return shape;
+}
+
+// A linear field, which bilinear interpolation reproduces exactly
+vector_t linear_field(vector_t position, void *aux) {
+    int *calls = aux;
+    (*calls)++;
+    return (vector_t) {
+        2 * position.x + 3 * position.y + 1,
+        position.x - position.y
+    };
+}
+
+// Tests that sampling interpolates between grid points and clamps at edges
+void test_sample() {
+    const vector_t ORIGIN = {-5, 10};
+    int calls = 0;
+    field_t *field = field_init_from_func(ORIGIN, 0.5, 21, 11, \
+        linear_field, &calls);
+    assert(calls == 21 * 11);
+    assert(vec_isclose(field_get(field, 3, 4), linear_field(
+        (vector_t) {-3.5, 12}, &calls)));
+    for (int i = 0; i <= 40; i++) {
+        vector_t position = {ORIGIN.x + i * 0.25, ORIGIN.y + i * 0.123};
+        assert(vec_isclose(
+            field_sample(field, position),
+            linear_field(position, &calls)
+        ));
+    }
+    // The grid spans [-5, 5] x [10, 15]
+    assert(vec_isclose(
+        field_sample(field, (vector_t) {100, -100}),
+        linear_field((vector_t) {5, 10}, &calls)
+    ));
+    assert(vec_isclose(
+        field_sample(field, (vector_t) {-100, 13}),
+        linear_field((vector_t) {-5, 13}, &calls)
+    ));
+    field_set(field, 0, 0, (vector_t) {7, 8});
+    assert(vec_equal(field_sample(field, ORIGIN), (vector_t) {7, 8}));
+    field_free(field);
+
+    // A single grid point is a constant field
+    field = field_init(VEC_ZERO, 1, 1, 1);
+    field_set(field, 0, 0, (vector_t) {1, 2});
+    assert(vec_equal(field_sample(field, (vector_t) {3, -4}), (vector_t) {1, 2}));
+    field_free(field);
+}
+
+// Tests loading a field from a file
+void test_load() {
+    const char *PATH = "field_test.txt";
+    FILE *file = fopen(PATH, "w");
+    assert(file != NULL);
+    fprintf(file, "3 2 1 2 0.5\n");
+    fprintf(file, "0 0  1 0  2 0\n");
+    fprintf(file, "0 1  1 1  2 1\n");
+    fclose(file);
+    field_t *field = field_load(PATH);
+    assert(field != NULL);
+    assert(vec_equal(field_get(field, 2, 1), (vector_t) {2, 1}));
+    assert(vec_isclose(
+        field_sample(field, (vector_t) {1.25, 2.25}),
+        (vector_t) {0.5, 0.5}
+    ));
+    field_free(field);
+
+    file = fopen(PATH, "w");
+    assert(file != NULL);
+    fprintf(file, "3 2 1 2 0.5\n0 0 1 0\n");
+    fclose(file);
+    assert(field_load(PATH) == NULL);
+
+    // Grids whose number of components doesn't fit in a size_t
+    file = fopen(PATH, "w");
+    assert(file != NULL);
+    fprintf(file, "4294967296 4294967296 0 0 1\n0 0\n");
+    fclose(file);
+    assert(field_load(PATH) == NULL);
+    file = fopen(PATH, "w");
+    assert(file != NULL);
+    fprintf(file, "2305843009213693952 1 0 0 1\n0 0\n");
+    fclose(file);
+    assert(field_load(PATH) == NULL);
+    remove(PATH);
+    assert(field_load(PATH) == NULL);
+}
+
+// Tests that a force field pushes bodies by the field at their centroids,
+// skipping bodies with infinite mass when applied to the whole scene
+void test_field_force() {
+    const double M = 2;
+    const double DT = 1e-3;
+    int calls = 0;
+    field_t *field = field_init_from_func((vector_t) {-10, -10}, 1, 21, 21, \
+        linear_field, &calls);
+    scene_t *scene = scene_init();
+    body_t *bodies[3];
+    for (int i = 0; i < 3; i++) {
+        bodies[i] = body_init(make_shape(), i < 2 ? M : INFINITY, \
+            (rgb_color_t) {0, 0, 0});
+        body_set_centroid(bodies[i], (vector_t) {i * 1.5, -i * 0.7});
+        scene_add_body(scene, bodies[i]);
+    }
+    create_field_force(scene, field, NULL);
+    list_t *listed = list_init(1, NULL);
+    list_add(listed, bodies[1]);
+    create_field_force(scene, field, listed);
+    scene_tick(scene, DT);
+    for (int i = 0; i < 2; i++) {
+        vector_t force = linear_field((vector_t) {i * 1.5, -i * 0.7}, &calls);
+        // Body 1 is pushed by both force creators
+        vector_t expected = vec_multiply((i + 1) * DT / M, force);
+        assert(vec_isclose(body_get_velocity(bodies[i]), expected));
+    }
+    assert(vec_equal(body_get_velocity(bodies[2]), VEC_ZERO));
+    scene_free(scene);
+    field_free(field);
+}
+
+// Tests that a body in a uniform flow drifts up to the speed of the flow
+void test_flow_drag() {
+    const vector_t FLOW = {3, -1};
+    const double GAMMA = 2;
+    const double DT = 1e-3;
+    const int STEPS = 20000;
+    field_t *field = field_init(VEC_ZERO, 1, 2, 2);
+    for (size_t i = 0; i < 4; i++) {
+        field_set(field, i % 2, i / 2, FLOW);
+    }
+    scene_t *scene = scene_init();
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, body);
+    list_t *bodies = list_init(1, NULL);
+    list_add(bodies, body);
+    create_flow_drag(scene, field, GAMMA, bodies);
+    for (int i = 0; i < STEPS; i++) {
+        scene_tick(scene, DT);
+    }
+    assert(vec_within(1e-6, body_get_velocity(body), FLOW));
+    scene_free(scene);
+    field_free(field);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_sample)
+    DO_TEST(test_load)
+    DO_TEST(test_field_force)
+    DO_TEST(test_flow_drag)
+
+    puts("field_test PASS");
+}
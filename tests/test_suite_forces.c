@@ -153,6 +153,257 @@ void test_forces_removed() {
     scene_free(scene);
 }
 
+// Tests that bulk drag and scene drag match drag on individual bodies
+void test_bulk_drag() {
+    const double M = 2;
+    const double GAMMA = 0.5;
+    const double DT = 1e-4;
+    const int STEPS = 100000;
+    scene_t *single_scene = scene_init();
+    scene_t *bulk_scene = scene_init();
+    scene_t *all_scene = scene_init();
+    scene_t *folded_scene = scene_init();
+    scene_t *scenes[] = {single_scene, bulk_scene, all_scene, folded_scene};
+    list_t *bulk_bodies = list_init(3, NULL);
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 4; j++) {
+            body_t *body = body_init(make_shape(), M, (rgb_color_t) {0, 0, 0});
+            body_set_velocity(body, (vector_t) {i + 1, -i});
+            scene_add_body(scenes[j], body);
+        }
+        create_drag(single_scene, GAMMA, scene_get_body(single_scene, i));
+        list_add(bulk_bodies, scene_get_body(bulk_scene, i));
+    }
+    create_bulk_drag(bulk_scene, GAMMA, bulk_bodies);
+    create_bulk_drag(all_scene, GAMMA, NULL);
+    scene_set_drag(folded_scene, GAMMA);
+    for (int i = 0; i < STEPS; i++) {
+        for (int j = 0; j < 4; j++) {
+            scene_tick(scenes[j], DT);
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        vector_t expected = vec_multiply(
+            exp(-GAMMA / M * DT * STEPS),
+            (vector_t) {i + 1, -i}
+        );
+        assert(vec_equal(
+            body_get_velocity(scene_get_body(bulk_scene, i)),
+            body_get_velocity(scene_get_body(single_scene, i))
+        ));
+        assert(vec_equal(
+            body_get_velocity(scene_get_body(all_scene, i)),
+            body_get_velocity(scene_get_body(single_scene, i))
+        ));
+        assert(vec_within(1e-4,
+            body_get_velocity(scene_get_body(single_scene, i)), expected));
+        assert(vec_isclose(
+            body_get_velocity(scene_get_body(folded_scene, i)), expected));
+    }
+    for (int j = 0; j < 4; j++) {
+        scene_free(scenes[j]);
+    }
+}
+
+void count_custom_calls(void *aux) {
+    (*(int *) aux)++;
+}
+
+// Tests that built-in forces are stored by kind alongside force creators
+// and removed along with their bodies
+void test_typed_forces() {
+    scene_t *scene = scene_init();
+    body_t *body1 = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, body1);
+    body_t *body2 = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    body_set_centroid(body2, (vector_t) {10, 0});
+    scene_add_body(scene, body2);
+    body_t *body3 = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    body_set_centroid(body3, (vector_t) {0, 10});
+    scene_add_body(scene, body3);
+    create_newtonian_gravity(scene, 1, body1, body2);
+    create_newtonian_gravity(scene, 1, body2, body3);
+    create_spring(scene, 1, body1, body3);
+    create_drag(scene, 1, body2);
+    create_physics_collision(scene, 1, body1, body2);
+    int *calls = malloc(sizeof(*calls));
+    *calls = 0;
+    list_t *bodies = list_init(1, NULL);
+    list_add(bodies, body2);
+    scene_add_bodies_force_creator(scene, count_custom_calls, calls, bodies, NULL);
+    assert(scene_typed_forces(scene, FORCE_GRAVITY) == 2);
+    assert(scene_typed_forces(scene, FORCE_SPRING) == 1);
+    assert(scene_typed_forces(scene, FORCE_DRAG) == 1);
+    assert(scene_typed_forces(scene, FORCE_COLLISION) == 1);
+    scene_tick(scene, 1e-3);
+    assert(*calls == 1);
+
+    body_remove(body2);
+    scene_tick(scene, 1e-3);
+    assert(*calls == 2);
+    assert(scene_typed_forces(scene, FORCE_GRAVITY) == 0);
+    assert(scene_typed_forces(scene, FORCE_SPRING) == 1);
+    assert(scene_typed_forces(scene, FORCE_DRAG) == 0);
+    assert(scene_typed_forces(scene, FORCE_COLLISION) == 0);
+    scene_tick(scene, 1e-3);
+    assert(*calls == 2);
+    free(calls);
+    scene_free(scene);
+}
+
+void noop_force(void *aux) {}
+
+// Tests that removing bodies removes exactly the forces acting on them,
+// keeping each body's reverse index of forces consistent
+void test_force_reverse_index() {
+    const int N = 40;
+    scene_t *scene = scene_init();
+    body_t *bodies[N];
+    bool alive[N];
+    for (int i = 0; i < N; i++) {
+        bodies[i] = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(bodies[i], (vector_t) {10 * i, 0});
+        scene_add_body(scene, bodies[i]);
+        alive[i] = true;
+    }
+    for (int i = 0; i < N; i++) {
+        int j = (i + 1) % N;
+        create_spring(scene, 1, bodies[i], bodies[j]);
+        create_newtonian_gravity(scene, 1, bodies[i], bodies[(i + 7) % N]);
+        create_drag(scene, 1, bodies[i]);
+        list_t *pair = list_init(2, NULL);
+        list_add(pair, bodies[i]);
+        list_add(pair, bodies[j]);
+        scene_add_bodies_force_creator(scene, noop_force, NULL, pair, NULL);
+    }
+    // Each body has 2 springs, 2 gravity forces, a drag and 2 force creators
+    for (int i = 0; i < N; i++) {
+        assert(bodies[i]->force_ref_count == 7);
+    }
+    scene_tick(scene, 1e-3);
+    assert(scene_typed_forces(scene, FORCE_SPRING) == N);
+
+    int removals[] = {3, 4, 17, 0, 39, 20, 21, 22, 10};
+    for (size_t r = 0; r < sizeof(removals) / sizeof(*removals); r++) {
+        body_remove(bodies[removals[r]]);
+        alive[removals[r]] = false;
+        if (r % 2 == 0) {
+            scene_tick(scene, 1e-3);
+        }
+    }
+    scene_tick(scene, 1e-3);
+
+    size_t springs = 0, gravities = 0, drags = 0;
+    for (int i = 0; i < N; i++) {
+        if (!alive[i]) continue;
+        int next = (i + 1) % N, prev = (i + N - 1) % N;
+        int far = (i + 7) % N, near = (i + N - 7) % N;
+        size_t degree = 1 + 2 * alive[next] + 2 * alive[prev] +
+            alive[far] + alive[near];
+        assert(bodies[i]->force_ref_count == degree);
+        // Every reference to a force creator points at one acting on the body
+        for (size_t r = 0; r < bodies[i]->force_ref_count; r++) {
+            force_ref_t ref = bodies[i]->force_refs[r];
+            if (ref.kind == NUM_FORCE_KINDS) {
+                force_t *force = scene_get_force(scene, ref.index);
+                assert(!force_is_removed(force));
+            }
+        }
+        springs += alive[next];
+        gravities += alive[far];
+        drags++;
+    }
+    assert(scene_typed_forces(scene, FORCE_SPRING) == springs);
+    assert(scene_typed_forces(scene, FORCE_GRAVITY) == gravities);
+    assert(scene_typed_forces(scene, FORCE_DRAG) == drags);
+    assert(scene_bodies(scene) == drags);
+    scene_free(scene);
+}
+
+// Tests the reverse index of a force creator listing a body twice
+void test_repeated_force_bodies() {
+    scene_t *scene = scene_init();
+    body_t *a = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    body_t *b = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    body_t *c = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, a);
+    scene_add_body(scene, b);
+    scene_add_body(scene, c);
+    create_spring(scene, 1, a, c);
+    list_t *bodies = list_init(3, NULL);
+    list_add(bodies, a);
+    list_add(bodies, b);
+    list_add(bodies, a);
+    scene_add_bodies_force_creator(scene, noop_force, NULL, bodies, NULL);
+    assert(a->force_ref_count == 3);
+
+    // Removing the spring moves a's second reference to the creator
+    // into the spring's place
+    body_remove(c);
+    scene_tick(scene, 1e-3);
+    assert(a->force_ref_count == 2);
+    for (size_t r = 0; r < a->force_ref_count; r++) {
+        assert(a->force_refs[r].kind == NUM_FORCE_KINDS);
+    }
+    scene_remove_force(scene, 0);
+    assert(a->force_ref_count == 0);
+    assert(b->force_ref_count == 0);
+    scene_free(scene);
+}
+
+// Makes a scene with gravity between every pair of bodies,
+// springs along a chain of the bodies, and drag on each body
+scene_t *make_busy_scene(size_t n) {
+    scene_t *scene = scene_init();
+    for (size_t i = 0; i < n; i++) {
+        body_t *body = body_init(make_shape(), 1 + i % 3, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {(i % 7) * 10.0, (i / 7) * 10.0});
+        body_set_velocity(body, (vector_t) {i % 5, -(i % 3)});
+        scene_add_body(scene, body);
+    }
+    for (size_t i = 0; i < n; i++) {
+        body_t *body = scene_get_body(scene, i);
+        for (size_t j = i + 1; j < n; j++) {
+            create_newtonian_gravity(scene, 50, body, scene_get_body(scene, j));
+        }
+        if (i + 1 < n) {
+            create_spring(scene, 0.5, body, scene_get_body(scene, i + 1));
+        }
+        create_drag(scene, 0.1, body);
+    }
+    return scene;
+}
+
+// Tests that evaluating forces on several threads gives exactly
+// the same results as evaluating them on one thread
+void test_parallel_forces() {
+    const size_t N = 50;
+    const double DT = 1e-3;
+    const int STEPS = 200;
+    const size_t THREADS[] = {1, 2, 3, 8};
+    const size_t SCENES = sizeof(THREADS) / sizeof(THREADS[0]);
+    scene_t *scenes[SCENES];
+    for (size_t s = 0; s < SCENES; s++) {
+        scenes[s] = make_busy_scene(N);
+        scene_set_threads(scenes[s], THREADS[s]);
+    }
+    for (int i = 0; i < STEPS; i++) {
+        for (size_t s = 0; s < SCENES; s++) {
+            scene_tick(scenes[s], DT);
+        }
+        for (size_t j = 0; j < N; j++) {
+            vector_t expected = body_get_centroid(scene_get_body(scenes[0], j));
+            for (size_t s = 1; s < SCENES; s++) {
+                vector_t actual = body_get_centroid(scene_get_body(scenes[s], j));
+                assert(actual.x == expected.x && actual.y == expected.y);
+            }
+        }
+    }
+    for (size_t s = 0; s < SCENES; s++) {
+        scene_free(scenes[s]);
+    }
+}
+
 int main(int argc, char *argv[]) {
     // Run all tests if there are no command-line arguments
     bool all_tests = argc == 1;
@@ -166,6 +417,11 @@ int main(int argc, char *argv[]) {
     DO_TEST(test_energy_conservation)
     DO_TEST(test_collisions)
     DO_TEST(test_forces_removed)
+    DO_TEST(test_bulk_drag)
+    DO_TEST(test_typed_forces)
+    DO_TEST(test_force_reverse_index)
+    DO_TEST(test_repeated_force_bodies)
+    DO_TEST(test_parallel_forces)
 
     puts("forces_test PASS");
 }
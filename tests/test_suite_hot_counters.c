@@ -0,0 +1,113 @@
+// The library's own counts are only checked if it is built with counters
+#ifdef HOT_COUNTERS
+#define LIBRARY_COUNTERS
+#else
+#define HOT_COUNTERS
+#endif
+#include "hot_counters.h"
+#include "body.h"
+#include "collision.h"
+#include "test_util.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+const size_t THREADS = 4;
+const size_t COUNTS = 1000;
+
+list_t *make_square(vector_t centroid) {
+    list_t *shape = list_init(4, free);
+    const vector_t CORNERS[] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    for (size_t i = 0; i < 4; i++) {
+        vector_t *v = malloc(sizeof(*v));
+        *v = vec_add(centroid, CORNERS[i]);
+        list_add(shape, v);
+    }
+    return shape;
+}
+
+void *count_shape_copies(void *arg) {
+    for (size_t i = 0; i < COUNTS; i++) {
+        HOT_COUNT(HOT_SHAPE_COPIES, 1);
+    }
+    assert(hot_counter_get(HOT_SHAPE_COPIES) == COUNTS);
+    return NULL;
+}
+
+// Tests that each thread has its own counters, and the totals add them up
+void test_threads() {
+    hot_counters_reset_all();
+    HOT_COUNT(HOT_SHAPE_COPIES, 5);
+    HOT_COUNT(HOT_FREES, 2);
+    pthread_t threads[THREADS];
+    for (size_t t = 0; t < THREADS; t++) {
+        assert(pthread_create(&threads[t], NULL, count_shape_copies, NULL) == 0);
+    }
+    for (size_t t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    assert(hot_counter_get(HOT_SHAPE_COPIES) == 5);
+    assert(hot_counter_get(HOT_FREES) == 2);
+    assert(hot_counter_total(HOT_SHAPE_COPIES) == 5 + THREADS * COUNTS);
+
+    // Resetting one thread leaves the others' counts
+    hot_counters_reset();
+    assert(hot_counter_get(HOT_SHAPE_COPIES) == 0);
+    assert(hot_counter_get(HOT_FREES) == 0);
+    assert(hot_counter_total(HOT_SHAPE_COPIES) == THREADS * COUNTS);
+    hot_counters_reset_all();
+    assert(hot_counter_total(HOT_SHAPE_COPIES) == 0);
+}
+
+// Tests the counts made by the library, if it counts
+void test_library_counters() {
+#ifdef LIBRARY_COUNTERS
+    list_t *shape1 = make_square(VEC_ZERO);
+    list_t *shape2 = make_square((vector_t) {1, 0});
+    body_t *body = body_init(make_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    hot_counters_reset();
+
+    // list_init() allocates 2 blocks; 4 adds grow an empty list 3 times
+    list_t *list = list_init(0, free);
+    for (size_t i = 0; i < 4; i++) {
+        list_add(list, malloc(1));
+    }
+    assert(hot_counter_get(HOT_LIST_GROWS) == 3);
+    assert(hot_counter_get(HOT_ALLOCATIONS) == 2 + 3);
+    list_free(list);
+    assert(hot_counter_get(HOT_FREES) == 2 + 4);
+
+    hot_counters_reset();
+    assert(find_collision(shape1, shape2).collided);
+    assert(hot_counter_get(HOT_FIND_COLLISION_CALLS) == 1);
+    assert(hot_counter_get(HOT_SAT_AXES) == 8);
+    assert(hot_counter_get(HOT_PROJECTIONS) == 4 * 8);
+
+    hot_counters_reset();
+    vec_rotate((vector_t) {1, 0}, 1);
+    assert(hot_counter_get(HOT_TRIG_CALLS) == 4);
+    list_free(body_get_shape(body));
+    assert(hot_counter_get(HOT_SHAPE_COPIES) == 1);
+    assert(hot_counter_get(HOT_ALLOCATIONS) == 2 + 4);
+    assert(hot_counter_get(HOT_FREES) == 2 + 4);
+
+    list_free(shape1);
+    list_free(shape2);
+    body_free(body);
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_threads)
+    DO_TEST(test_library_counters)
+
+    puts("hot_counters_test PASS");
+}
@@ -0,0 +1,209 @@
+#include "pair_potential.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+list_t *make_shape() {
+    list_t *shape = list_init(4, free);
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, +1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, +1};
+    list_add(shape, v);
+    return shape;
+}
+
+typedef struct brute_force {
+    list_t *bodies;
+    double k;
+    double diameter;
+} brute_force_t;
+
+// Applies the soft repulsion by checking every pair of bodies
+void brute_force_creator(void *aux) {
+    brute_force_t *brute = aux;
+    size_t n = list_size(brute->bodies);
+    for (size_t i = 0; i < n; i++) {
+        body_t *body1 = list_get(brute->bodies, i);
+        for (size_t j = i + 1; j < n; j++) {
+            body_t *body2 = list_get(brute->bodies, j);
+            vector_t d = vec_subtract(
+                body_get_centroid(body2),
+                body_get_centroid(body1)
+            );
+            double distance = sqrt(vec_dot(d, d));
+            if (distance >= brute->diameter || distance == 0) {
+                continue;
+            }
+            double magnitude = brute->k * (brute->diameter - distance) / distance;
+            body_add_force(body1, vec_multiply(-magnitude, d));
+            body_add_force(body2, vec_multiply(magnitude, d));
+        }
+    }
+}
+
+// Makes a scene with a jittered grid of bodies with random velocities
+scene_t *make_gas(size_t side, double spacing, list_t *bodies) {
+    scene_t *scene = scene_init();
+    srand(7);
+    for (size_t i = 0; i < side * side; i++) {
+        body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+        double jitter_x = (double) rand() / RAND_MAX - 0.5;
+        double jitter_y = (double) rand() / RAND_MAX - 0.5;
+        body_set_centroid(body, (vector_t) {
+            (i % side) * spacing + jitter_x,
+            (i / side) * spacing + jitter_y
+        });
+        body_set_velocity(body, (vector_t) {
+            4 * ((double) rand() / RAND_MAX - 0.5),
+            4 * ((double) rand() / RAND_MAX - 0.5)
+        });
+        scene_add_body(scene, body);
+        list_add(bodies, body);
+    }
+    return scene;
+}
+
+// Tests that the neighbor lists give the same forces as checking every pair
+void test_matches_brute_force() {
+    const size_t SIDE = 12;
+    const double SPACING = 1.8;
+    const double K = 50;
+    const double DIAMETER = 2;
+    const double SKIN = 0.5;
+    const double DT = 1e-3;
+    const int STEPS = 2000;
+    list_t *bodies = list_init(SIDE * SIDE, NULL);
+    scene_t *scene = make_gas(SIDE, SPACING, bodies);
+    pair_potential_t *potential = create_soft_repulsion(
+        scene, bodies, K, DIAMETER, SKIN);
+    brute_force_t *brute = malloc(sizeof(*brute));
+    *brute = (brute_force_t) {list_init(SIDE * SIDE, NULL), K, DIAMETER};
+    scene_t *brute_scene = make_gas(SIDE, SPACING, brute->bodies);
+    scene_add_bodies_force_creator(brute_scene, brute_force_creator, brute, \
+        list_init(0, NULL), free);
+    for (int i = 0; i < STEPS; i++) {
+        scene_tick(scene, DT);
+        scene_tick(brute_scene, DT);
+    }
+    for (size_t i = 0; i < SIDE * SIDE; i++) {
+        assert(vec_within(1e-6,
+            body_get_centroid(scene_get_body(scene, i)),
+            body_get_centroid(scene_get_body(brute_scene, i))
+        ));
+    }
+    // The bodies moved further than the skin, but not every tick
+    assert(pair_potential_rebuilds(potential) > 1);
+    assert(pair_potential_rebuilds(potential) < STEPS / 10);
+    list_free(brute->bodies);
+    scene_free(scene);
+    scene_free(brute_scene);
+}
+
+// Tests that the neighbor list is not rebuilt while the bodies are still
+// and only holds the pairs within the cutoff plus the skin
+void test_still_bodies() {
+    const size_t SIDE = 10;
+    list_t *bodies = list_init(SIDE * SIDE, NULL);
+    scene_t *scene = scene_init();
+    for (size_t i = 0; i < SIDE * SIDE; i++) {
+        body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {(i % SIDE) * 3.0, (i / SIDE) * 3.0});
+        scene_add_body(scene, body);
+        list_add(bodies, body);
+    }
+    // Only horizontal and vertical neighbors are within 2 + 1.5
+    pair_potential_t *potential = create_soft_repulsion(scene, bodies, 1, 2, 1.5);
+    for (int i = 0; i < 100; i++) {
+        scene_tick(scene, 1e-2);
+    }
+    assert(pair_potential_rebuilds(potential) == 1);
+    assert(pair_potential_pairs(potential) == 2 * SIDE * (SIDE - 1));
+    for (size_t i = 0; i < SIDE * SIDE; i++) {
+        assert(vec_equal(
+            body_get_velocity(scene_get_body(scene, i)),
+            VEC_ZERO
+        ));
+    }
+    scene_free(scene);
+}
+
+void tick_scene(void *scene) {
+    scene_tick(scene, 1e-2);
+}
+
+// Tests that a body at an infinite or NaN position fails an assertion
+// instead of hanging or overflowing while the cells are sized
+void test_infinite_position() {
+    list_t *bodies = list_init(2, NULL);
+    scene_t *scene = scene_init();
+    for (size_t i = 0; i < 2; i++) {
+        body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {i * 3.0, 0});
+        scene_add_body(scene, body);
+        list_add(bodies, body);
+    }
+    create_soft_repulsion(scene, bodies, 1, 2, 1.5);
+    // The first tick always bins the bodies
+    body_set_centroid(scene_get_body(scene, 1), (vector_t) {INFINITY, 0});
+    assert(test_assert_fail(tick_scene, scene));
+    body_set_centroid(scene_get_body(scene, 1), (vector_t) {NAN, 0});
+    assert(test_assert_fail(tick_scene, scene));
+    scene_free(scene);
+}
+
+// Tests that Lennard-Jones bodies at the bottom of the well stay still,
+// and repel or attract when closer or further
+void test_lennard_jones() {
+    const double EPSILON = 2;
+    const double SIGMA = 1;
+    const double WELL = pow(2, 1.0 / 6) * SIGMA;
+    const double OFFSETS[] = {WELL, 0.9 * WELL, 1.5 * WELL, 3 * SIGMA};
+    const double SIGNS[] = {0, -1, 1, 0};
+    for (size_t t = 0; t < 4; t++) {
+        scene_t *scene = scene_init();
+        list_t *bodies = list_init(2, NULL);
+        for (int i = 0; i < 2; i++) {
+            body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+            body_set_centroid(body, (vector_t) {i * OFFSETS[t], 0});
+            scene_add_body(scene, body);
+            list_add(bodies, body);
+        }
+        create_lennard_jones(scene, bodies, EPSILON, SIGMA, 2.5 * SIGMA, 0.3);
+        scene_tick(scene, 1e-3);
+        double v = body_get_velocity(scene_get_body(scene, 0)).x;
+        if (SIGNS[t] == 0) {
+            assert(isclose(v, 0));
+        }
+        else {
+            assert(v * SIGNS[t] > 1e-6);
+        }
+        assert(isclose(v, -body_get_velocity(scene_get_body(scene, 1)).x));
+        scene_free(scene);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_matches_brute_force)
+    DO_TEST(test_still_bodies)
+    DO_TEST(test_lennard_jones)
+    DO_TEST(test_infinite_position)
+
+    puts("pair_potential_test PASS");
+}
@@ -0,0 +1,198 @@
+#include "pbd.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const vector_t GRAVITY = {0, -9.8};
+
+list_t *make_shape() {
+    list_t *shape = list_init(4, free);
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, +1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, +1};
+    list_add(shape, v);
+    return shape;
+}
+
+// Pulls every body in a list down with uniform gravity
+void uniform_gravity(void *aux) {
+    list_t *bodies = aux;
+    for (size_t i = 0; i < list_size(bodies); i++) {
+        body_t *body = list_get(bodies, i);
+        body_add_force(body, vec_multiply(body_get_mass(body), GRAVITY));
+    }
+}
+
+// Makes a scene with uniform gravity on a list of bodies
+scene_t *make_scene(list_t *bodies) {
+    scene_t *scene = scene_init();
+    scene_add_bodies_force_creator(scene, uniform_gravity, bodies, \
+        list_init(0, NULL), NULL);
+    return scene;
+}
+
+body_t *add_body(scene_t *scene, list_t *bodies, double mass, vector_t at) {
+    body_t *body = body_init(make_shape(), mass, (rgb_color_t) {0, 0, 0});
+    body_set_centroid(body, at);
+    scene_add_body(scene, body);
+    list_add(bodies, body);
+    return body;
+}
+
+double distance(body_t *body1, body_t *body2) {
+    vector_t d = vec_subtract(body_get_centroid(body1), body_get_centroid(body2));
+    return sqrt(vec_dot(d, d));
+}
+
+// Tests that a rope swinging from a pin keeps its length and stays bounded
+// at a time step far too large for stiff springs
+void test_rope() {
+    const size_t LINKS = 20;
+    const double LENGTH = 1;
+    const double DT = 1.0 / 30;
+    const int STEPS = 600;
+    list_t *bodies = list_init(LINKS + 1, NULL);
+    list_t *gravity_bodies = list_init(LINKS, NULL);
+    scene_t *scene = make_scene(gravity_bodies);
+    for (size_t i = 0; i <= LINKS; i++) {
+        body_t *body = add_body(scene, bodies, 1, (vector_t) {i * LENGTH, 0});
+        list_add(gravity_bodies, body);
+    }
+    pbd_t *pbd = create_pbd(scene, bodies, 20);
+    pbd_add_pin(pbd, 0, VEC_ZERO);
+    for (size_t i = 0; i < LINKS; i++) {
+        pbd_add_distance(pbd, i, i + 1, LENGTH, 1);
+    }
+    assert(pbd_constraints(pbd) == LINKS + 1);
+    for (int step = 0; step < STEPS; step++) {
+        scene_tick(scene, DT);
+        assert(vec_equal(body_get_centroid(list_get(bodies, 0)), VEC_ZERO));
+        for (size_t i = 1; i <= LINKS; i++) {
+            vector_t centroid = body_get_centroid(list_get(bodies, i));
+            assert(isfinite(centroid.x) && isfinite(centroid.y));
+            assert(sqrt(vec_dot(centroid, centroid)) < LINKS * LENGTH * 1.05);
+        }
+    }
+    for (size_t i = 0; i < LINKS; i++) {
+        double link = distance(list_get(bodies, i), list_get(bodies, i + 1));
+        assert(fabs(link - LENGTH) < 0.05 * LENGTH);
+    }
+    list_free(gravity_bodies);
+    scene_free(scene);
+}
+
+// Tests that a rigid distance constraint between free bodies
+// keeps their distance and conserves momentum
+void test_distance_momentum() {
+    const double DT = 0.1;
+    list_t *bodies = list_init(2, NULL);
+    scene_t *scene = scene_init();
+    body_t *light = add_body(scene, bodies, 1, (vector_t) {0, 0});
+    body_t *heavy = add_body(scene, bodies, 3, (vector_t) {4, 0});
+    body_set_velocity(light, (vector_t) {0, 5});
+    body_set_velocity(heavy, (vector_t) {1, -1});
+    vector_t momentum = vec_add(
+        vec_multiply(1, body_get_velocity(light)),
+        vec_multiply(3, body_get_velocity(heavy))
+    );
+    pbd_t *pbd = create_pbd(scene, bodies, 1);
+    pbd_add_distance(pbd, 0, 1, 4, 1);
+    for (int step = 0; step < 100; step++) {
+        scene_tick(scene, DT);
+        assert(isclose(distance(light, heavy), 4));
+        assert(vec_within(1e-9, momentum, vec_add(
+            vec_multiply(1, body_get_velocity(light)),
+            vec_multiply(3, body_get_velocity(heavy))
+        )));
+    }
+    scene_free(scene);
+}
+
+// Tests that distance constraints still hold exactly when the scene's drag
+// shortens how far the bodies travel each tick
+void test_drag() {
+    const double DT = 0.01;
+    list_t *bodies = list_init(2, NULL);
+    list_t *gravity_bodies = list_init(2, NULL);
+    scene_t *scene = make_scene(gravity_bodies);
+    scene_set_drag(scene, 5);
+    body_t *body1 = add_body(scene, bodies, 1, (vector_t) {0, 0});
+    body_t *body2 = add_body(scene, bodies, 2, (vector_t) {1, 0});
+    list_add(gravity_bodies, body1);
+    list_add(gravity_bodies, body2);
+    body_set_velocity(body1, (vector_t) {0, 3});
+    body_set_velocity(body2, (vector_t) {-2, 1});
+    pbd_t *pbd = create_pbd(scene, bodies, 1);
+    pbd_add_distance(pbd, 0, 1, 1, 1);
+    for (int step = 0; step < 100; step++) {
+        scene_tick(scene, DT);
+        assert(isclose(distance(body1, body2), 1));
+    }
+    scene_free(scene);
+    list_free(gravity_bodies);
+}
+
+// Tests that contacts and planes keep bodies apart but don't pull them together
+void test_contacts() {
+    const double DT = 1.0 / 30;
+    list_t *bodies = list_init(4, NULL);
+    list_t *gravity_bodies = list_init(3, NULL);
+    scene_t *scene = make_scene(gravity_bodies);
+    // A ball dropped onto another ball, which slides off it onto the ground
+    body_t *bottom = add_body(scene, bodies, 1, (vector_t) {0, 0});
+    body_t *top = add_body(scene, bodies, 2, (vector_t) {0.5, 6});
+    // A ball rolling along the ground into a wall
+    body_t *rolling = add_body(scene, bodies, 1, (vector_t) {-30, 0});
+    body_t *wall = add_body(scene, bodies, INFINITY, (vector_t) {-20, 1});
+    for (size_t i = 0; i < 3; i++) {
+        list_add(gravity_bodies, list_get(bodies, i));
+    }
+    body_set_velocity(rolling, (vector_t) {4, 0});
+    pbd_t *pbd = create_pbd(scene, bodies, 10);
+    pbd_add_contact(pbd, 0, 1, 2);
+    pbd_add_contact(pbd, 2, 3, 2);
+    for (size_t i = 0; i < 3; i++) {
+        pbd_add_plane(pbd, i, VEC_ZERO, (vector_t) {0, 2});
+    }
+    for (int step = 0; step < 300; step++) {
+        scene_tick(scene, DT);
+        for (size_t i = 0; i < 3; i++) {
+            assert(body_get_centroid(list_get(bodies, i)).y > -1e-9);
+        }
+        // Contacts that push bodies into planes are only solved approximately
+        assert(distance(bottom, top) > 2 - 1e-2);
+        assert(distance(rolling, wall) > 2 - 1e-2);
+        assert(vec_equal(body_get_centroid(wall), (vector_t) {-20, 1}));
+    }
+    // The top ball slid down to the ground, and the rolling ball stopped
+    assert(body_get_centroid(top).y < 1e-6);
+    assert(body_get_centroid(rolling).x < -20);
+    list_free(gravity_bodies);
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_rope)
+    DO_TEST(test_distance_momentum)
+    DO_TEST(test_drag)
+    DO_TEST(test_contacts)
+
+    puts("pbd_test PASS");
+}
@@ -0,0 +1,165 @@
+#include "render_buffer.h"
+#include "polygon.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+const vector_t VELOCITY = {2, -1};
+const double DT = 1e-2;
+
+list_t *make_square(vector_t centroid) {
+    list_t *shape = list_init(4, free);
+    const vector_t CORNERS[] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    for (size_t i = 0; i < 4; i++) {
+        vector_t *v = malloc(sizeof(*v));
+        *v = vec_add(centroid, CORNERS[i]);
+        list_add(shape, v);
+    }
+    return shape;
+}
+
+// Makes a scene of squares that all drift with the same velocity
+scene_t *make_drifting_scene(size_t n) {
+    scene_t *scene = scene_init();
+    for (size_t i = 0; i < n; i++) {
+        body_t *body = body_init(make_square((vector_t) {3 * i, 0}), 1, \
+            (rgb_color_t) {i % 2, 0, 0});
+        body_set_velocity(body, VELOCITY);
+        scene_add_body(scene, body);
+    }
+    return scene;
+}
+
+// Checks that every body in a frame is where it was after the same tick
+void check_frame(const render_frame_t *frame, size_t n) {
+    if (frame->sequence == 0) {
+        assert(frame->body_count == 0);
+        return;
+    }
+    assert(frame->body_count == n);
+    assert(frame->vertex_count == 4 * n);
+    vector_t drift = frame->bodies[0].centroid;
+    assert(vec_isclose(drift, vec_multiply(frame->sequence * DT, VELOCITY)));
+    for (size_t i = 0; i < n; i++) {
+        const render_body_t *body = &frame->bodies[i];
+        vector_t start = {3 * i, 0};
+        assert(vec_isclose(vec_subtract(body->centroid, start), drift));
+        assert(body->first_vertex == 4 * i && body->vertex_count == 4);
+        vector_t corner = frame->vertices[body->first_vertex];
+        assert(vec_isclose(vec_subtract(corner, body->centroid), \
+            (vector_t) {-1, -1}));
+        assert(body->color.r == i % 2);
+    }
+}
+
+// Tests that acquired frames hold the latest published tick
+// and stay the same until the next acquire
+void test_publish() {
+    const size_t N = 5;
+    render_buffer_t *buffer = render_buffer_init();
+    const render_frame_t *frame = render_buffer_acquire(buffer);
+    assert(frame->sequence == 0 && frame->body_count == 0);
+
+    scene_t *scene = make_drifting_scene(N);
+    scene_set_render_buffer(scene, buffer);
+    scene_tick(scene, DT);
+    frame = render_buffer_acquire(buffer);
+    assert(frame->sequence == 1);
+    check_frame(frame, N);
+    assert(frame->alpha == 1);
+
+    // Frames published before the next acquire are dropped,
+    // without changing the acquired frame
+    for (int i = 0; i < 3; i++) {
+        scene_tick(scene, DT);
+        assert(frame->sequence == 1);
+        check_frame(frame, N);
+    }
+    frame = render_buffer_acquire(buffer);
+    assert(frame->sequence == 4);
+    check_frame(frame, N);
+    assert(render_buffer_acquire(buffer) == frame);
+
+    // Added bodies show up in the next frame
+    body_t *body = body_init(make_square(VEC_ZERO), 1, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, body);
+    scene_tick(scene, DT);
+    frame = render_buffer_acquire(buffer);
+    assert(frame->body_count == N + 1 && frame->vertex_count == 4 * (N + 1));
+
+    // Fixed steps publish once per frame, with the scene's alpha
+    scene_step_fixed(scene, 2.5 * DT, DT, 8);
+    frame = render_buffer_acquire(buffer);
+    assert(frame->sequence == 6);
+    assert(fabs(frame->alpha - scene_get_alpha(scene)) < 1e-9);
+    assert(vec_isclose(frame->bodies[0].prev_centroid, \
+        vec_subtract(frame->bodies[0].centroid, vec_multiply(DT, VELOCITY))));
+
+    scene_free(scene);
+    render_buffer_free(buffer);
+}
+
+typedef struct renderer {
+    render_buffer_t *buffer;
+    size_t bodies;
+    atomic_bool stop;
+    size_t frames;
+} renderer_t;
+
+// Draws frames until told to stop, checking that each is consistent
+void *run_renderer(void *arg) {
+    renderer_t *renderer = arg;
+    size_t last = 0;
+    while (!atomic_load(&renderer->stop)) {
+        const render_frame_t *frame = render_buffer_acquire(renderer->buffer);
+        check_frame(frame, renderer->bodies);
+        assert(frame->sequence >= last);
+        if (frame->sequence > last) {
+            renderer->frames++;
+        }
+        last = frame->sequence;
+    }
+    return NULL;
+}
+
+// Tests that a thread drawing frames while the scene is ticked
+// only ever sees whole ticks
+void test_concurrent() {
+    const size_t N = 200;
+    const int STEPS = 2000;
+    render_buffer_t *buffer = render_buffer_init();
+    scene_t *scene = make_drifting_scene(N);
+    scene_set_render_buffer(scene, buffer);
+    renderer_t renderer = {buffer, N, false, 0};
+    pthread_t id;
+    assert(pthread_create(&id, NULL, run_renderer, &renderer) == 0);
+    for (int i = 0; i < STEPS; i++) {
+        scene_tick(scene, DT);
+    }
+    atomic_store(&renderer.stop, true);
+    pthread_join(id, NULL);
+    assert(renderer.frames <= (size_t) STEPS);
+    const render_frame_t *frame = render_buffer_acquire(buffer);
+    assert(frame->sequence == (size_t) STEPS);
+    check_frame(frame, N);
+    scene_free(scene);
+    render_buffer_free(buffer);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_publish)
+    DO_TEST(test_concurrent)
+
+    puts("render_buffer_test PASS");
+}
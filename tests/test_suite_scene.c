@@ -1,7 +1,8 @@
-#include "scene.h"
+#include "forces.h"
 #include "test_util.h"
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdlib.h>
 
 void scene_get_first(void *scene) {
@@ -229,20 +230,652 @@ void test_reaping() {
     scene_free(scene);
 }
 
+// Removes the bodies with an odd mass
+bool has_odd_mass(body_t *body, void *aux) {
+    size_t *calls = aux;
+    (*calls)++;
+    return (size_t) body_get_mass(body) % 2 == 1;
+}
+
+void get_second_force(void *scene) {
+    scene_get_force(scene, 1);
+}
+
+void pair_force(void *aux) {
+    list_t *bodies = aux;
+    body_add_force(list_get(bodies, 0), (vector_t) {1, 0});
+    body_add_force(list_get(bodies, 1), (vector_t) {-1, 0});
+}
+
+// Tests that bulk removal keeps the remaining bodies in order
+// and removes the forces on the removed bodies
+void test_remove_if() {
+    const size_t N = 100000;
+    scene_t *scene = scene_init();
+    for (size_t i = 0; i < N; i++) {
+        scene_add_body(scene, body_init(make_shape(), i + 1, (rgb_color_t) {0, 0, 0}));
+    }
+    // Forces between bodies 2k and 2k + 1, which have masses 2k + 1 and 2k + 2
+    for (size_t i = 0; i + 1 < 100; i += 2) {
+        list_t *bodies = list_init(2, NULL);
+        list_add(bodies, scene_get_body(scene, i));
+        list_add(bodies, scene_get_body(scene, i + 1));
+        list_t *aux = list_init(2, NULL);
+        list_add(aux, scene_get_body(scene, i));
+        list_add(aux, scene_get_body(scene, i + 1));
+        scene_add_bodies_force_creator(scene, pair_force, aux, bodies, \
+            (free_func_t) list_free);
+    }
+    // A force only on bodies that stay
+    list_t *kept = list_init(2, NULL);
+    list_add(kept, scene_get_body(scene, 1));
+    list_add(kept, scene_get_body(scene, 3));
+    list_t *kept_aux = list_init(2, NULL);
+    list_add(kept_aux, scene_get_body(scene, 1));
+    list_add(kept_aux, scene_get_body(scene, 3));
+    scene_add_bodies_force_creator(scene, pair_force, kept_aux, kept, \
+        (free_func_t) list_free);
+
+    size_t calls = 0;
+    assert(scene_remove_if(scene, has_odd_mass, &calls) == N / 2);
+    assert(calls == N);
+    assert(scene_bodies(scene) == N / 2);
+    for (size_t i = 0; i < N / 2; i++) {
+        assert(body_get_mass(scene_get_body(scene, i)) == 2 * (i + 1));
+    }
+    assert(scene_get_force(scene, 0) != NULL);
+    assert(test_assert_fail(get_second_force, scene));
+
+    calls = 0;
+    // The removed bodies were freed, so only the rest are visited
+    assert(scene_remove_if(scene, has_odd_mass, &calls) == 0);
+    assert(calls == N / 2);
+    scene_free(scene);
+}
+
+// Tests that fixed steps carry leftover time between frames
+// and drop time beyond the substep limit
+void test_step_fixed() {
+    const double DT = 0.25;
+    const vector_t VELOCITY = {4, 0};
+    scene_t *scene = scene_init();
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    body_set_velocity(body, VELOCITY);
+    scene_add_body(scene, body);
+
+    assert(scene_step_fixed(scene, 0.125, DT, 4) == 0);
+    assert(scene_get_alpha(scene) == 0.5);
+    assert(vec_equal(body_get_centroid(body), VEC_ZERO));
+    assert(scene_step_fixed(scene, 0.5, DT, 4) == 2);
+    assert(scene_get_alpha(scene) == 0.5);
+    assert(vec_isclose(body_get_centroid(body), (vector_t) {2, 0}));
+    vector_t drawn = body_get_interpolated_centroid(body, scene_get_alpha(scene));
+    assert(vec_isclose(drawn, (vector_t) {1.5, 0}));
+
+    // A long frame runs only 4 steps, and the time behind is dropped
+    assert(scene_step_fixed(scene, 10.0625, DT, 4) == 4);
+    assert(vec_isclose(body_get_centroid(body), (vector_t) {6, 0}));
+    assert(scene_get_alpha(scene) == 0.75);
+    assert(scene_step_fixed(scene, 0.0625, DT, 4) == 1);
+    assert(scene_get_alpha(scene) == 0);
+    assert(scene_get_dt(scene) == DT);
+    scene_free(scene);
+}
+
+// Makes a scene with a row of overlapping bodies
+// that collide with their neighbors and feel drag
+scene_t *make_crowded_scene(size_t n) {
+    scene_t *scene = scene_init();
+    scene_set_drag(scene, 0.5);
+    for (size_t i = 0; i < n; i++) {
+        body_t *body = body_init(make_shape(), 1 + i % 4, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {i * 1.9, (i % 3) * 0.5});
+        body_set_velocity(body, (vector_t) {(int) (i % 7) - 3, i % 2});
+        scene_add_body(scene, body);
+        if (i > 0) {
+            create_physics_collision(scene, 0.8, scene_get_body(scene, i - 1), body);
+        }
+    }
+    return scene;
+}
+
+// Tests that checking collisions and ticking bodies on several threads,
+// with the scene's own pool or one shared with another scene,
+// gives exactly the same results as one thread
+void test_parallel_tick() {
+    const size_t N = 1500;
+    const double DT = 1e-2;
+    const int STEPS = 50;
+    const size_t SCENES = 4;
+    scene_t *scenes[SCENES];
+    for (size_t s = 0; s < SCENES; s++) {
+        scenes[s] = make_crowded_scene(N);
+    }
+    scene_set_threads(scenes[1], 3);
+    worker_pool_t *pool = worker_pool_init(4);
+    scene_set_pool(scenes[2], pool);
+    scene_set_pool(scenes[3], pool);
+    for (int i = 0; i < STEPS; i++) {
+        for (size_t s = 0; s < SCENES; s++) {
+            scene_tick(scenes[s], DT);
+        }
+        for (size_t j = 0; j < N; j++) {
+            body_t *body = scene_get_body(scenes[0], j);
+            for (size_t s = 1; s < SCENES; s++) {
+                body_t *other = scene_get_body(scenes[s], j);
+                assert(vec_equal(body_get_centroid(other), body_get_centroid(body)));
+                assert(vec_equal(body_get_velocity(other), body_get_velocity(body)));
+            }
+        }
+    }
+    for (size_t s = 0; s < SCENES; s++) {
+        scene_free(scenes[s]);
+    }
+    worker_pool_free(pool);
+}
+
+// Gets every body's centroid and velocity, to compare scenes exactly
+vector_t *record_bodies(scene_t *scene) {
+    size_t n = scene_bodies(scene);
+    vector_t *state = malloc(2 * n * sizeof(vector_t));
+    for (size_t i = 0; i < n; i++) {
+        state[2 * i] = body_get_centroid(scene_get_body(scene, i));
+        state[2 * i + 1] = body_get_velocity(scene_get_body(scene, i));
+    }
+    return state;
+}
+
+// Tests that restoring a snapshot rewinds the scene exactly,
+// so stepping ahead again repeats the same ticks
+void test_snapshot() {
+    const size_t N = 200;
+    const double DT = 1e-2;
+    const int STEPS = 40;
+    scene_t *scene = make_crowded_scene(N);
+    for (size_t i = 0; i + 7 < N; i += 5) {
+        create_spring(scene, 2, scene_get_body(scene, i), \
+            scene_get_body(scene, i + 7));
+    }
+    for (int i = 0; i < STEPS; i++) {
+        scene_tick(scene, DT);
+    }
+    scene_snapshot_t *snapshot = scene_snapshot_init();
+    scene_snapshot(scene, snapshot);
+    assert(scene_snapshot_size(snapshot) > N * 4 * sizeof(vector_t));
+    for (int i = 0; i < STEPS; i++) {
+        scene_tick(scene, DT);
+    }
+    vector_t *expected = record_bodies(scene);
+
+    for (int attempt = 0; attempt < 3; attempt++) {
+        assert(scene_restore(scene, snapshot));
+        // A removal that is rewound never happens
+        body_remove(scene_get_body(scene, 3));
+        assert(scene_restore(scene, snapshot));
+        assert(!body_is_removed(scene_get_body(scene, 3)));
+        for (int i = 0; i < STEPS; i++) {
+            scene_tick(scene, DT);
+        }
+        assert(scene_bodies(scene) == N);
+        vector_t *actual = record_bodies(scene);
+        for (size_t j = 0; j < 2 * N; j++) {
+            assert(vec_equal(actual[j], expected[j]));
+        }
+        free(actual);
+    }
+
+    // Snapshots can't be restored across added or removed bodies
+    body_remove(scene_get_body(scene, 0));
+    scene_tick(scene, DT);
+    assert(!scene_restore(scene, snapshot));
+    scene_snapshot(scene, snapshot);
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, body);
+    assert(!scene_restore(scene, snapshot));
+    free(expected);
+    scene_snapshot_free(snapshot);
+    scene_free(scene);
+}
+
+// Ticks each scene in an array of forks
+void tick_forks(void *aux, size_t start, size_t end) {
+    scene_t **forks = aux;
+    for (size_t f = start; f < end; f++) {
+        for (int i = 0; i < 40; i++) {
+            scene_tick(forks[f], 1e-2);
+        }
+    }
+}
+
+// Copies the body a ball_gravity-style force creator pulls on
+void *copy_pulled_body(void *aux, scene_t *fork, list_t *bodies) {
+    return list_get(bodies, 0);
+}
+
+void free_scene(void *scene) {
+    scene_free(scene);
+}
+
+void noop_force(void *aux) {}
+
+// Tests that forks step exactly like the scene they were forked from,
+// sharing static vertices and not affecting each other
+void test_fork() {
+    const size_t N = 300;
+    const size_t FORKS = 6;
+    scene_t *scene = make_crowded_scene(N);
+    body_t *floor = body_init(make_shape(), INFINITY, (rgb_color_t) {0, 0, 0});
+    body_set_centroid(floor, (vector_t) {100, -1.5});
+    scene_add_body(scene, floor);
+    create_physics_collision(scene, 0.5, scene_get_body(scene, 50), floor);
+    create_bulk_drag(scene, 0.1, NULL);
+    for (int i = 0; i < 20; i++) {
+        scene_tick(scene, 1e-2);
+    }
+
+    scene_t *forks[FORKS];
+    for (size_t f = 0; f < FORKS; f++) {
+        forks[f] = scene_fork(scene);
+        assert(forks[f] != NULL);
+        assert(scene_bodies(forks[f]) == N + 1);
+        assert(scene_get_body(forks[f], N)->shape == floor->shape);
+        assert(scene_lookup(forks[f], scene_get_handle(scene, floor)) == \
+            scene_get_body(forks[f], N));
+    }
+    // Changing one fork doesn't change the others
+    body_remove(scene_get_body(forks[0], 0));
+    body_set_velocity(scene_get_body(forks[1], 5), (vector_t) {50, 0});
+    worker_pool_t *pool = worker_pool_init(3);
+    worker_pool_run(pool, tick_forks, forks, FORKS);
+    worker_pool_free(pool);
+    tick_forks(&scene, 0, 1);
+
+    assert(scene_bodies(forks[0]) == N);
+    assert(scene_bodies(scene) == N + 1);
+    assert(!vec_equal(body_get_centroid(scene_get_body(forks[1], 5)), \
+        body_get_centroid(scene_get_body(scene, 5))));
+    for (size_t f = 2; f < FORKS; f++) {
+        for (size_t j = 0; j <= N; j++) {
+            body_t *body = scene_get_body(scene, j);
+            body_t *copy = scene_get_body(forks[f], j);
+            assert(vec_equal(body_get_centroid(copy), body_get_centroid(body)));
+            assert(vec_equal(body_get_velocity(copy), body_get_velocity(body)));
+        }
+        // The floor never moved, so its vertices were never copied
+        assert(scene_get_body(forks[f], N)->shape == floor->shape);
+        assert(scene_get_body(forks[f], 0)->shape != \
+            scene_get_body(scene, 0)->shape);
+    }
+    // The forks borrow the scene's info, so must be freed first
+    assert(test_assert_fail(free_scene, scene));
+    for (size_t f = 0; f < FORKS; f++) {
+        scene_free(forks[f]);
+    }
+    scene_free(scene);
+
+    // A force creator's aux can only be forked by its copier
+    scene = make_crowded_scene(2);
+    list_t *bodies = list_init(1, NULL);
+    list_add(bodies, scene_get_body(scene, 0));
+    scene_add_bodies_force_creator(scene, noop_force, scene_get_body(scene, 0), \
+        bodies, NULL);
+    assert(scene_fork(scene) == NULL);
+    scene_set_force_copier(scene, copy_pulled_body);
+    scene_t *fork = scene_fork(scene);
+    assert(fork != NULL);
+    scene_tick(fork, 1e-2);
+    scene_free(fork);
+    scene_free(scene);
+}
+
+// Gets a handle to a body that isn't in the scene, which should fail
+void get_foreign_handle(void *scene) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    scene_get_handle(scene, body);
+}
+
+// Tests that handles keep referring to the same bodies
+// as other bodies are removed, and stop referring to removed bodies
+void test_handles() {
+    const size_t N = 1000;
+    scene_t *scene = scene_init();
+    body_handle_t handles[N];
+    for (size_t i = 0; i < N; i++) {
+        body_t *body = body_init(make_shape(), i + 1, (rgb_color_t) {0, 0, 0});
+        scene_add_body(scene, body);
+        handles[i] = scene_get_handle(scene, body);
+        assert(scene_lookup(scene, handles[i]) == body);
+    }
+    assert(!scene_handle_valid(scene, (body_handle_t) {0, 0}));
+    assert(!scene_handle_valid(scene, (body_handle_t) {N, 1}));
+    assert(test_assert_fail(get_foreign_handle, scene));
+
+    // Removed bodies are invalid at once, before the scene is ticked
+    for (size_t i = 0; i < N; i += 3) {
+        assert(scene_remove_handle(scene, handles[i]));
+        assert(!scene_handle_valid(scene, handles[i]));
+        assert(!scene_remove_handle(scene, handles[i]));
+    }
+    scene_tick(scene, 1);
+    assert(scene_bodies(scene) == N - (N + 2) / 3);
+    for (size_t i = 0; i < N; i++) {
+        body_t *body = scene_lookup(scene, handles[i]);
+        if (i % 3 == 0) {
+            assert(body == NULL);
+        }
+        else {
+            assert(body_get_mass(body) == i + 1);
+            assert(scene_get_handle(scene, body).index == handles[i].index);
+        }
+    }
+
+    // Freed slots are reused, without reviving the old handles
+    body_t *body = body_init(make_shape(), 0.5, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, body);
+    body_handle_t handle = scene_get_handle(scene, body);
+    assert(handle.index % 3 == 0 && handle.index < N);
+    assert(scene_lookup(scene, handle) == body);
+    assert(!scene_handle_valid(scene, handles[handle.index]));
+    scene_free(scene);
+}
+
+typedef struct spawner {
+    scene_t *scene;
+    worker_pool_t *pool;
+    size_t spawned;
+} spawner_t;
+
+// Adds a body with a collision with body 0 for each index,
+// and removes the bodies spawned by the last tick
+void spawn_task(void *aux, size_t start, size_t end) {
+    spawner_t *spawner = aux;
+    for (size_t i = start; i < end; i++) {
+        body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {100 + 3 * i, 0});
+        scene_add_body(spawner->scene, body);
+        create_physics_collision(spawner->scene, 1, \
+            scene_get_body(spawner->scene, 0), body);
+        body_handle_t old = scene_get_handle(spawner->scene, \
+            scene_get_body(spawner->scene, 1 + i));
+        assert(scene_remove_handle(spawner->scene, old));
+    }
+}
+
+// Spawns bodies from every thread of the pool in the middle of a tick
+void spawn_bodies(void *aux) {
+    spawner_t *spawner = aux;
+    size_t bodies = scene_bodies(spawner->scene);
+    size_t collisions = scene_typed_forces(spawner->scene, FORCE_COLLISION);
+    worker_pool_run(spawner->pool, spawn_task, spawner, spawner->spawned);
+    // Nothing changes until every callback is done
+    assert(scene_bodies(spawner->scene) == bodies);
+    assert(scene_typed_forces(spawner->scene, FORCE_COLLISION) == collisions);
+}
+
+// Tests that bodies and forces added and removed during a tick,
+// including from several threads at once, are applied after the callbacks
+void test_deferred_commands() {
+    const size_t SPAWNED = 500;
+    scene_t *scene = scene_init();
+    worker_pool_t *pool = worker_pool_init(4);
+    scene_set_pool(scene, pool);
+    for (size_t i = 0; i <= SPAWNED; i++) {
+        body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {-3.0 * i, 0});
+        scene_add_body(scene, body);
+    }
+    spawner_t spawner = {scene, pool, SPAWNED};
+    list_t *bodies = list_init(1, NULL);
+    list_add(bodies, scene_get_body(scene, 0));
+    scene_add_bodies_force_creator(scene, spawn_bodies, &spawner, bodies, NULL);
+    for (int tick = 0; tick < 3; tick++) {
+        scene_tick(scene, 1e-2);
+        // The spawned bodies and their collisions replace the removed ones
+        assert(scene_bodies(scene) == SPAWNED + 1);
+        assert(scene_typed_forces(scene, FORCE_COLLISION) == SPAWNED);
+        for (size_t i = 1; i <= SPAWNED; i++) {
+            body_t *body = scene_get_body(scene, i);
+            assert(body_get_centroid(body).x >= 100);
+            assert(scene_handle_valid(scene, scene_get_handle(scene, body)));
+        }
+    }
+    scene_free(scene);
+    worker_pool_free(pool);
+}
+
+// Makes a scene that spawns bodies from every thread of a pool each tick
+scene_t *make_spawning_scene(spawner_t *spawner, worker_pool_t *pool, \
+    size_t spawned) {
+    scene_t *scene = scene_init();
+    scene_set_pool(scene, pool);
+    for (size_t i = 0; i <= spawned; i++) {
+        body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {-3.0 * i, 0});
+        scene_add_body(scene, body);
+    }
+    *spawner = (spawner_t) {scene, pool, spawned};
+    list_t *bodies = list_init(1, NULL);
+    list_add(bodies, scene_get_body(scene, 0));
+    scene_add_bodies_force_creator(scene, spawn_bodies, spawner, bodies, NULL);
+    return scene;
+}
+
+void *tick_spawning_scene(void *scene) {
+    for (int tick = 0; tick < 20; tick++) {
+        scene_tick(scene, 1e-2);
+    }
+    return NULL;
+}
+
+// Tests that scenes sharing a pool can be ticked from different threads,
+// each of which may run the other's callbacks while waiting for its own
+void test_shared_pool_commands() {
+    const size_t SPAWNED = 500;
+    worker_pool_t *pool = worker_pool_init(4);
+    spawner_t spawners[2];
+    scene_t *scenes[2];
+    pthread_t threads[2];
+    for (size_t s = 0; s < 2; s++) {
+        scenes[s] = make_spawning_scene(&spawners[s], pool, SPAWNED);
+    }
+    for (size_t s = 0; s < 2; s++) {
+        pthread_create(&threads[s], NULL, tick_spawning_scene, scenes[s]);
+    }
+    for (size_t s = 0; s < 2; s++) {
+        pthread_join(threads[s], NULL);
+        assert(scene_bodies(scenes[s]) == SPAWNED + 1);
+        assert(scene_typed_forces(scenes[s], FORCE_COLLISION) == SPAWNED);
+        scene_free(scenes[s]);
+    }
+    worker_pool_free(pool);
+}
+
+typedef struct bounds_log {
+    size_t calls;
+    body_t *body;
+} bounds_log_t;
+
+void log_out_of_bounds(scene_t *scene, body_t *body, void *aux) {
+    bounds_log_t *log = aux;
+    log->calls++;
+    log->body = body;
+    // The handler is free to move the body
+    body_set_centroid(body, (vector_t) {5, 5});
+    body_set_velocity(body, VEC_ZERO);
+}
+
+body_t *add_moving_body(scene_t *scene, bounds_policy_t policy, vector_t v) {
+    body_t *body = body_init(make_shape(), 1, (rgb_color_t) {0, 0, 0});
+    body_set_centroid(body, (vector_t) {5, 5});
+    body_set_velocity(body, v);
+    body_set_bounds_policy(body, policy);
+    scene_add_body(scene, body);
+    return body;
+}
+
+// Tests each policy for bodies leaving a scene's world bounds
+void test_world_bounds() {
+    scene_t *scene = scene_init();
+    bounds_log_t log = {0, NULL};
+    scene_set_bounds(scene, (aabb_t) {{0, 0}, {10, 10}}, log_out_of_bounds, \
+        &log);
+    body_t *ignored = add_moving_body(scene, BOUNDS_IGNORE, (vector_t) {100, 0});
+    body_t *removed = add_moving_body(scene, BOUNDS_REMOVE, (vector_t) {100, 0});
+    body_t *clamped = add_moving_body(scene, BOUNDS_CLAMP, (vector_t) {-100, 1});
+    body_t *wrapped = add_moving_body(scene, BOUNDS_WRAP, (vector_t) {100, 0});
+    body_t *called = add_moving_body(scene, BOUNDS_CALLBACK, (vector_t) {0, -100});
+    // Partly outside isn't outside
+    body_t *edge = add_moving_body(scene, BOUNDS_REMOVE, (vector_t) {50, 0});
+    body_handle_t removed_handle = scene_get_handle(scene, removed);
+    body_handle_t edge_handle = scene_get_handle(scene, edge);
+    scene_tick(scene, 0.1);
+
+    // Removed bodies are gone by the end of the tick
+    assert(scene_bodies(scene) == 5);
+    assert(vec_isclose(body_get_centroid(ignored), (vector_t) {15, 5}));
+    assert(!scene_handle_valid(scene, removed_handle));
+    assert(scene_handle_valid(scene, edge_handle));
+    // The clamped body only loses its velocity out of the bounds
+    assert(vec_isclose(body_get_centroid(clamped), (vector_t) {1, 5.1}));
+    assert(vec_isclose(body_get_velocity(clamped), (vector_t) {0, 1}));
+    // The wrapped body overshot the right edge by 4, so is 4 past the left
+    aabb_t bounds = body_get_bounds(wrapped);
+    assert(vec_isclose(bounds.max, (vector_t) {4, 6}));
+    assert(vec_isclose(body_get_velocity(wrapped), (vector_t) {100, 0}));
+    assert(log.calls == 1 && log.body == called);
+    assert(vec_isclose(body_get_centroid(called), (vector_t) {5, 5}));
+
+    scene_tick(scene, 0.1);
+    assert(scene_bodies(scene) == 4);
+    assert(!scene_handle_valid(scene, edge_handle));
+    assert(log.calls == 1);
+
+    scene_clear_bounds(scene);
+    body_set_velocity(called, (vector_t) {0, -100});
+    scene_tick(scene, 0.1);
+    assert(log.calls == 1);
+    assert(vec_isclose(body_get_centroid(called), (vector_t) {5, -5}));
+    scene_free(scene);
+}
+
+// Tests that bounds are enforced the same way when integration is split
+void test_parallel_world_bounds() {
+    const size_t N = 3000;
+    scene_t *scene = scene_init();
+    scene_set_threads(scene, 4);
+    bounds_log_t log = {0, NULL};
+    scene_set_bounds(scene, (aabb_t) {{0, 0}, {10, 10}}, log_out_of_bounds, \
+        &log);
+    for (size_t i = 0; i < N; i++) {
+        bounds_policy_t policy = i % 3 == 0 ? BOUNDS_REMOVE : \
+            i % 3 == 1 ? BOUNDS_CALLBACK : BOUNDS_WRAP;
+        add_moving_body(scene, policy, (vector_t) {0, 100});
+    }
+    scene_tick(scene, 0.1);
+    assert(log.calls == N / 3);
+    assert(scene_bodies(scene) == N - N / 3);
+    for (size_t i = 0; i < N - N / 3; i++) {
+        body_t *body = scene_get_body(scene, i);
+        // The remaining bodies keep their order, alternating policies
+        bool wrapped = i % 2 == 1;
+        assert(body_get_bounds_policy(body) == \
+            (wrapped ? BOUNDS_WRAP : BOUNDS_CALLBACK));
+        // Wrapped bodies overshot the top by 4, so are 4 past the bottom
+        assert(vec_isclose(body_get_centroid(body), \
+            (vector_t) {5, wrapped ? 3 : 5}));
+    }
+    scene_free(scene);
+}
+
+typedef struct remover {
+    scene_t *scene;
+    size_t calls;
+} remover_t;
+
+// Removes the bodies with an odd mass from a collision handler
+void remove_on_collision(body_t *body1, body_t *body2, vector_t axis, \
+    void *aux) {
+    remover_t *remover = aux;
+    scene_remove_if(remover->scene, has_odd_mass, &remover->calls);
+}
+
+// Removes the bodies with an odd mass from a bounds handler
+void remove_out_of_bounds(scene_t *scene, body_t *body, void *aux) {
+    remover_t *remover = aux;
+    scene_remove_if(scene, has_odd_mass, &remover->calls);
+}
+
+// Tests that bulk removal from the callbacks of a tick
+// leaves the bodies in place until the tick is done with them
+void test_remove_if_in_tick() {
+    const size_t N = 20;
+    scene_t *scene = scene_init();
+    remover_t remover = {scene, 0};
+    for (size_t i = 0; i < N; i++) {
+        body_t *body = body_init(make_shape(), i + 1, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {i * 1.9, 0});
+        scene_add_body(scene, body);
+        if (i > 0) {
+            create_collision(scene, scene_get_body(scene, i - 1), body, \
+                remove_on_collision, &remover, NULL);
+        }
+    }
+    scene_tick(scene, 1e-3);
+    assert(remover.calls > 0);
+    assert(scene_bodies(scene) == N / 2);
+    assert(scene_typed_forces(scene, FORCE_COLLISION) == 0);
+    for (size_t i = 0; i < N / 2; i++) {
+        assert(body_get_mass(scene_get_body(scene, i)) == 2 * (i + 1));
+    }
+    scene_free(scene);
+
+    // Every body leaves the bounds, so the handler still has calls queued
+    // for the bodies removed by its first call
+    scene = scene_init();
+    remover = (remover_t) {scene, 0};
+    scene_set_bounds(scene, (aabb_t) {{0, 0}, {10, 10}}, remove_out_of_bounds, \
+        &remover);
+    for (size_t i = 0; i < N; i++) {
+        body_t *body = body_init(make_shape(), i + 1, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {5, 5});
+        body_set_velocity(body, (vector_t) {100, 0});
+        body_set_bounds_policy(body, BOUNDS_CALLBACK);
+        scene_add_body(scene, body);
+    }
+    scene_tick(scene, 0.1);
+    assert(remover.calls == N * N);
+    assert(scene_bodies(scene) == N / 2);
+    for (size_t i = 0; i < N / 2; i++) {
+        assert(body_get_mass(scene_get_body(scene, i)) == 2 * (i + 1));
+    }
+    scene_free(scene);
+}
+
 int main(int argc, char *argv[]) {
-    // // Run all tests if there are no command-line arguments
-    // bool all_tests = argc == 1;
-    // // Read test name from file
-    // char testname[100];
-    // if (!all_tests) {
-    //     read_testname(argv[1], testname, sizeof(testname));
-    // }
-    //
-    // DO_TEST(test_empty_scene)
-    // DO_TEST(test_scene)
-    // DO_TEST(test_force_creator)
-    // DO_TEST(test_force_creator_aux)
-    // DO_TEST(test_reaping)
-    //
-    // puts("scene_test PASS");
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_empty_scene)
+    DO_TEST(test_scene)
+    DO_TEST(test_force_creator)
+    DO_TEST(test_force_creator_aux)
+    DO_TEST(test_reaping)
+    DO_TEST(test_remove_if)
+    DO_TEST(test_step_fixed)
+    DO_TEST(test_parallel_tick)
+    DO_TEST(test_snapshot)
+    DO_TEST(test_fork)
+    DO_TEST(test_handles)
+    DO_TEST(test_deferred_commands)
+    DO_TEST(test_shared_pool_commands)
+    DO_TEST(test_world_bounds)
+    DO_TEST(test_parallel_world_bounds)
+    DO_TEST(test_remove_if_in_tick)
+
+    puts("scene_test PASS");
 }
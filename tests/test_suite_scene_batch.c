@@ -0,0 +1,145 @@
+#include "scene_batch.h"
+#include "forces.h"
+#include "polygon.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const vector_t GRAVITY = {0, -9.8};
+const size_t BALL = 0;
+const size_t FLOOR = 1;
+
+list_t *make_shape(double half_width, double half_height) {
+    list_t *shape = list_init(4, free);
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {-half_width, -half_height};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+half_width, -half_height};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+half_width, +half_height};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {-half_width, +half_height};
+    list_add(shape, v);
+    return shape;
+}
+
+// Pulls the ball in a scene down with uniform gravity
+void ball_gravity(void *aux) {
+    body_t *ball = aux;
+    body_add_force(ball, vec_multiply(body_get_mass(ball), GRAVITY));
+}
+
+// Builds a scene of a ball dropped onto a floor,
+// with a height and elasticity depending on the scene's index
+scene_t *build_drop(scene_batch_t *batch, size_t index, void *aux) {
+    size_t *count = aux;
+    scene_t *scene = scene_init();
+    body_t *ball = body_init(scene_batch_instance(batch, BALL, \
+        (vector_t) {0, 5 + index % 7}), 1, (rgb_color_t) {1, 0, 0});
+    body_t *floor = body_init(scene_batch_instance(batch, FLOOR, VEC_ZERO), \
+        INFINITY, (rgb_color_t) {0, 0, 1});
+    scene_add_body(scene, ball);
+    scene_add_body(scene, floor);
+    list_t *bodies = list_init(1, NULL);
+    list_add(bodies, ball);
+    scene_add_bodies_force_creator(scene, ball_gravity, ball, bodies, NULL);
+    create_physics_collision(scene, 0.2 + 0.8 * index / *count, ball, floor);
+    return scene;
+}
+
+// Adds the ball and floor templates to a batch
+void add_templates(scene_batch_t *batch) {
+    assert(scene_batch_add_template(batch, make_shape(0.5, 0.5)) == BALL);
+    assert(scene_batch_add_template(batch, make_shape(20, 1)) == FLOOR);
+}
+
+// Stops a scene once its ball has bounced off the floor
+bool ball_bounced(scene_t *scene, size_t index, void *aux) {
+    return body_get_velocity(scene_get_body(scene, 0)).y > 0;
+}
+
+double ball_speed(scene_t *scene, size_t index, void *aux) {
+    return fabs(body_get_velocity(scene_get_body(scene, 0)).y);
+}
+
+// Tests that templates are copied to the right place
+void test_templates() {
+    scene_batch_t *batch = scene_batch_init(2);
+    list_t *shape = make_shape(1, 2);
+    polygon_translate(shape, (vector_t) {5, 5});
+    assert(scene_batch_add_template(batch, shape) == 0);
+    list_t *copy = scene_batch_instance(batch, 0, (vector_t) {-1, 3});
+    assert(list_size(copy) == 4);
+    assert(vec_isclose(*(vector_t *) list_get(copy, 0), (vector_t) {-2, 1}));
+    assert(vec_isclose(*(vector_t *) list_get(copy, 2), (vector_t) {0, 5}));
+    assert(vec_isclose(polygon_centroid(copy), (vector_t) {-1, 3}));
+    list_free(copy);
+    assert(scene_batch_size(batch) == 0);
+    scene_batch_free(batch);
+}
+
+// Tests that every scene in a batch runs exactly as it would on its own,
+// stopping early where asked
+void test_sweep() {
+    const double DT = 1e-3;
+    const size_t MAX_STEPS = 5000;
+    const size_t AFTER_STEPS = 300;
+    size_t count = 60;
+    scene_batch_t *batch = scene_batch_init(3);
+    add_templates(batch);
+    scene_batch_build(batch, count / 2, build_drop, &count);
+    scene_batch_build(batch, count / 2, build_drop, &count);
+    assert(scene_batch_size(batch) == count);
+
+    // Every ball falls until it bounces, then flies for a while
+    scene_batch_run(batch, DT, MAX_STEPS, ball_bounced, NULL);
+    double speeds[count];
+    scene_batch_measure(batch, ball_speed, NULL, speeds);
+    scene_batch_run(batch, DT, AFTER_STEPS, NULL, NULL);
+
+    // Each scene built and ticked on its own, on this thread
+    scene_batch_t *reference = scene_batch_init(1);
+    add_templates(reference);
+    for (size_t i = 0; i < count; i++) {
+        scene_t *scene = build_drop(reference, i, &count);
+        size_t steps = 0;
+        while (steps < MAX_STEPS && !ball_bounced(scene, i, NULL)) {
+            scene_tick(scene, DT);
+            steps++;
+        }
+        assert(scene_batch_steps(batch, i) == steps + AFTER_STEPS);
+        assert(speeds[i] == ball_speed(scene, i, NULL));
+        for (size_t step = 0; step < AFTER_STEPS; step++) {
+            scene_tick(scene, DT);
+        }
+        vector_t expected = body_get_centroid(scene_get_body(scene, 0));
+        body_t *ball = scene_get_body(scene_batch_get(batch, i), 0);
+        assert(vec_equal(body_get_centroid(ball), expected));
+        scene_free(scene);
+    }
+    // Balls dropped from higher take longer to bounce,
+    // and bouncier balls fly off faster
+    assert(scene_batch_steps(batch, 0) < scene_batch_steps(batch, 6));
+    assert(speeds[7] < speeds[14]);
+    scene_batch_free(reference);
+    scene_batch_free(batch);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_templates)
+    DO_TEST(test_sweep)
+
+    puts("scene_batch_test PASS");
+}
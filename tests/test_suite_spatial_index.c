@@ -0,0 +1,414 @@
+#include "spatial_index.h"
+#include "scene.h"
+#include "collision.h"
+#include "worker_pool.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const size_t BODIES = 500;
+const double WORLD_SIZE = 1000;
+const size_t QUERIES = 200;
+
+double random_double(double min, double max) {
+    return min + (max - min) * rand() / RAND_MAX;
+}
+
+list_t *make_rectangle(vector_t min, vector_t max) {
+    list_t *shape = list_init(4, free);
+    vector_t corners[] = {min, {max.x, min.y}, max, {min.x, max.y}};
+    for (size_t i = 0; i < 4; i++) {
+        vector_t *v = malloc(sizeof(*v));
+        *v = corners[i];
+        list_add(shape, v);
+    }
+    return shape;
+}
+
+// Makes a triangle, which isn't filled by its bounding box
+list_t *make_triangle(vector_t center, double size) {
+    list_t *shape = list_init(3, free);
+    vector_t corners[] = {{-size, -size}, {size, -size}, {-size, size}};
+    for (size_t i = 0; i < 3; i++) {
+        vector_t *v = malloc(sizeof(*v));
+        *v = vec_add(center, corners[i]);
+        list_add(shape, v);
+    }
+    return shape;
+}
+
+// Makes a scene of small triangles scattered around a long wall
+scene_t *make_scattered_scene(void) {
+    scene_t *scene = scene_init();
+    for (size_t i = 0; i < BODIES; i++) {
+        vector_t center = {
+            random_double(0, WORLD_SIZE),
+            random_double(0, WORLD_SIZE)
+        };
+        list_t *shape = make_triangle(center, random_double(1, 10));
+        scene_add_body(scene, body_init(shape, 1, (rgb_color_t) {0, 0, 0}));
+    }
+    list_t *wall = make_rectangle((vector_t) {-10, 480}, \
+        (vector_t) {WORLD_SIZE + 10, 520});
+    scene_add_body(scene, body_init(wall, INFINITY, (rgb_color_t) {0, 0, 0}));
+    return scene;
+}
+
+aabb_t random_box(double max_size) {
+    vector_t min = {
+        random_double(-50, WORLD_SIZE + 50),
+        random_double(-50, WORLD_SIZE + 50)
+    };
+    vector_t size = {random_double(0, max_size), random_double(0, max_size)};
+    return (aabb_t) {min, vec_add(min, size)};
+}
+
+bool boxes_overlap(aabb_t a, aabb_t b) {
+    return a.min.x <= b.max.x && b.min.x <= a.max.x && \
+        a.min.y <= b.max.y && b.min.y <= a.max.y;
+}
+
+// Checks that found holds exactly the bodies of the scene that pass a test,
+// each once
+void check_results(scene_t *scene, body_t **found, size_t count, \
+    bool (*hit)(body_t *body, void *aux), void *aux) {
+    size_t expected = 0;
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        body_t *body = scene_get_body(scene, i);
+        size_t times = 0;
+        for (size_t j = 0; j < count; j++) {
+            times += found[j] == body;
+        }
+        if (!body_is_removed(body) && hit(body, aux)) {
+            assert(times == 1);
+            expected++;
+        }
+        else {
+            assert(times == 0);
+        }
+    }
+    assert(count == expected);
+}
+
+bool overlaps_box(body_t *body, aabb_t *box) {
+    return boxes_overlap(polygon_bounds(body->shape), *box);
+}
+
+bool contains_point(body_t *body, vector_t *point) {
+    return polygon_contains(body->shape, *point);
+}
+
+typedef struct circle {
+    vector_t center;
+    double radius;
+} circle_t;
+
+bool within_circle(body_t *body, circle_t *circle) {
+    return polygon_distance(body->shape, circle->center) <= circle->radius;
+}
+
+// Tests the polygon helpers used to answer queries
+void test_polygon_queries() {
+    list_t *triangle = make_triangle(VEC_ZERO, 1);
+    aabb_t bounds = polygon_bounds(triangle);
+    assert(vec_isclose(bounds.min, (vector_t) {-1, -1}));
+    assert(vec_isclose(bounds.max, (vector_t) {1, 1}));
+    assert(polygon_contains(triangle, (vector_t) {-0.5, -0.5}));
+    assert(!polygon_contains(triangle, (vector_t) {0.5, 0.5}));
+    assert(!polygon_contains(triangle, (vector_t) {2, 0}));
+    assert(polygon_distance(triangle, (vector_t) {-0.5, 0}) == 0);
+    assert(fabs(polygon_distance(triangle, (vector_t) {0, -3}) - 2) < 1e-9);
+    assert(fabs(polygon_distance(triangle, (vector_t) {1, 1}) - sqrt(2)) \
+        < 1e-9);
+    list_free(triangle);
+}
+
+// Tests that index queries find the same bodies as checking every body
+void test_index_query() {
+    scene_t *scene = make_scattered_scene();
+    // Some removed bodies, which must not be found
+    for (size_t i = 0; i < BODIES; i += 7) {
+        body_remove(scene_get_body(scene, i));
+    }
+    list_t *bodies = list_init(scene_bodies(scene), NULL);
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        list_add(bodies, scene_get_body(scene, i));
+    }
+    spatial_index_t *index = spatial_index_init();
+    body_t **found = malloc((BODIES + 1) * sizeof(body_t *));
+    assert(found != NULL);
+    assert(spatial_index_query(index, random_box(100), NULL, NULL, found, \
+        BODIES + 1) == 0);
+
+    spatial_index_build(index, bodies);
+    for (size_t q = 0; q < QUERIES; q++) {
+        aabb_t box = random_box(q % 2 == 0 ? 20 : 300);
+        size_t count = spatial_index_query(index, box, NULL, NULL, found, \
+            BODIES + 1);
+        check_results(scene, found, count, \
+            (bool (*)(body_t *, void *)) overlaps_box, &box);
+    }
+
+    // Only capacity bodies are stored, but all are counted
+    aabb_t all = {{-100, -100}, {WORLD_SIZE + 100, WORLD_SIZE + 100}};
+    size_t total = spatial_index_query(index, all, NULL, NULL, found, \
+        BODIES + 1);
+    assert(total == BODIES + 1 - (BODIES + 6) / 7);
+    body_t *first[5];
+    assert(spatial_index_query(index, all, NULL, NULL, first, 5) == total);
+    for (size_t i = 0; i < 5; i++) {
+        assert(!body_is_removed(first[i]));
+    }
+
+    spatial_index_free(index);
+    free(found);
+    list_free(bodies);
+    scene_free(scene);
+}
+
+// Tests the scene's point and radius queries against every body
+void test_scene_queries() {
+    scene_t *scene = make_scattered_scene();
+    body_t **found = malloc((BODIES + 1) * sizeof(body_t *));
+    assert(found != NULL);
+    for (size_t q = 0; q < QUERIES; q++) {
+        vector_t point = {
+            random_double(0, WORLD_SIZE),
+            random_double(0, WORLD_SIZE)
+        };
+        size_t count = scene_query_point(scene, point, found, BODIES + 1);
+        check_results(scene, found, count, \
+            (bool (*)(body_t *, void *)) contains_point, &point);
+
+        circle_t circle = {point, random_double(0, 60)};
+        count = scene_query_radius(scene, circle.center, circle.radius, found, \
+            BODIES + 1);
+        check_results(scene, found, count, \
+            (bool (*)(body_t *, void *)) within_circle, &circle);
+    }
+
+    // Every point inside the wall hits it
+    body_t *wall = scene_get_body(scene, BODIES);
+    size_t count = scene_query_point(scene, (vector_t) {500, 500}, found, \
+        BODIES + 1);
+    bool hit_wall = false;
+    for (size_t i = 0; i < count; i++) {
+        hit_wall = hit_wall || found[i] == wall;
+    }
+    assert(hit_wall);
+    free(found);
+    scene_free(scene);
+}
+
+// Tests that scene queries see bodies where they are after each tick,
+// and see bodies added or removed
+void test_scene_updates() {
+    scene_t *scene = scene_init();
+    list_t *shape = make_rectangle((vector_t) {0, 0}, (vector_t) {2, 2});
+    body_t *body = body_init(shape, 1, (rgb_color_t) {0, 0, 0});
+    body_set_velocity(body, (vector_t) {10, 0});
+    scene_add_body(scene, body);
+    body_t *found[2];
+    aabb_t start = {{0, 0}, {1, 1}};
+    assert(scene_query_aabb(scene, start, found, 2) == 1 && found[0] == body);
+
+    scene_tick(scene, 1);
+    assert(scene_query_aabb(scene, start, found, 2) == 0);
+    assert(scene_query_point(scene, (vector_t) {11, 1}, found, 2) == 1);
+    assert(found[0] == body);
+
+    list_t *other_shape = make_rectangle((vector_t) {0, 0}, (vector_t) {1, 1});
+    body_t *other = body_init(other_shape, 1, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, other);
+    assert(scene_query_aabb(scene, start, found, 2) == 1 && found[0] == other);
+    assert(scene_query_radius(scene, (vector_t) {5, 0.5}, 5.5, found, 2) == 2);
+
+    // The scene frees the body when it reaps it
+    body_remove(other);
+    scene_tick(scene, 0);
+    assert(scene_query_aabb(scene, start, found, 2) == 0);
+    scene_free(scene);
+}
+
+// Tests sweeps of one square past another
+void test_sweep() {
+    list_t *moving = make_rectangle((vector_t) {0, 0}, (vector_t) {1, 1});
+    list_t *still = make_rectangle((vector_t) {5, 0.5}, (vector_t) {6, 2});
+    sweep_info_t sweep = find_sweep(moving, (vector_t) {10, 0}, still);
+    assert(sweep.hit);
+    assert(fabs(sweep.fraction - 0.4) < 1e-9);
+    assert(vec_isclose(sweep.normal, (vector_t) {-1, 0}));
+
+    // Too short, moving away, or passing by
+    assert(!find_sweep(moving, (vector_t) {3, 0}, still).hit);
+    assert(!find_sweep(moving, (vector_t) {-10, 0}, still).hit);
+    assert(!find_sweep(moving, (vector_t) {10, -5}, still).hit);
+
+    // At an angle onto the side of the still square
+    sweep = find_sweep(moving, (vector_t) {10, 1}, still);
+    assert(sweep.hit);
+    assert(fabs(sweep.fraction - 0.4) < 1e-9);
+    assert(vec_isclose(sweep.normal, (vector_t) {-1, 0}));
+
+    // Straight down onto its top
+    polygon_translate(moving, (vector_t) {5, 3});
+    sweep = find_sweep(moving, (vector_t) {0, -4}, still);
+    assert(sweep.hit);
+    assert(fabs(sweep.fraction - 0.25) < 1e-9);
+    assert(vec_isclose(sweep.normal, (vector_t) {0, 1}));
+
+    // Shapes that already overlap don't hit
+    polygon_translate(moving, (vector_t) {0, -2.5});
+    assert(!find_sweep(moving, (vector_t) {1, 0}, still).hit);
+    list_free(moving);
+    list_free(still);
+}
+
+ray_t random_ray(void) {
+    double angle = random_double(0, 2 * M_PI);
+    return (ray_t) {
+        {random_double(-50, WORLD_SIZE + 50), random_double(-50, WORLD_SIZE + 50)},
+        vec_multiply(random_double(0.5, 2), (vector_t) {cos(angle), sin(angle)}),
+        random_double(0, 400)
+    };
+}
+
+// Checks a ray's hit against testing the ray against every body
+void check_ray(scene_t *scene, ray_t ray, ray_hit_t hit) {
+    vector_t direction = vec_multiply(
+        1 / sqrt(vec_dot(ray.direction, ray.direction)), ray.direction);
+    body_t *nearest = NULL;
+    double nearest_distance = ray.max_distance;
+    for (size_t i = 0; i < scene_bodies(scene); i++) {
+        body_t *body = scene_get_body(scene, i);
+        vector_t normal;
+        double distance = polygon_raycast(body->shape, ray.origin, direction, \
+            &normal);
+        if (!body_is_removed(body) && distance < nearest_distance) {
+            nearest = body;
+            nearest_distance = distance;
+        }
+    }
+    assert(hit.body == nearest);
+    if (nearest != NULL) {
+        assert(fabs(hit.distance - nearest_distance) < 1e-9);
+        vector_t point = vec_add(ray.origin, \
+            vec_multiply(nearest_distance, direction));
+        assert(vec_isclose(hit.point, point));
+        assert(fabs(vec_dot(hit.normal, hit.normal) - 1) < 1e-9);
+        assert(vec_dot(hit.normal, direction) <= 0);
+    }
+}
+
+// Tests that batched raycasts find the same hits as checking every body,
+// with and without a worker pool
+void test_raycast() {
+    const size_t RAYS = 1000;
+    scene_t *scene = make_scattered_scene();
+    for (size_t i = 0; i < BODIES; i += 5) {
+        body_remove(scene_get_body(scene, i));
+    }
+    ray_t *rays = malloc(RAYS * sizeof(ray_t));
+    ray_hit_t *hits = malloc(RAYS * sizeof(ray_hit_t));
+    assert(rays != NULL && hits != NULL);
+    for (size_t i = 0; i < RAYS; i++) {
+        rays[i] = random_ray();
+    }
+    // Some rays along the axes, which step through one row or column
+    rays[0] = (ray_t) {{-20, 300}, {1, 0}, 2000};
+    rays[1] = (ray_t) {{300, 1020}, {0, -1}, 2000};
+    size_t hit_count = scene_raycast_batch(scene, rays, RAYS, hits);
+    size_t expected = 0;
+    for (size_t i = 0; i < RAYS; i++) {
+        check_ray(scene, rays[i], hits[i]);
+        expected += hits[i].body != NULL;
+    }
+    assert(hit_count == expected && hit_count > 0);
+
+    worker_pool_t *pool = worker_pool_init(4);
+    scene_set_pool(scene, pool);
+    ray_hit_t *pool_hits = malloc(RAYS * sizeof(ray_hit_t));
+    assert(pool_hits != NULL);
+    assert(scene_raycast_batch(scene, rays, RAYS, pool_hits) == hit_count);
+    for (size_t i = 0; i < RAYS; i++) {
+        assert(pool_hits[i].body == hits[i].body);
+        assert(pool_hits[i].distance == hits[i].distance || \
+            pool_hits[i].body == NULL);
+    }
+
+    // A ray from inside the wall only hits what is past it
+    body_t *wall = scene_get_body(scene, BODIES);
+    ray_t inside = {{500, 500}, {0, 1}, 1000};
+    scene_raycast_batch(scene, &inside, 1, hits);
+    assert(hits[0].body != wall);
+    ray_t outside = {{500, 400}, {0, 1}, 1000};
+    scene_raycast_batch(scene, &outside, 1, hits);
+    check_ray(scene, outside, hits[0]);
+
+    scene_free(scene);
+    worker_pool_free(pool);
+    free(rays);
+    free(hits);
+    free(pool_hits);
+}
+
+// Tests that shape casts find the same hits as sweeping past every body
+void test_shape_cast() {
+    scene_t *scene = make_scattered_scene();
+    for (size_t q = 0; q < QUERIES; q++) {
+        ray_t ray = random_ray();
+        vector_t min = ray.origin;
+        list_t *shape = make_rectangle(min, vec_add(min, (vector_t) {4, 4}));
+        ray_hit_t hit;
+        bool found = scene_shape_cast(scene, shape, ray.direction, \
+            ray.max_distance, &hit);
+
+        vector_t displacement = vec_multiply(ray.max_distance / \
+            sqrt(vec_dot(ray.direction, ray.direction)), ray.direction);
+        body_t *first = NULL;
+        sweep_info_t first_sweep = {false, 0, VEC_ZERO};
+        for (size_t i = 0; i < scene_bodies(scene); i++) {
+            body_t *body = scene_get_body(scene, i);
+            sweep_info_t sweep = find_sweep(shape, displacement, body->shape);
+            if (sweep.hit && (first == NULL || \
+                sweep.fraction < first_sweep.fraction)) {
+                first = body;
+                first_sweep = sweep;
+            }
+        }
+        assert(found == (first != NULL));
+        assert(hit.body == first);
+        if (found) {
+            assert(fabs(hit.distance - first_sweep.fraction * ray.max_distance) \
+                < 1e-9);
+            assert(vec_isclose(hit.normal, first_sweep.normal));
+            vector_t moved = vec_multiply(first_sweep.fraction, displacement);
+            assert(vec_isclose(hit.point, \
+                vec_add(polygon_centroid(shape), moved)));
+        }
+        list_free(shape);
+    }
+
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_polygon_queries)
+    DO_TEST(test_index_query)
+    DO_TEST(test_scene_queries)
+    DO_TEST(test_scene_updates)
+    DO_TEST(test_sweep)
+    DO_TEST(test_raycast)
+    DO_TEST(test_shape_cast)
+
+    puts("spatial_index_test PASS");
+}
@@ -0,0 +1,182 @@
+#include "spring_network.h"
+#include "forces.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+list_t *make_shape() {
+    list_t *shape = list_init(4, free);
+    vector_t *v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, -1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {+1, +1};
+    list_add(shape, v);
+    v = malloc(sizeof(*v));
+    *v = (vector_t) {-1, +1};
+    list_add(shape, v);
+    return shape;
+}
+
+// Tests that a spring network matches the equivalent individual springs
+void test_spring_network() {
+    const double M = 3;
+    const double K = 5;
+    const double DT = 1e-3;
+    const int STEPS = 10000;
+    scene_t *scene = scene_init();
+    list_t *network_bodies = list_init(3, NULL);
+    body_t *single[3];
+    for (int i = 0; i < 3; i++) {
+        vector_t start = {i * 4, i * i};
+        single[i] = body_init(make_shape(), M, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(single[i], start);
+        scene_add_body(scene, single[i]);
+        body_t *networked = body_init(make_shape(), M, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(networked, start);
+        scene_add_body(scene, networked);
+        list_add(network_bodies, networked);
+    }
+    create_spring(scene, K, single[0], single[1]);
+    create_spring(scene, K, single[1], single[2]);
+    spring_network_t *network = create_spring_network(scene, network_bodies);
+    spring_network_add(network, 0, 1, K, 0, 0);
+    spring_network_add(network, 1, 2, K, 0, 0);
+    assert(spring_network_size(network) == 2);
+    for (int i = 0; i < STEPS; i++) {
+        scene_tick(scene, DT);
+        for (int j = 0; j < 3; j++) {
+            assert(vec_isclose(
+                body_get_centroid(single[j]),
+                body_get_centroid(list_get(network_bodies, j))
+            ));
+        }
+    }
+    scene_free(scene);
+}
+
+// Tests that a damped spring with a rest length settles at that length
+void test_spring_network_rest_length() {
+    const double M = 1;
+    const double K = 10;
+    const double REST = 4;
+    const double DAMPING = 2;
+    const double DT = 1e-3;
+    const int STEPS = 100000;
+    scene_t *scene = scene_init();
+    body_t *mass = body_init(make_shape(), M, (rgb_color_t) {0, 0, 0});
+    body_set_centroid(mass, (vector_t) {10, 0});
+    scene_add_body(scene, mass);
+    body_t *anchor = body_init(make_shape(), INFINITY, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, anchor);
+    list_t *bodies = list_init(2, NULL);
+    list_add(bodies, mass);
+    list_add(bodies, anchor);
+    spring_network_t *network = create_spring_network(scene, bodies);
+    spring_network_add(network, 0, 1, K, REST, DAMPING);
+    for (int i = 0; i < STEPS; i++) {
+        scene_tick(scene, DT);
+    }
+    assert(vec_within(1e-4, body_get_centroid(mass), (vector_t) {REST, 0}));
+    assert(vec_equal(body_get_centroid(anchor), VEC_ZERO));
+    scene_free(scene);
+}
+
+
+// Tests that an implicit spring still oscillates like A cos(sqrt(K / M) * t)
+void test_implicit_sinusoid() {
+    const double M = 10;
+    const double K = 2;
+    const double A = 3;
+    const double DT = 1e-3;
+    const int STEPS = 10000;
+    scene_t *scene = scene_init();
+    body_t *mass = body_init(make_shape(), M, (rgb_color_t) {0, 0, 0});
+    body_set_centroid(mass, (vector_t) {A, 0});
+    scene_add_body(scene, mass);
+    body_t *anchor = body_init(make_shape(), INFINITY, (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, anchor);
+    list_t *bodies = list_init(2, NULL);
+    list_add(bodies, mass);
+    list_add(bodies, anchor);
+    spring_network_t *network = create_spring_network(scene, bodies);
+    spring_network_add(network, 0, 1, K, 0, 0);
+    spring_network_set_implicit(network, true);
+    for (int i = 0; i < STEPS; i++) {
+        assert(vec_within(1e-2,
+            body_get_centroid(mass),
+            (vector_t) {A * cos(sqrt(K / M) * i * DT), 0}
+        ));
+        assert(vec_equal(body_get_centroid(anchor), VEC_ZERO));
+        scene_tick(scene, DT);
+        assert(spring_network_iterations(network) > 0);
+    }
+    scene_free(scene);
+}
+
+// Makes a stretched chain of bodies hanging off an anchor
+spring_network_t *make_chain(scene_t *scene, size_t n, double k, double rest) {
+    list_t *bodies = list_init(n, NULL);
+    for (size_t i = 0; i < n; i++) {
+        double mass = i == 0 ? INFINITY : 1;
+        body_t *body = body_init(make_shape(), mass, (rgb_color_t) {0, 0, 0});
+        body_set_centroid(body, (vector_t) {i * rest * 1.5, i % 2});
+        scene_add_body(scene, body);
+        list_add(bodies, body);
+    }
+    spring_network_t *network = create_spring_network(scene, bodies);
+    for (size_t i = 0; i + 1 < n; i++) {
+        spring_network_add(network, i, i + 1, k, rest, 0);
+    }
+    return network;
+}
+
+// Tests that a very stiff chain stays bounded at a frame-rate time step
+// when integrated implicitly, while the explicit chain blows up
+void test_implicit_stiff_chain() {
+    const size_t N = 10;
+    const double K = 1e6;
+    const double REST = 1;
+    const double DT = 1.0 / 60;
+    const int STEPS = 600;
+    scene_t *implicit_scene = scene_init();
+    spring_network_t *network = make_chain(implicit_scene, N, K, REST);
+    spring_network_set_implicit(network, true);
+    scene_t *explicit_scene = scene_init();
+    make_chain(explicit_scene, N, K, REST);
+    for (int i = 0; i < STEPS; i++) {
+        scene_tick(implicit_scene, DT);
+        scene_tick(explicit_scene, DT);
+        for (size_t j = 0; j < N; j++) {
+            vector_t centroid = body_get_centroid(
+                scene_get_body(implicit_scene, j));
+            assert(isfinite(centroid.x) && isfinite(centroid.y));
+            assert(sqrt(vec_dot(centroid, centroid)) < 2 * N * REST);
+        }
+    }
+    vector_t end = body_get_centroid(scene_get_body(explicit_scene, N - 1));
+    assert(!(sqrt(vec_dot(end, end)) < 2 * N * REST));
+    scene_free(implicit_scene);
+    scene_free(explicit_scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_spring_network)
+    DO_TEST(test_spring_network_rest_length)
+    DO_TEST(test_implicit_sinusoid)
+    DO_TEST(test_implicit_stiff_chain)
+
+    puts("spring_network_test PASS");
+}
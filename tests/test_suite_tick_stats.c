@@ -0,0 +1,161 @@
+#include "tick_stats.h"
+#include "forces.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+list_t *make_square(vector_t centroid) {
+    list_t *shape = list_init(4, free);
+    const vector_t CORNERS[] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+    for (size_t i = 0; i < 4; i++) {
+        vector_t *v = malloc(sizeof(*v));
+        *v = vec_add(centroid, CORNERS[i]);
+        list_add(shape, v);
+    }
+    return shape;
+}
+
+void do_nothing(void *aux) {}
+
+// Tests the latest tick and the summaries over a full window
+void test_window() {
+    const size_t TICKS = 200;
+    tick_stats_t *stats = tick_stats_init();
+    scene_stats_t summary;
+    tick_stats_summarize(stats, &summary);
+    assert(summary.ticks == 0 && summary.tick_time == 0);
+    assert(summary.counter_summaries[TICK_PAIR_TESTS].max == 0);
+
+    // Counts made between ticks are dropped
+    tick_stats_count(stats, TICK_PAIR_TESTS, 1000);
+    for (size_t i = 0; i < TICKS; i++) {
+        tick_stats_begin(stats);
+        tick_stats_count(stats, TICK_PAIR_TESTS, i);
+        tick_stats_lap(stats, TICK_PHASE_FORCES);
+        tick_stats_count(stats, TICK_COLLISIONS, 1);
+        tick_stats_lap(stats, TICK_PHASE_COLLISIONS);
+        tick_stats_lap(stats, TICK_PHASE_COLLISIONS);
+        tick_stats_end(stats);
+    }
+    tick_stats_summarize(stats, &summary);
+    assert(summary.ticks == TICK_STATS_WINDOW);
+    assert(summary.counters[TICK_PAIR_TESTS] == TICKS - 1);
+    assert(summary.counters[TICK_COLLISIONS] == 1);
+    assert(summary.counters[TICK_BODIES_REMOVED] == 0);
+
+    // Only the last TICK_STATS_WINDOW ticks are summarized
+    stat_summary_t pairs = summary.counter_summaries[TICK_PAIR_TESTS];
+    double first = TICKS - TICK_STATS_WINDOW;
+    assert(pairs.min == first);
+    assert(pairs.max == TICKS - 1);
+    assert(fabs(pairs.mean - (first + TICKS - 1) / 2) < 1e-9);
+    assert(pairs.p99 == TICKS - 2);
+    stat_summary_t collisions = summary.counter_summaries[TICK_COLLISIONS];
+    assert(collisions.min == 1 && collisions.max == 1 && collisions.p99 == 1);
+
+    // Phases are timed in order, within the tick
+    double phases = 0;
+    for (size_t p = 0; p < NUM_TICK_PHASES; p++) {
+        assert(summary.phase_times[p] >= 0);
+        stat_summary_t times = summary.phase_summaries[p];
+        assert(times.min <= times.mean && times.mean <= times.max);
+        assert(times.min <= times.p99 && times.p99 <= times.max);
+        phases += summary.phase_times[p];
+    }
+    assert(summary.phase_summaries[TICK_PHASE_SOLVERS].max == 0);
+    assert(phases <= summary.tick_time);
+    assert(summary.tick_summary.max >= summary.tick_time);
+    tick_stats_free(stats);
+}
+
+// Tests the counters of a scene's ticks
+void test_scene_stats() {
+    scene_t *scene = scene_init();
+    body_t *a = body_init(make_square((vector_t) {0, 0}), 1, \
+        (rgb_color_t) {0, 0, 0});
+    body_t *b = body_init(make_square((vector_t) {1, 0}), 1, \
+        (rgb_color_t) {0, 0, 0});
+    body_t *c = body_init(make_square((vector_t) {10, 0}), 1, \
+        (rgb_color_t) {0, 0, 0});
+    scene_add_body(scene, a);
+    scene_add_body(scene, b);
+    scene_add_body(scene, c);
+    create_newtonian_gravity(scene, 1, a, c);
+    create_destructive_collision(scene, a, b);
+    create_physics_collision(scene, 1, b, c);
+    scene_add_force_creator(scene, do_nothing, NULL, NULL);
+
+    // Nothing is recorded until stats are enabled
+    scene_stats_t stats;
+    scene_t *quiet = scene_init();
+    scene_tick(quiet, 0.01);
+    scene_get_stats(quiet, &stats);
+    assert(stats.ticks == 0 && stats.tick_time == 0);
+    scene_free(quiet);
+    scene_enable_stats(scene);
+    scene_get_stats(scene, &stats);
+    assert(stats.ticks == 0);
+    scene_tick(scene, 0.01);
+    scene_get_stats(scene, &stats);
+    assert(stats.ticks == 1);
+    assert(stats.counters[TICK_FORCES_EVALUATED] == 2);
+    assert(stats.counters[TICK_PAIR_TESTS] == 2);
+    assert(stats.counters[TICK_SAT_AXES] == 16);
+    assert(stats.counters[TICK_COLLISIONS] == 1);
+    assert(stats.counters[TICK_BODIES_REMOVED] == 2);
+    assert(stats.counters[TICK_FORCES_REMOVED] == 3);
+    assert(stats.tick_time > 0);
+
+    // The next tick only has the force creator left
+    scene_tick(scene, 0.01);
+    scene_get_stats(scene, &stats);
+    assert(stats.ticks == 2);
+    assert(stats.counters[TICK_FORCES_EVALUATED] == 1);
+    assert(stats.counters[TICK_PAIR_TESTS] == 0);
+    assert(stats.counters[TICK_BODIES_REMOVED] == 0);
+    stat_summary_t removed = stats.counter_summaries[TICK_BODIES_REMOVED];
+    assert(removed.min == 0 && removed.mean == 1 && removed.max == 2);
+    assert(removed.p99 == 2);
+    scene_free(scene);
+}
+
+// Tests that growing the scene's arrays during a tick is counted
+void test_allocations() {
+    scene_t *scene = scene_init();
+    for (size_t i = 0; i < 20; i++) {
+        scene_add_body(scene, body_init(make_square((vector_t) {3 * i, 0}), \
+            1, (rgb_color_t) {0, 0, 0}));
+    }
+    for (size_t i = 0; i + 1 < 20; i++) {
+        create_physics_collision(scene, 1, scene_get_body(scene, i), \
+            scene_get_body(scene, i + 1));
+    }
+    scene_enable_stats(scene);
+    scene_stats_t stats;
+    scene_tick(scene, 0.01);
+    scene_get_stats(scene, &stats);
+    // Deferring mutations allocates its buffers on the first tick
+    assert(stats.counters[TICK_ALLOCATIONS] > 0);
+    scene_tick(scene, 0.01);
+    scene_get_stats(scene, &stats);
+    assert(stats.counters[TICK_ALLOCATIONS] == 0);
+    scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_window)
+    DO_TEST(test_scene_stats)
+    DO_TEST(test_allocations)
+
+    puts("tick_stats_test PASS");
+}
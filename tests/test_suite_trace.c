@@ -0,0 +1,116 @@
+// Tests the macros as they are when tracing is enabled
+#define TRACE
+#include "trace.h"
+#include "test_util.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char TRACE_PATH[] = "test_trace.json";
+const size_t THREADS = 4;
+const size_t SPANS = 100;
+
+// Reads a whole file into a string
+char *read_file(const char *path) {
+    FILE *file = fopen(path, "r");
+    assert(file != NULL);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = malloc(size + 1);
+    assert(text != NULL);
+    assert(fread(text, 1, size, file) == (size_t) size);
+    text[size] = '\0';
+    fclose(file);
+    return text;
+}
+
+// Counts the occurrences of a string in a text
+size_t count_matches(const char *text, const char *pattern) {
+    size_t count = 0;
+    for (const char *match = strstr(text, pattern); match != NULL; \
+        match = strstr(match + 1, pattern)) {
+        count++;
+    }
+    return count;
+}
+
+void *record_spans(void *arg) {
+    for (size_t i = 0; i < SPANS; i++) {
+        TRACE_BEGIN("work");
+        TRACE_END("work");
+    }
+    return NULL;
+}
+
+// Tests that every thread's events are written as trace-event JSON
+void test_threads() {
+    TRACE_BEGIN("main");
+    pthread_t threads[THREADS];
+    for (size_t t = 0; t < THREADS; t++) {
+        assert(pthread_create(&threads[t], NULL, record_spans, NULL) == 0);
+    }
+    for (size_t t = 0; t < THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    double start = trace_now();
+    double end = start + 1e-3;
+    TRACE_SPAN("finished", start, end);
+    TRACE_END("main");
+    assert(TRACE_WRITE(TRACE_PATH));
+
+    char *text = read_file(TRACE_PATH);
+    assert(strncmp(text, "{\"traceEvents\":[", 16) == 0);
+    assert(strstr(text, "\n],\"displayTimeUnit\":\"ms\"}\n") != NULL);
+    assert(count_matches(text, "\"name\":\"work\",\"ph\":\"B\"") == \
+        THREADS * SPANS);
+    assert(count_matches(text, "\"name\":\"work\",\"ph\":\"E\"") == \
+        THREADS * SPANS);
+    assert(count_matches(text, "\"name\":\"main\"") == 2);
+    assert(count_matches(text, "\"ph\":\"X\"") == 1);
+    assert(count_matches(text, "\"dur\":1000.000,") == 1);
+    // Each thread has its own id
+    char tid[32];
+    for (size_t t = 0; t <= THREADS; t++) {
+        snprintf(tid, sizeof(tid), "\"tid\":%zu}", t);
+        assert(count_matches(text, tid) >= 2);
+    }
+    free(text);
+    remove(TRACE_PATH);
+}
+
+void *overflow_buffer(void *arg) {
+    for (unsigned long i = 0; i < TRACE_EVENTS + 10; i++) {
+        TRACE_BEGIN("overflow");
+    }
+    return NULL;
+}
+
+// Tests that a thread keeps only its latest TRACE_EVENTS events
+void test_overflow() {
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, overflow_buffer, NULL) == 0);
+    pthread_join(thread, NULL);
+    assert(TRACE_WRITE(TRACE_PATH));
+    char *text = read_file(TRACE_PATH);
+    assert(count_matches(text, "\"name\":\"overflow\"") == TRACE_EVENTS);
+    free(text);
+    remove(TRACE_PATH);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_threads)
+    DO_TEST(test_overflow)
+
+    puts("trace_test PASS");
+}
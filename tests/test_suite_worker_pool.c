@@ -0,0 +1,189 @@
+#include "worker_pool.h"
+#include "test_util.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+// Adds 1 to each counter in the range, so each index should be visited once
+void count_visits(void *aux, size_t start, size_t end) {
+    int *visits = aux;
+    for (size_t i = start; i < end; i++) {
+        visits[i]++;
+    }
+}
+
+// Tests that every job visits each index exactly once,
+// with the same pool reused for many jobs of different sizes
+void test_run() {
+    const size_t THREADS[] = {1, 2, 3, 8};
+    const size_t MAX_COUNT = 100;
+    int visits[MAX_COUNT];
+    for (size_t p = 0; p < sizeof(THREADS) / sizeof(*THREADS); p++) {
+        worker_pool_t *pool = worker_pool_init(THREADS[p]);
+        assert(worker_pool_threads(pool) == THREADS[p]);
+        for (size_t count = 0; count <= MAX_COUNT; count++) {
+            for (size_t i = 0; i < MAX_COUNT; i++) {
+                visits[i] = 0;
+            }
+            worker_pool_run(pool, count_visits, visits, count);
+            for (size_t i = 0; i < MAX_COUNT; i++) {
+                assert(visits[i] == (i < count ? 1 : 0));
+            }
+        }
+        worker_pool_free(pool);
+    }
+}
+
+typedef struct client {
+    worker_pool_t *pool;
+    int *visits;
+    size_t count;
+    int jobs;
+} client_t;
+
+void *run_client(void *arg) {
+    client_t *client = arg;
+    for (int j = 0; j < client->jobs; j++) {
+        worker_pool_run(client->pool, count_visits, client->visits, \
+            client->count);
+    }
+    return NULL;
+}
+
+// Tests that threads sharing a pool can run jobs at the same time
+void test_shared() {
+    const size_t CLIENTS = 3;
+    const size_t COUNT = 1000;
+    const int JOBS = 200;
+    worker_pool_t *pool = worker_pool_init(4);
+    client_t clients[CLIENTS];
+    pthread_t ids[CLIENTS];
+    for (size_t c = 0; c < CLIENTS; c++) {
+        clients[c] = (client_t) {pool, calloc(COUNT, sizeof(int)), COUNT, JOBS};
+        assert(pthread_create(&ids[c], NULL, run_client, &clients[c]) == 0);
+    }
+    for (size_t c = 0; c < CLIENTS; c++) {
+        pthread_join(ids[c], NULL);
+        for (size_t i = 0; i < COUNT; i++) {
+            assert(clients[c].visits[i] == JOBS);
+        }
+        free(clients[c].visits);
+    }
+    worker_pool_free(pool);
+}
+
+typedef struct stage {
+    const int *input;
+    int *output;
+} stage_t;
+
+// Doubles each input, spinning for longer at higher indices
+void double_slowly(void *aux, size_t start, size_t end) {
+    stage_t *stage = aux;
+    for (size_t i = start; i < end; i++) {
+        volatile size_t spin = 0;
+        while (spin < i * 10) {
+            spin++;
+        }
+        stage->output[i] = 2 * stage->input[i];
+    }
+}
+
+// Tests that jobs start only after their dependencies are done,
+// even when the work per index is very uneven
+void test_dependencies() {
+    const size_t COUNT = 2000;
+    const size_t STAGES = 4;
+    int *values[STAGES + 1];
+    for (size_t s = 0; s <= STAGES; s++) {
+        values[s] = calloc(COUNT, sizeof(int));
+    }
+    for (size_t i = 0; i < COUNT; i++) {
+        values[0][i] = i;
+    }
+    stage_t stages[STAGES];
+    pool_job_t *jobs[STAGES];
+    worker_pool_t *pool = worker_pool_init(4);
+    // Each stage is usually submitted while the one before is still running
+    for (size_t s = 0; s < STAGES; s++) {
+        stages[s] = (stage_t) {values[s], values[s + 1]};
+        jobs[s] = worker_pool_submit(pool, double_slowly, &stages[s], COUNT, \
+            s > 0 ? &jobs[s - 1] : NULL, s > 0 ? 1 : 0);
+    }
+    for (size_t s = STAGES; s > 0; s--) {
+        worker_pool_wait(pool, jobs[s - 1]);
+    }
+    for (size_t i = 0; i < COUNT; i++) {
+        assert(values[STAGES][i] == (int) (i << STAGES));
+    }
+
+    // A job with several dependencies, one of which has no indices
+    for (size_t i = 0; i < COUNT; i++) {
+        values[1][i] = 0;
+    }
+    stage_t first = {values[0], values[1]};
+    stage_t second = {values[1], values[2]};
+    pool_job_t *deps[] = {
+        worker_pool_submit(pool, double_slowly, &first, COUNT, NULL, 0),
+        worker_pool_submit(pool, double_slowly, &first, 0, NULL, 0)
+    };
+    pool_job_t *last = worker_pool_submit(pool, double_slowly, &second, \
+        COUNT, deps, 2);
+    worker_pool_wait(pool, last);
+    worker_pool_wait(pool, deps[0]);
+    worker_pool_wait(pool, deps[1]);
+    for (size_t i = 0; i < COUNT; i++) {
+        assert(values[2][i] == (int) (4 * i));
+    }
+    worker_pool_free(pool);
+    for (size_t s = 0; s <= STAGES; s++) {
+        free(values[s]);
+    }
+}
+
+typedef struct nested {
+    worker_pool_t *pool;
+    int *visits;
+    size_t count;
+} nested_t;
+
+// Runs a job over a row of visits from inside a task
+void visit_rows(void *aux, size_t start, size_t end) {
+    nested_t *nested = aux;
+    for (size_t row = start; row < end; row++) {
+        worker_pool_run(nested->pool, count_visits, \
+            nested->visits + row * nested->count, nested->count);
+    }
+}
+
+// Tests that tasks can run jobs of their own on the same pool
+void test_nested() {
+    const size_t ROWS = 50;
+    const size_t COUNT = 300;
+    int *visits = calloc(ROWS * COUNT, sizeof(int));
+    worker_pool_t *pool = worker_pool_init(3);
+    nested_t nested = {pool, visits, COUNT};
+    worker_pool_run(pool, visit_rows, &nested, ROWS);
+    for (size_t i = 0; i < ROWS * COUNT; i++) {
+        assert(visits[i] == 1);
+    }
+    worker_pool_free(pool);
+    free(visits);
+}
+
+int main(int argc, char *argv[]) {
+    // Run all tests if there are no command-line arguments
+    bool all_tests = argc == 1;
+    // Read test name from file
+    char testname[100];
+    if (!all_tests) {
+        read_testname(argv[1], testname, sizeof(testname));
+    }
+
+    DO_TEST(test_run)
+    DO_TEST(test_shared)
+    DO_TEST(test_dependencies)
+    DO_TEST(test_nested)
+
+    puts("worker_pool_test PASS");
+}